@@ -0,0 +1,172 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.batch.cpp
+ * \brief Benchmarks of the batched lookup of config_set
+ *
+ * Compares looking up random present keys one by one with config_set::get, to looking them up in
+ * batches with config_set::get_many, for each key index.
+ * Also compares converting every entry of a set one by one, to converting them into a column with
+ * config_set::get_all_as.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "config_set.hpp"
+#include "confy_parser.hpp"
+#include "eytzinger_index.hpp"
+#include "perfect_hash_index.hpp"
+#include "sorted_index.hpp"
+#include "swiss_index.hpp"
+
+namespace {
+    /// The number of lookups measured per input
+    constexpr std::size_t lookups = 1 << 18;
+
+    /**
+     * \brief Measures an index
+     *
+     * Loads the file with the given index, then times looking up the probes with get, and with
+     * get_many in batches of the given sizes.
+     *
+     * \tparam I The key index to measure.
+     * \param what The name of the index
+     * \param file The configuration file
+     * \param keys The number of keys in the file
+     * \param probes The keys to look up
+     */
+    template<class I>
+    void
+    bench_index(const char* what,
+                const std::filesystem::path& file,
+                std::size_t keys,
+                const std::vector<std::string_view>& probes) {
+        config_set<confy_parser, I> cs(file);
+        char name[64];
+
+        std::size_t found = 0;
+        auto secs = best_of(3, [&] {
+            for (auto key : probes) found += cs.template get<std::string_view>(key).size();
+        });
+        std::snprintf(name, sizeof(name), "%s get", what);
+        bench_row(name, keys, secs, probes.size());
+
+        for (std::size_t batch : {16, 64, 256}) {
+            secs = best_of(3, [&] {
+                for (std::size_t first = 0; first < probes.size(); first += batch) {
+                    auto res = cs.template get_many<std::string_view>({probes.data() + first, batch});
+                    found += res[0].size() + res.all_found();
+                }
+            });
+            std::snprintf(name, sizeof(name), "%s get_many/%zu", what, batch);
+            bench_row(name, keys, secs, probes.size());
+        }
+        do_not_optimize(found);
+    }
+
+    /**
+     * \brief Measures converting every entry
+     *
+     * Converts every entry of a freshly loaded set to long long, by calling try_get with each key, and
+     * with get_all_as on one and on four threads.
+     * Only the conversions are timed, not the loads.
+     *
+     * \param file The configuration file
+     * \param keys The number of keys in the file
+     */
+    void
+    bench_column(const std::filesystem::path& file, std::size_t keys) {
+        std::vector<std::string> names;
+        names.reserve(keys);
+        for (std::size_t i = 0; i < keys; ++i) names.push_back(bench_key(i));
+
+        long long sum = 0;
+        auto fresh = [&file](auto&& fn) {
+            auto best = std::numeric_limits<double>::max();
+            for (int i = 0; i < 3; ++i) {
+                config_set<confy_parser> cs(file);
+                auto start = std::chrono::steady_clock::now();
+                fn(cs);
+                std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+                best = std::min(best, took.count());
+            }
+            return best;
+        };
+
+        bench_row("try_get each", keys, fresh([&](const config_set<confy_parser>& cs) {
+            for (const auto& name : names) sum += cs.try_get<long long>(name).value_or(0);
+        }));
+        for (unsigned threads : {1u, 4u}) {
+            char name[64];
+            std::snprintf(name, sizeof(name), "get_all_as/%u", threads);
+            bench_row(name, keys, fresh([&](const config_set<confy_parser>& cs) {
+                auto column = cs.get_all_as<long long>(threads);
+                sum += column[0] + static_cast<long long>(column.all_found());
+            }));
+        }
+        do_not_optimize(sum);
+    }
+}
+
+void
+bench_batch(std::size_t max_keys) {
+    std::printf("== batch (%zu random lookups of present keys) ==\n", lookups);
+    auto file = std::filesystem::temp_directory_path() / "confy-bench-batch.confy";
+
+    for (std::size_t keys = 10'000; keys <= max_keys; keys *= 10) {
+        bench_config(file, keys);
+
+        std::vector<std::string> names;
+        names.reserve(lookups);
+        std::mt19937_64 rng(keys);
+        std::uniform_int_distribution<std::size_t> dist(0, keys - 1);
+        for (std::size_t i = 0; i < lookups; ++i) names.push_back(bench_key(dist(rng)));
+        std::vector<std::string_view> probes(names.begin(), names.end());
+
+        bench_index<sorted_index>("sorted_index", file, keys, probes);
+        bench_index<eytzinger_index>("eytzinger_index", file, keys, probes);
+        bench_index<perfect_hash_index>("perfect_hash_index", file, keys, probes);
+        bench_index<swiss_index>("swiss_index", file, keys, probes);
+        bench_column(file, keys);
+    }
+    std::filesystem::remove(file);
+}
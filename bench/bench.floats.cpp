@@ -0,0 +1,157 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.floats.cpp
+ * \brief Benchmarks of loading and warming floating point entries
+ *
+ * Compares converting the floating point values of a configuration with the strto* functions and a
+ * cache allocation each, as the original factories did, to the allocation-free parse functions of
+ * the factories.
+ * Also compares loading the configuration and reading each of its entries once, which parses and
+ * caches them, to how the original layout did the same.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "bench.hpp"
+#include "cache_factory.hpp"
+#include "config_set.hpp"
+#include "confy_parser.hpp"
+
+namespace {
+    /**
+     * \brief Generates a configuration of floating point values
+     *
+     * Half of the values are short, like hand-written tuning parameters, the other half are
+     * printed with all 17 significant digits. The values are quoted, for the parser does not accept signs
+ * in bare values.
+     *
+     * \param file The file to write
+     * \param keys The number of keys
+     */
+    void
+    float_config(const std::filesystem::path& file, std::size_t keys) {
+        std::mt19937_64 rng(keys);
+        std::uniform_real_distribution<double> mantissa(-10.0, 10.0);
+        std::uniform_int_distribution<int> exponent(-8, 8);
+        std::ofstream ofs(file);
+        char buf[64];
+        for (std::size_t i = 0; i < keys; ++i) {
+            auto value = mantissa(rng) * std::pow(10.0, exponent(rng));
+            std::snprintf(buf, sizeof buf, i % 2 ? "%.17g" : "%.3g", value);
+            ofs << bench_key(i) << "=\"" << buf << "\"\n";
+        }
+    }
+
+    /**
+     * \brief Parses a value the way the original factories did
+     */
+    template<class T>
+    T
+    legacy_strto(const char* str) {
+        char* end;
+        if (std::is_same<T, float>::value) return static_cast<T>(std::strtof(str, &end));
+        if (std::is_same<T, double>::value) return static_cast<T>(std::strtod(str, &end));
+        return static_cast<T>(std::strtold(str, &end));
+    }
+
+    template<class T>
+    void
+    bench_type(const char* name, const std::filesystem::path& file,
+               const std::vector<std::string>& names, std::size_t keys) {
+        auto reps = reps_for(keys);
+        auto configs = load_legacy(file, false);
+        std::size_t sum = 0;
+
+        auto convert_before = best_of(reps, [&] {
+            for (auto& cfg : configs) {
+                auto value = legacy_strto<T>(cfg.value.c_str());
+                cfg.cached = std::make_unique<typename cache_factory<T>::cache_type>(std::move(value));
+            }
+        });
+        auto convert_after = best_of(reps, [&] {
+            cache_factory<T> factory;
+            for (const auto& cfg : configs) {
+                T value{};
+                sum += static_cast<std::size_t>(factory.parse(cfg.value, value) && value != T(0));
+            }
+        });
+        auto load_before = best_of(reps, [&] {
+            auto loaded = load_legacy(file, false);
+            for (auto& cfg : loaded) {
+                auto value = legacy_strto<T>(cfg.value.c_str());
+                cfg.cached = std::make_unique<typename cache_factory<T>::cache_type>(std::move(value));
+            }
+            sum += loaded.size();
+        });
+        auto load_after = best_of(reps, [&] {
+            config_set<confy_parser> cs(file);
+            for (const auto& key : names) sum += static_cast<std::size_t>(cs.get<T>(key) != T(0));
+        });
+        do_not_optimize(sum);
+
+        auto row = [keys](const char* what, const char* type, double secs) {
+            bench_row((std::string(what) + type).c_str(), keys, secs);
+        };
+        row("convert before: ", name, convert_before);
+        row("convert after: ", name, convert_after);
+        row("load+read before: ", name, load_before);
+        row("load+read after: ", name, load_after);
+    }
+}
+
+void
+bench_floats(std::size_t max_keys) {
+    std::printf("== floats (load and read every entry once) ==\n");
+    auto file = std::filesystem::temp_directory_path() / "confy-bench-floats.confy";
+
+    for (std::size_t keys = 1'000; keys <= max_keys; keys *= 10) {
+        float_config(file, keys);
+        std::vector<std::string> names;
+        for (std::size_t i = 0; i < keys; ++i) names.push_back(bench_key(i));
+
+        bench_type<float>("float", file, names, keys);
+        bench_type<double>("double", file, names, keys);
+        bench_type<long double>("long double", file, names, keys);
+    }
+    std::filesystem::remove(file);
+}
@@ -0,0 +1,91 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.handle.cpp
+ * \brief Benchmarks of reading values through resolved handles
+ *
+ * Compares reading the same few keys over and over with config_set::get, which searches the key and
+ * visits the cache on every read, to reading them through handles returned by config_set::resolve.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "config_handle.hpp"
+#include "config_set.hpp"
+#include "confy_parser.hpp"
+
+namespace {
+    /// The number of hot keys read
+    constexpr std::size_t hot_keys = 8;
+    /// The number of reads measured per input
+    constexpr std::size_t reads = 1 << 22;
+}
+
+void
+bench_handle(std::size_t max_keys) {
+    std::printf("== handle (%zu reads of %zu hot integer keys) ==\n", reads, hot_keys);
+    auto file = std::filesystem::temp_directory_path() / "confy-bench-handle.confy";
+
+    for (std::size_t keys = 1'000; keys <= max_keys; keys *= 10) {
+        bench_config(file, keys);
+        config_set<confy_parser> cs(file);
+
+        // bench_config writes integer values for every third key
+        std::vector<std::string> names;
+        for (std::size_t i = 0; i < hot_keys; ++i) names.push_back(bench_key(i * keys / hot_keys / 3 * 3));
+        std::vector<config_handle<long long>> handles;
+        for (const auto& name : names) handles.push_back(cs.resolve<long long>(name));
+
+        long long sum = 0;
+        auto secs = best_of(3, [&] {
+            for (std::size_t i = 0; i < reads; ++i) sum += cs.get<long long>(names[i % hot_keys]);
+        });
+        bench_row("get", keys, secs, reads);
+
+        secs = best_of(3, [&] {
+            for (std::size_t i = 0; i < reads; ++i) sum += cs.get(handles[i % hot_keys]);
+        });
+        bench_row("get(handle)", keys, secs, reads);
+
+        secs = best_of(3, [&] {
+            for (std::size_t i = 0; i < reads; ++i) sum += *handles[i % hot_keys];
+        });
+        bench_row("*handle", keys, secs, reads);
+        do_not_optimize(sum);
+    }
+    std::filesystem::remove(file);
+}
@@ -0,0 +1,214 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.hpp
+ * \brief Helpers shared by the benchmarks
+ *
+ * Defines the timing and input generating helpers used by the benchmark executable.
+ */
+
+#ifndef CONFY_BENCH_HPP
+#define CONFY_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "caches.hpp"
+#include "confy_parser.hpp"
+
+/**
+ * \brief Measures the best wall clock time of a function
+ *
+ * Runs the function the given number of times and returns the fastest run.
+ *
+ * \tparam Fn The type of the function to measure.
+ * \param reps The number of runs
+ * \param fn The function to measure
+ * \return The time of the fastest run in seconds
+ */
+template<class Fn>
+double
+best_of(int reps, Fn&& fn) {
+    auto best = std::numeric_limits<double>::max();
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+        best = std::min(best, took.count());
+    }
+    return best;
+}
+
+/**
+ * \brief Chooses the repetition count for an input size
+ *
+ * Small inputs are repeated more times to get stable measurements.
+ *
+ * \param keys The number of keys in the input
+ * \return The number of repetitions
+ */
+inline int
+reps_for(std::size_t keys) {
+    if (keys <= 10'000) return 20;
+    if (keys <= 1'000'000) return 5;
+    return 1;
+}
+
+/**
+ * \brief Creates the key of the given index
+ *
+ * \param idx The index of the key
+ * \return The key
+ */
+inline std::string
+bench_key(std::size_t idx) {
+    return "key" + std::to_string(idx);
+}
+
+/**
+ * \brief Generates a configuration file for benchmarking
+ *
+ * Writes the given number of unique keys in shuffled order, with values cycling through integers,
+ * bare words, and quoted strings.
+ *
+ * \param file The file to write
+ * \param keys The number of keys
+ * \return The file path
+ */
+inline std::filesystem::path
+bench_config(const std::filesystem::path& file, std::size_t keys) {
+    std::vector<std::size_t> order(keys);
+    for (std::size_t i = 0; i < keys; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(keys));
+
+    std::ofstream ofs(file);
+    for (auto idx : order) {
+        ofs << bench_key(idx) << '=';
+        switch (idx % 3) {
+        case 0: ofs << idx; break;
+        case 1: ofs << "word" << idx; break;
+        default: ofs << "\"quoted value " << idx << '"'; break;
+        }
+        ofs << '\n';
+    }
+    return file;
+}
+
+/**
+ * \brief Prints one row of a benchmark table
+ *
+ * A negative time is printed as skipped.
+ *
+ * \param what The name of the measured case
+ * \param keys The number of keys
+ * \param secs The measured time in seconds
+ * \param ops The number of operations measured, the number of keys if zero
+ */
+inline void
+bench_row(const char* what, std::size_t keys, double secs, std::size_t ops = 0) {
+    if (ops == 0) ops = keys;
+    if (secs < 0) {
+        std::printf("%-28s %10zu %14s\n", what, keys, "skipped");
+    } else {
+        std::printf("%-28s %10zu %11.3f ms %8.1f ns/op\n", what, keys, secs * 1e3, secs * 1e9 / static_cast<double>(ops));
+    }
+}
+
+/**
+ * \brief The original layout of a config entry
+ *
+ * Replicates how config used to store an entry: owned copies of the key and the value, and the cache.
+ */
+struct legacy_config {
+    std::string name;             ///< The key of the entry
+    std::string value;            ///< The value of the entry
+    std::unique_ptr<cache> cached; ///< The cache of the entry
+};
+
+/**
+ * \brief Loads a file into the original layout
+ *
+ * Replicates how config_set used to load a file: every line is read and parsed into copied strings,
+ * then either inserted into its sorted place, shifting all later entries, or appended and sorted
+ * once at the end.
+ *
+ * \param file The file to load
+ * \param insertion Whether to insert the lines one by one
+ * \return The loaded entries
+ */
+inline std::vector<legacy_config>
+load_legacy(const std::filesystem::path& file, bool insertion) {
+    std::vector<legacy_config> configs;
+    std::ifstream ifs(file);
+    confy_parser parse(file);
+    auto by_name = [](const legacy_config& lhs, const legacy_config& rhs) {
+        return lhs.name < rhs.name;
+    };
+    std::optional<std::string> maybe_next_ln;
+    while ((maybe_next_ln = parse.next_line(ifs))) {
+        auto conf = parse.parse_line(maybe_next_ln.value());
+        legacy_config cfg{std::move(conf.first), std::move(conf.second), nullptr};
+        if (insertion) {
+            configs.insert(std::lower_bound(configs.begin(), configs.end(), cfg, by_name), std::move(cfg));
+        } else {
+            configs.push_back(std::move(cfg));
+        }
+    }
+    if (!insertion) std::sort(configs.begin(), configs.end(), by_name);
+    return configs;
+}
+
+/// The sink of do_not_optimize
+inline volatile std::size_t bench_sink = 0;
+
+/**
+ * \brief Keeps a value from being optimized away
+ *
+ * \param value The value to keep
+ */
+inline void
+do_not_optimize(std::size_t value) {
+    bench_sink = value;
+}
+
+#endif
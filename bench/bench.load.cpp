@@ -0,0 +1,84 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.load.cpp
+ * \brief Benchmarks of loading a configuration file
+ *
+ * Compares building the set by sorted insertion of each parsed line, as config_set used to, to the
+ * bulk sorting construction, on one and on multiple threads, to loading with lazily parsed values,
+ * and to opening a compiled image of the same file.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+#include "bench.hpp"
+#include "config_set.hpp"
+#include "confy_parser.hpp"
+
+namespace {
+    /// The largest input the quadratic sorted insertion is run on
+    constexpr std::size_t insertion_limit = 100'000;
+}
+
+void
+bench_load(std::size_t max_keys) {
+    auto threads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("== load (%u threads available) ==\n", threads);
+
+    auto file = std::filesystem::temp_directory_path() / "confy-bench-load.confy";
+    auto image = std::filesystem::temp_directory_path() / "confy-bench-load.confyb";
+    for (std::size_t keys = 1'000; keys <= max_keys; keys *= 10) {
+        bench_config(file, keys);
+        auto reps = reps_for(keys);
+
+        auto before = keys <= insertion_limit
+                             ? best_of(reps, [&file] { load_legacy(file, true); })
+                             : -1.0;
+        auto after = best_of(reps, [&file] { config_set<confy_parser> set(file); });
+        auto parallel = best_of(reps, [&file, threads] { config_set<confy_parser> set(file, threads); });
+        auto lazy = best_of(reps, [&file] { config_set<confy_parser> set(lazy_values, file); });
+        config_set<confy_parser>(file).compile(image);
+        auto compiled = best_of(reps, [&image] { config_set<confy_parser> set(compiled_image, image); });
+
+        bench_row("before: sorted insertion", keys, before);
+        bench_row("after: bulk sort", keys, after);
+        bench_row("after: bulk sort, threaded", keys, parallel);
+        bench_row("after: lazy values", keys, lazy);
+        bench_row("after: compiled image", keys, compiled);
+    }
+    std::filesystem::remove(file);
+    std::filesystem::remove(image);
+}
@@ -0,0 +1,140 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.lookup.cpp
+ * \brief Benchmarks of looking up keys in the key indices
+ *
+ * Compares the key indices config_set may use: the lookup latency of present (hit) and absent (miss)
+ * keys, and the memory each index uses per key on top of the entries.
+ * The indices are measured directly, without the exception config_set::get throws on a miss.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "eytzinger_index.hpp"
+#include "perfect_hash_index.hpp"
+#include "sorted_index.hpp"
+#include "swiss_index.hpp"
+
+namespace {
+    /// The number of lookups measured per input
+    constexpr std::size_t lookups = 1'000'000;
+
+    /**
+     * \brief Creates the keys to look up
+     *
+     * \param keys The number of keys in the set
+     * \param absent Whether to create keys missing from the set
+     * \return The keys in random order
+     */
+    std::vector<std::string>
+    probe_keys(std::size_t keys, bool absent) {
+        std::mt19937_64 rng(keys);
+        std::uniform_int_distribution<std::size_t> dist(0, keys - 1);
+        std::vector<std::string> probes;
+        probes.reserve(lookups);
+        for (std::size_t i = 0; i < lookups; ++i) {
+            probes.push_back(bench_key(dist(rng) + (absent ? keys : 0)));
+        }
+        return probes;
+    }
+
+    /**
+     * \brief Measures an index
+     *
+     * Builds the index over the sorted keys, stores the keys in the order the index asks for, then
+     * times looking up the hit and the miss probes.
+     *
+     * \tparam I The key index to measure.
+     * \param what The name of the index
+     * \param sorted The sorted keys
+     * \param hits The present keys to look up
+     * \param misses The absent keys to look up
+     */
+    template<class I>
+    void
+    bench_index(const char* what,
+                const std::vector<std::string>& sorted,
+                const std::vector<std::string>& hits,
+                const std::vector<std::string>& misses) {
+        I index;
+        auto order = index.build(sorted.size(), [&sorted](std::size_t idx) {
+            return std::string_view(sorted[idx]);
+        });
+        std::vector<std::string_view> stored(sorted.begin(), sorted.end());
+        if (!order.empty()) {
+            for (std::size_t i = 0; i < order.size(); ++i) stored[i] = sorted[order[i]];
+        }
+        auto key_at = [&stored](std::size_t idx) { return stored[idx]; };
+
+        auto time = [&index, &key_at](const std::vector<std::string>& probes) {
+            std::size_t found = 0;
+            auto secs = best_of(3, [&] {
+                for (const auto& key : probes) found += index.find(key, key_at);
+            });
+            do_not_optimize(found);
+            return secs * 1e9 / static_cast<double>(probes.size());
+        };
+        auto hit = time(hits);
+        auto miss = time(misses);
+        std::printf("%-20s %10zu %10.1f ns %10.1f ns %10.2f B/key\n",
+                    what, sorted.size(), hit, miss,
+                    static_cast<double>(index.memory_usage()) / static_cast<double>(sorted.size()));
+    }
+}
+
+void
+bench_lookup(std::size_t max_keys) {
+    std::printf("== lookup (%zu random lookups, latency per lookup) ==\n", lookups);
+    std::printf("%-20s %10s %13s %13s %15s\n", "index", "keys", "hit", "miss", "memory");
+
+    for (std::size_t keys = 1'000; keys <= max_keys; keys *= 10) {
+        std::vector<std::string> sorted;
+        sorted.reserve(keys);
+        for (std::size_t i = 0; i < keys; ++i) sorted.push_back(bench_key(i));
+        std::sort(sorted.begin(), sorted.end());
+        auto hits = probe_keys(keys, false);
+        auto misses = probe_keys(keys, true);
+
+        bench_index<sorted_index>("sorted_index", sorted, hits, misses);
+        bench_index<eytzinger_index>("eytzinger_index", sorted, hits, misses);
+        bench_index<perfect_hash_index>("perfect_hash_index", sorted, hits, misses);
+        bench_index<swiss_index>("swiss_index", sorted, hits, misses);
+    }
+}
@@ -0,0 +1,106 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.memory.cpp
+ * \brief Benchmarks of the memory used by a loaded configuration
+ *
+ * Compares the heap memory held by the original layout of the entries, with owned strings, to the
+ * arena based layout of config_set.
+ * Heap usage is read from the allocator, so this benchmark is only available with glibc.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#  define CONFY_BENCH_MALLINFO
+#  include <malloc.h>
+#endif
+
+#include "bench.hpp"
+#include "config_set.hpp"
+#include "confy_parser.hpp"
+
+#ifdef CONFY_BENCH_MALLINFO
+namespace {
+    /**
+     * \brief Returns the number of heap bytes in use
+     *
+     * \return The bytes allocated from the heap, including large, mapped allocations.
+     */
+    std::size_t
+    heap_in_use() {
+        auto info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+    }
+
+    void
+    memory_row(const char* what, std::size_t keys, std::size_t bytes) {
+        std::printf("%-36s %10zu %12.2f MiB %8.1f B/key\n",
+                    what, keys, static_cast<double>(bytes) / (1 << 20),
+                    static_cast<double>(bytes) / static_cast<double>(keys));
+    }
+}
+#endif
+
+void
+bench_memory(std::size_t max_keys) {
+    std::printf("== memory ==\n");
+#ifdef CONFY_BENCH_MALLINFO
+    auto file = std::filesystem::temp_directory_path() / "confy-bench-memory.confy";
+    for (std::size_t keys = 1'000; keys <= max_keys; keys *= 10) {
+        bench_config(file, keys);
+        auto file_size = static_cast<std::size_t>(std::filesystem::file_size(file));
+
+        std::size_t before;
+        {
+            auto start = heap_in_use();
+            auto configs = load_legacy(file, false);
+            before = heap_in_use() - start;
+        }
+        std::size_t after;
+        {
+            auto start = heap_in_use();
+            config_set<confy_parser> set(file);
+            after = heap_in_use() - start;
+        }
+
+        memory_row("before: owned strings", keys, before);
+        memory_row("after: arena (heap)", keys, after);
+        memory_row("after: arena (heap + mapped file)", keys, after + file_size);
+    }
+    std::filesystem::remove(file);
+#else
+    std::printf("skipped: heap usage is only available with glibc\n");
+#endif
+}
@@ -0,0 +1,145 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.reload.cpp
+ * \brief Benchmarks of reloading a changed configuration file
+ *
+ * Compares rebuilding every conversion after a reload, as replacing a config_set used to require,
+ * to carrying the caches of the unchanged entries over from the replaced set, after a handful of
+ * values were edited.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "config_set.hpp"
+#include "confy_parser.hpp"
+#include "source_buffer.hpp"
+
+namespace {
+    /// The number of values edited between the loads
+    constexpr std::size_t edits = 5;
+
+    /**
+     * \brief Writes a copy of a configuration file with a few values edited
+     *
+     * \param from The file to copy
+     * \param to The file to write
+     */
+    void
+    edit_config(const std::filesystem::path& from, const std::filesystem::path& to) {
+        std::ifstream ifs(from);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(ifs, line);) lines.push_back(line);
+
+        std::ofstream ofs(to);
+        for (std::size_t i = 0; i < lines.size(); ++i) {
+            if (i % (lines.size() / edits + 1) == 0) {
+                ofs << lines[i].substr(0, lines[i].find('=')) << "=edited\n";
+            } else {
+                ofs << lines[i] << '\n';
+            }
+        }
+    }
+
+    /**
+     * \brief Converts every value of a set to a string, filling the caches
+     *
+     * \param cs The set to convert
+     * \return The total length of the values
+     */
+    std::size_t
+    convert_all(const config_set<confy_parser>& cs) {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < cs.size(); ++i) total += cs.get<std::string>(cs.key_at(i)).size();
+        return total;
+    }
+
+    /**
+     * \brief Measures the time of a function in seconds
+     */
+    template<class Fn>
+    double
+    time_of(Fn&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+        return took.count();
+    }
+}
+
+void
+bench_reload(std::size_t max_keys) {
+    std::printf("== reload (%zu values edited, all values read as strings) ==\n", edits);
+    auto file = std::filesystem::temp_directory_path() / "confy-bench-reload.confy";
+    auto edited = std::filesystem::temp_directory_path() / "confy-bench-reload-edited.confy";
+
+    for (std::size_t keys = 1'000; keys <= max_keys; keys *= 10) {
+        bench_config(file, keys);
+        edit_config(file, edited);
+        auto reps = reps_for(keys);
+
+        auto parse = best_of(reps, [&edited] { config_set<confy_parser> next(source_buffer::read(edited), edited); });
+
+        auto rebuild = -1.0;
+        auto carry = -1.0;
+        auto reconvert = -1.0;
+        std::size_t sum = 0;
+        for (int i = 0; i < reps; ++i) {
+            config_set<confy_parser> previous(file);
+            sum += convert_all(previous);
+            config_set<confy_parser> fresh(edited);
+            config_set<confy_parser> next(edited);
+
+            auto secs = time_of([&] { sum += convert_all(fresh); });
+            if (rebuild < 0 || secs < rebuild) rebuild = secs;
+            secs = time_of([&] { next.carry_over(previous); });
+            if (carry < 0 || secs < carry) carry = secs;
+            secs = time_of([&] { sum += convert_all(next); });
+            if (reconvert < 0 || secs < reconvert) reconvert = secs;
+        }
+        do_not_optimize(sum);
+
+        bench_row("reload: parse (background)", keys, parse);
+        bench_row("before: convert all", keys, rebuild);
+        bench_row("after: carry over", keys, carry);
+        bench_row("after: convert all", keys, reconvert);
+    }
+    std::filesystem::remove(file);
+    std::filesystem::remove(edited);
+}
@@ -0,0 +1,204 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.snapshot.cpp
+ * \brief Benchmarks of reading a configuration shared between threads
+ *
+ * Compares readers sharing a configuration through a mutex guarding its owner, through a load of
+ * the atomic shared pointer of config_snapshots per read, and through config_snapshots readers,
+ * with 1 to 64 reader threads, while a writer publishes a reloaded version every second.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "config_set.hpp"
+#include "config_snapshots.hpp"
+#include "confy_parser.hpp"
+#include "source_buffer.hpp"
+
+namespace {
+    using confy_set = config_set<confy_parser>;
+
+    /// The most keys loaded
+    constexpr std::size_t max_snapshot_keys = 100'000;
+    /// The period of the reloads
+    constexpr auto reload_period = std::chrono::seconds(1);
+    /// How long the readers run for each case, covering two reloads
+    constexpr auto run_time = std::chrono::milliseconds(2'500);
+
+    /**
+     * \brief The shared owner of the current set, guarded by a mutex
+     *
+     * How a set is shared without config_snapshots: every read copies the owner under the lock.
+     */
+    struct locked_owner {
+        std::shared_ptr<const confy_set>
+        current() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return set;
+        }
+
+        void
+        publish(std::unique_ptr<confy_set> next) {
+            std::shared_ptr<const confy_set> shared(std::move(next));
+            std::lock_guard<std::mutex> lock(mutex);
+            set = std::move(shared);
+        }
+
+        mutable std::mutex mutex;
+        std::shared_ptr<const confy_set> set;
+    };
+
+    /**
+     * \brief Runs readers against a writer reloading the file every reload_period
+     *
+     * \tparam Publish The type of the function publishing a reloaded set.
+     * \tparam Read The type of the function run by each reader, returning its number of reads.
+     * \param file The configuration file reloaded by the writer
+     * \param readers The number of reader threads
+     * \param publish The function publishing a set
+     * \param read The function of a reader, called with the flag telling it to stop
+     * \return The total number of reads
+     */
+    template<class Publish, class Read>
+    std::size_t
+    contend(const std::filesystem::path& file, std::size_t readers, Publish&& publish, Read&& read) {
+        std::atomic<bool> stop{false};
+        std::atomic<std::size_t> total{0};
+        std::mutex mutex;
+        std::condition_variable stopped;
+
+        std::thread writer([&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopped.wait_for(lock, reload_period, [&stop] { return stop.load(); })) {
+                publish(std::make_unique<confy_set>(source_buffer::read(file), file));
+            }
+        });
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < readers; ++i) {
+            threads.emplace_back([&read, &stop, &total, i] { total += read(stop, i); });
+        }
+        std::this_thread::sleep_for(run_time);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        stopped.notify_all();
+        for (auto& thread : threads) thread.join();
+        writer.join();
+        return total;
+    }
+
+    /**
+     * \brief Reads integer keys of a set in a loop
+     *
+     * \tparam Current The type of the function returning the set to read.
+     * \param stop The flag telling the reader to stop
+     * \param first The index of the first key to read
+     * \param keys The number of keys in the set
+     * \param current The function returning the set to read
+     * \return The number of reads
+     */
+    template<class Current>
+    std::size_t
+    read_loop(const std::atomic<bool>& stop, std::size_t first, std::size_t keys, Current&& current) {
+        // bench_config writes integer values for every third key
+        std::vector<std::string> names;
+        for (std::size_t i = 0; i < 64; ++i) names.push_back(bench_key((first * 997 + i * 7919) % keys / 3 * 3));
+
+        std::size_t reads = 0;
+        long long sum = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            for (const auto& name : names) sum += *current().template read<long long>(name);
+            reads += names.size();
+        }
+        do_not_optimize(static_cast<std::size_t>(sum));
+        return reads;
+    }
+}
+
+void
+bench_snapshot(std::size_t max_keys) {
+    auto keys = std::min(max_keys, max_snapshot_keys);
+    std::printf("== snapshot (%zu keys, one reload per second; second column is reader threads, time per read of all readers) ==\n", keys);
+    auto file = bench_config(std::filesystem::temp_directory_path() / "confy-bench-snapshot.confy", keys);
+    auto secs = std::chrono::duration<double>(run_time).count();
+
+    for (std::size_t readers = 1; readers <= 64; readers *= 2) {
+        locked_owner locked;
+        locked.publish(std::make_unique<confy_set>(file));
+        auto reads = contend(file, readers, [&locked](std::unique_ptr<confy_set> next) {
+            locked.publish(std::move(next));
+        }, [&locked, keys](const std::atomic<bool>& stop, std::size_t i) {
+            return read_loop(stop, i, keys, [&locked]() -> const confy_set& {
+                // the copy keeps the set alive until the read is done
+                thread_local std::shared_ptr<const confy_set> held;
+                held = locked.current();
+                return *held;
+            });
+        });
+        bench_row("before: mutex per read", readers, secs, reads);
+
+        config_snapshots<confy_parser> snapshots(std::make_unique<confy_set>(file));
+        auto publish = [&snapshots](std::unique_ptr<confy_set> next) {
+            snapshots.publish(std::move(next));
+        };
+        reads = contend(file, readers, publish, [&snapshots, keys](const std::atomic<bool>& stop, std::size_t i) {
+            return read_loop(stop, i, keys, [&snapshots]() -> const config_snapshots<confy_parser>::snapshot& {
+                thread_local std::optional<config_snapshots<confy_parser>::snapshot> held;
+                held = snapshots.current();
+                return *held;
+            });
+        });
+        bench_row("after: atomic load per read", readers, secs, reads);
+
+        reads = contend(file, readers, publish, [&snapshots, keys](const std::atomic<bool>& stop, std::size_t i) {
+            config_snapshots<confy_parser>::reader rd(snapshots);
+            return read_loop(stop, i, keys, [&rd]() -> decltype(auto) { return rd.current(); });
+        });
+        bench_row("after: snapshot reader", readers, secs, reads);
+    }
+    std::filesystem::remove(file);
+}
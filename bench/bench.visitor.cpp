@@ -0,0 +1,154 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench.visitor.cpp
+ * \brief Benchmarks of visitor dispatch
+ *
+ * Compares visiting caches through the dispatch tables of the current visitors to visiting the same
+ * caches through the visitor hierarchy of the first releases, kept in baseline_visitor.hpp, which
+ * searches the types of the visitor linearly behind a virtual base.
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "baseline_visitor.hpp"
+#include "bench.hpp"
+#include "cache_factory.hpp"
+#include "caches.hpp"
+#include "visitor.hpp"
+
+namespace {
+    /// The number of rounds over all caches measured
+    constexpr std::size_t rounds = 1 << 20;
+
+    template<template<class...> class V, class... Ts>
+    struct counting_base : V<Ts...> {
+        std::size_t hits = 0;
+    };
+
+    template<class Base, class... Ts>
+    struct counting_layers;
+
+    template<class Base>
+    struct counting_layers<Base> : Base { };
+
+    template<class Base, class T, class... Rem>
+    struct counting_layers<Base, T, Rem...> : counting_layers<Base, Rem...> {
+        void
+        do_visit(T&) final { ++this->hits; }
+    };
+
+    /// A visitor counting its visits of Ts
+    template<class... Ts>
+    using counting_visitor = counting_layers<counting_base<visitor, Ts...>, Ts...>;
+
+    /// A visitor of the baseline hierarchy counting its visits of Ts
+    template<class... Ts>
+    using baseline_counting_visitor = counting_layers<counting_base<baseline_visitor, Ts...>, Ts...>;
+
+    template<class C>
+    C
+    make_cache() {
+        using value_type = std::remove_const_t<std::remove_pointer_t<decltype(std::declval<C&>().get_value_ptr())>>;
+        return C(value_type{});
+    }
+
+    /// A cache of the baseline hierarchy holding a value of the same type as C
+    template<class C>
+    struct baseline_value_cache : baseline_visitable_cache<baseline_value_cache<C>> {
+        baseline_value_cache() : _cache(make_cache<C>()) { }
+
+    private:
+        C _cache;
+    };
+
+    /**
+     * \brief Times visiting caches of the given types through both hierarchies
+     *
+     * \tparam Cs The cache types to visit
+     */
+    template<class... Cs>
+    void
+    time_dispatch() {
+        std::tuple<Cs...> objs(make_cache<Cs>()...);
+        std::tuple<baseline_value_cache<Cs>...> baseline_objs;
+        std::array<cache*, sizeof...(Cs)> caches{&std::get<Cs>(objs)...};
+        std::array<baseline_cache*, sizeof...(Cs)> baseline_caches{&std::get<baseline_value_cache<Cs>>(baseline_objs)...};
+        counting_visitor<Cs...> vtor;
+        baseline_counting_visitor<baseline_value_cache<Cs>...> baseline_vtor;
+
+        auto secs = best_of(3, [&] {
+            for (std::size_t i = 0; i < rounds; ++i) {
+                for (auto c : baseline_caches) c->accept(baseline_vtor);
+            }
+        });
+        bench_row("before: linear try_visit", sizeof...(Cs), secs, rounds * sizeof...(Cs));
+
+        secs = best_of(3, [&] {
+            for (std::size_t i = 0; i < rounds; ++i) {
+                for (auto c : caches) c->accept(vtor);
+            }
+        });
+        bench_row("after: dispatch table", sizeof...(Cs), secs, rounds * sizeof...(Cs));
+        do_not_optimize(vtor.hits + baseline_vtor.hits);
+    }
+}
+
+void
+bench_visitor(std::size_t) {
+    std::printf("== visitor (%zu rounds; second column is visited types) ==\n", rounds);
+    time_dispatch<typename cache_factory<int>::cache_type>();
+    time_dispatch<typename cache_factory<int>::cache_type,
+                  typename cache_factory<long>::cache_type,
+                  typename cache_factory<double>::cache_type,
+                  typename cache_factory<bool>::cache_type>();
+    time_dispatch<typename cache_factory<signed char>::cache_type,
+                  typename cache_factory<unsigned char>::cache_type,
+                  typename cache_factory<char>::cache_type,
+                  typename cache_factory<short>::cache_type,
+                  typename cache_factory<unsigned short>::cache_type,
+                  typename cache_factory<int>::cache_type,
+                  typename cache_factory<unsigned>::cache_type,
+                  typename cache_factory<long>::cache_type,
+                  typename cache_factory<unsigned long>::cache_type,
+                  typename cache_factory<long long>::cache_type,
+                  typename cache_factory<unsigned long long>::cache_type,
+                  typename cache_factory<bool>::cache_type,
+                  typename cache_factory<float>::cache_type,
+                  typename cache_factory<double>::cache_type,
+                  typename cache_factory<long double>::cache_type>();
+}
@@ -0,0 +1,139 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bench_main.cpp
+ * \brief The benchmark entry point
+ *
+ * Runs the benchmarks, with inputs up to the key count given as the first argument.
+ * If more arguments are given, only the benchmarks named by them are run.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * \brief Configuration loading benchmarks
+ *
+ * \param max_keys The largest input to use
+ */
+void
+bench_load(std::size_t max_keys);
+
+/**
+ * \brief Key lookup benchmarks
+ *
+ * \param max_keys The largest input to use
+ */
+void
+bench_lookup(std::size_t max_keys);
+
+/**
+ * \brief Batched lookup benchmarks
+ *
+ * \param max_keys The largest input to use
+ */
+void
+bench_batch(std::size_t max_keys);
+
+/**
+ * \brief Resolved handle benchmarks
+ *
+ * \param max_keys The largest input to use
+ */
+void
+bench_handle(std::size_t max_keys);
+
+/**
+ * \brief Floating point loading benchmarks
+ *
+ * \param max_keys The largest input to use
+ */
+void
+bench_floats(std::size_t max_keys);
+
+/**
+ * \brief Reload benchmarks
+ *
+ * \param max_keys The largest input to use
+ */
+void
+bench_reload(std::size_t max_keys);
+
+/**
+ * \brief Shared snapshot benchmarks
+ *
+ * \param max_keys The largest input to use
+ */
+void
+bench_snapshot(std::size_t max_keys);
+
+/**
+ * \brief Visitor dispatch benchmarks
+ *
+ * \param max_keys The largest input to use, unused, as the visits need no input
+ */
+void
+bench_visitor(std::size_t max_keys);
+
+/**
+ * \brief Memory usage benchmarks
+ *
+ * \param max_keys The largest input to use
+ */
+void
+bench_memory(std::size_t max_keys);
+
+int
+main(int argc, char** argv) {
+    std::size_t max_keys = 10'000'000;
+    if (argc > 1) max_keys = std::strtoull(argv[1], nullptr, 10);
+
+    auto selected = [argc, argv](const char* name) {
+        if (argc <= 2) return true;
+        for (int i = 2; i < argc; ++i) {
+            if (std::strcmp(argv[i], name) == 0) return true;
+        }
+        return false;
+    };
+    if (selected("load")) bench_load(max_keys);
+    if (selected("lookup")) bench_lookup(max_keys);
+    if (selected("batch")) bench_batch(max_keys);
+    if (selected("handle")) bench_handle(max_keys);
+    if (selected("floats")) bench_floats(max_keys);
+    if (selected("reload")) bench_reload(max_keys);
+    if (selected("snapshot")) bench_snapshot(max_keys);
+    if (selected("visitor")) bench_visitor(max_keys);
+    if (selected("memory")) bench_memory(max_keys);
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file bare_hex.hpp
+ * \brief Defines the bare_hex type for reading unprefixed hexadecimal values
+ *
+ * Values like the `RRGGBB` colors are stored as hexadecimal digits without a prefix, which the
+ * integer types read as decimal numbers.
+ * Requesting them as bare_hex<T> reads them as hexadecimal, caching the decoded value:
+ *
+ * \code
+ * std::uint32_t red = cs.get<bare_hex<std::uint32_t>>("red1");
+ * \endcode
+ */
+
+#ifndef CONFY_BARE_HEX_HPP
+#define CONFY_BARE_HEX_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <memory>
+#include <utility>
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <string_view>
+#endif
+
+#include "cache_factory.hpp"
+#include "caches.hpp"
+#include "parse_number.hpp"
+
+/**
+ * \brief An integer stored as bare hexadecimal digits
+ *
+ * Opt-in accessor type: getting a value as bare_hex<T> parses it as unprefixed hexadecimal.
+ * Converts implicitly to T.
+ *
+ * \tparam T The integral type of the value.
+ */
+template<class T>
+struct bare_hex {
+    T value; ///< The decoded value
+
+    /**
+     * \brief Converts to the decoded value
+     *
+     * \return The decoded value.
+     */
+    operator T() const noexcept { return value; }
+};
+
+/**
+ * \brief Bare hexadecimal value cache
+ *
+ * This cache type is responsible for caching a bare_hex<T> typed value.
+ *
+ * \tparam T The integral type of the value.
+ */
+template<class T>
+struct bare_hex_cache : visitable_cache<bare_hex_cache<T>> {
+    /**
+     * \brief Cache constructor
+     *
+     * Constructs a cache object from the value it is meant to store.
+     *
+     * \param data The value to store in the cache. Moved.
+     */
+    explicit bare_hex_cache(bare_hex<T>&& data) noexcept : _data(std::move(data)) { }
+
+    /**
+     * \brief Cache getter
+     *
+     * Returns a const pointer to the stored value in the cache.
+     *
+     * \return The stored value.
+     */
+    const bare_hex<T>*
+    get_value_ptr() const { return &_data; }
+
+private:
+    bare_hex<T> _data;
+};
+
+/**
+ * \brief Caching specialization for constructing bare_hex<T> type objects.
+ *
+ * This specialization implements the caching interface for cache_factory<>.
+ * Parses the passed-in string as hexadecimal and constructs the new object.
+ *
+ * \tparam T The integral type of the value.
+ */
+template<class T>
+struct cache_factory<bare_hex<T>> {
+    /**
+     * \brief The cache type constructed.
+     *
+     * When calling the construct member function, this is the concrete type of the cache returned.
+     */
+    using cache_type = bare_hex_cache<T>;
+
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested
+     * `bare_hex<T>` type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, bare_hex<T>& out) const noexcept {
+        return parse_hex(data, out.value);
+    }
+
+    /**
+     * \brief The parser and type constructor function.
+     *
+     * This function is used to construct an object of the requested `bare_hex<T>` type.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
+     */
+    std::unique_ptr<cache>
+    construct(std::string_view data) {
+        bare_hex<T> value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
+    }
+};
+
+#endif
@@ -0,0 +1,237 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file batch_result.hpp
+ * \brief Defines the batch_result type
+ *
+ * This file defines the batch_result class, the result of looking up many keys of a config_set at
+ * once, or of converting all of its entries, and the key_batch_t type the keys are passed as.
+ */
+
+#ifndef CONFY_BATCH_RESULT_HPP
+#define CONFY_BATCH_RESULT_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <span>
+#  include <string_view>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifdef USE_CXX17
+using key_batch_t = const std::vector<std::string_view>&;
+#else
+using key_batch_t = std::span<const std::string_view>;
+#endif
+
+/**
+ * \brief The result of a batched lookup
+ *
+ * Holds the values found for a batch of keys in one contiguous array, in the order of the keys, and
+ * a bit mask telling which keys were found.
+ * The values of the keys not found are default constructed.
+ *
+ * \tparam T The type of the values
+ */
+template<class T>
+struct batch_result {
+    /// The index returned by first_missing if all keys were found
+    constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * \brief Constructs an empty result for the given number of keys
+     *
+     * All keys are marked as missing.
+     *
+     * \param n The number of keys in the batch
+     */
+    explicit batch_result(std::size_t n)
+         : _values(std::make_unique<T[]>(n)),
+           _size(n),
+           _found((n + 63) / 64, 0),
+           _found_count(0) { }
+
+    /**
+     * \brief Stores the value of a found key
+     *
+     * \param idx The index of the key in the batch
+     * \param value The value of the key
+     */
+    void
+    set(std::size_t idx, T value) {
+        _values[idx] = std::move(value);
+        auto& word = _found[idx / 64];
+        auto bit = std::uint64_t{1} << (idx % 64);
+        if (!(word & bit)) ++_found_count;
+        word |= bit;
+    }
+
+    /**
+     * \brief Stores the values of a range of keys
+     *
+     * Calls convert with the index of each key in [first, last), and stores the values it returns;
+     * keys for which it returns an empty optional stay missing.
+     * Ranges starting at multiples of 64 share no word of the mask, so they may be filled from
+     * different threads at once.
+     * The number of keys found is not updated, call recount after filling.
+     *
+     * \tparam Fn The type of the conversion function.
+     * \param first The index of the first key of the range
+     * \param last The index past the last key of the range
+     * \param convert The function returning the value of a key, if it has one
+     */
+    template<class Fn>
+    void
+    fill(std::size_t first, std::size_t last, Fn&& convert) {
+        std::uint64_t word = 0;
+        for (auto idx = first; idx < last; ++idx) {
+            auto value = convert(idx);
+            if (value) {
+                _values[idx] = std::move(*value);
+                word |= std::uint64_t{1} << (idx % 64);
+            }
+            if (idx % 64 == 63 || idx + 1 == last) {
+                _found[idx / 64] |= word;
+                word = 0;
+            }
+        }
+    }
+
+    /**
+     * \brief Recounts the keys found
+     *
+     * Updates the number of keys found from the mask, after filling ranges with fill.
+     */
+    void
+    recount() noexcept {
+        _found_count = 0;
+        for (auto word : _found) {
+#if defined(__GNUC__) || defined(__clang__)
+            _found_count += static_cast<std::size_t>(__builtin_popcountll(word));
+#else
+            for (; word; word &= word - 1) ++_found_count;
+#endif
+        }
+    }
+
+    /**
+     * \brief Getter for the number of keys
+     *
+     * \return The number of keys in the batch.
+     */
+    std::size_t
+    size() const noexcept { return _size; }
+
+    /**
+     * \brief Checks whether a key was found
+     *
+     * \param idx The index of the key in the batch
+     * \return Whether the key was found.
+     */
+    bool
+    found(std::size_t idx) const noexcept { return (_found[idx / 64] >> (idx % 64)) & 1; }
+
+    /**
+     * \brief Checks whether all keys were found
+     *
+     * \return Whether all keys of the batch were found.
+     */
+    bool
+    all_found() const noexcept { return _found_count == _size; }
+
+    /**
+     * \brief Finds the first key that was not found
+     *
+     * \return The index of the first missing key, or npos if all keys were found.
+     */
+    std::size_t
+    first_missing() const noexcept {
+        for (std::size_t w = 0; w < _found.size(); ++w) {
+            auto missing = ~_found[w];
+            if (missing == 0) continue;
+            std::size_t idx = w * 64;
+            while (!(missing & 1)) {
+                missing >>= 1;
+                ++idx;
+            }
+            return idx < _size ? idx : npos;
+        }
+        return npos;
+    }
+
+    /**
+     * \brief Returns a value
+     *
+     * \param idx The index of the key in the batch
+     * \return The value of the key, or a default constructed value if the key was not found.
+     */
+    const T&
+    operator[](std::size_t idx) const noexcept { return _values[idx]; }
+
+    /**
+     * \brief Returns the values
+     *
+     * \return Pointer to the first element of the contiguous array of values.
+     */
+    const T*
+    data() const noexcept { return _values.get(); }
+
+    /**
+     * \brief Returns the bit mask of the found keys
+     *
+     * Bit i % 64 of word i / 64 is set if the key i was found.
+     *
+     * \return The words of the mask
+     */
+    const std::vector<std::uint64_t>&
+    found_mask() const noexcept { return _found; }
+
+private:
+    std::unique_ptr<T[]> _values;      ///< The values of the keys
+    std::size_t _size;                 ///< The number of keys
+    std::vector<std::uint64_t> _found; ///< The bit mask of the found keys
+    std::size_t _found_count;          ///< The number of keys found
+};
+
+#endif
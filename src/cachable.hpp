@@ -53,6 +53,12 @@
 #include <memory>
 #include <string>
 #include <type_traits>
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <string_view>
+#endif
 
 #include "cache_factory.hpp"
 
@@ -69,7 +75,7 @@ template<class T>
 concept cachable =
        requires(cache_factory<T> c) {
            typename cache_factory<T>::cache_type;
-           { c.construct(std::declval<const std::string&>()) } -> std::same_as<std::unique_ptr<cache>>;
+           { c.construct(std::declval<std::string_view>()) } -> std::same_as<std::unique_ptr<cache>>;
        };
 
 #else
@@ -93,7 +99,7 @@ class jporta_cachable {
 
     template<class C>
     static auto
-           test_impl(std::nullptr_t) -> decltype(std::declval<C>().construct(std::declval<const std::string&>()), True{});
+           test_impl(std::nullptr_t) -> decltype(std::declval<C>().construct(std::declval<std::string_view>()), True{});
     template<class>
     static False&
     test_impl(...);
@@ -39,7 +39,6 @@
 #ifndef CONFY_CACHE_FACTORY_HPP
 #define CONFY_CACHE_FACTORY_HPP
 
-#include <limits>
 #include <memory>
 #include <string>
 #ifdef USE_CXX17
@@ -50,6 +49,7 @@
 #endif
 
 #include "caches.hpp"
+#include "parse_number.hpp"
 
 /**
  * \brief Base of the cache_factory types.
@@ -59,13 +59,23 @@
  *
  * If this type can be cached, the followings are required (formalized in the cachable concept):
  * - must define the type of cache constructed,
- * - must define the `std::unique_ptr<cache> construct(const std::string&)` function, which takes
+ * - must define the `std::unique_ptr<cache> construct(std::string_view)` function, which takes
  * the stored string and converts it into the chosen type in the form of a cache object.
  *
+ * The built-in cachable types also define the `bool parse(std::string_view, T&) const noexcept`
+ * function, which parses the string without allocating a cache object, so config may cache the
+ * value inline. Their numbers are parsed by the functions of parse_number.hpp, independent of the
+ * locale; integers may be written in hexadecimal, octal, or binary with a `0x`, `0o`, or `0b`
+ * prefix. Unprefixed hexadecimal values are read by requesting them as bare_hex<T>, see
+ * bare_hex.hpp.
+ *
  * If the type cannot be cached, the followings are required:
- * - must define the `T make(const std::string&) const` function, where T is the type to parse from
+ * - must define the `T make(std::string_view) const` function, where T is the type to parse from
  * a string.
  *
+ * The passed string views are always followed by a NUL byte in memory, so they may be used as
+ * C-strings, although the built-in factories do not rely on this.
+ *
  * \tparam T The type to provide support for in confy
  */
 template<class T>
@@ -91,7 +101,7 @@ struct cache_factory<std::string> {
    * \return The new object of type std::string.
    */
     std::string
-    make(const std::string& data) const { return data; }
+    make(std::string_view data) const { return {data.data(), data.size()}; }
 };
 
 /**
@@ -114,7 +124,7 @@ struct cache_factory<std::string_view> {
    * \return The new object of type std::string_view.
    */
     std::string_view
-    make(const std::string& data) const { return data; }
+    make(std::string_view data) const { return data; }
 };
 
 /**
@@ -137,7 +147,7 @@ struct cache_factory<const char*> {
    * \return The new object of type const char*.
    */
     const char*
-    make(const std::string& data) const { return data.c_str(); }
+    make(std::string_view data) const { return data.data(); }
 };
 
 /**
@@ -155,6 +165,21 @@ struct cache_factory<signed char> {
      */
     using cache_type = schar_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `signed char`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, signed char& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -166,21 +191,10 @@ struct cache_factory<signed char> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtol(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        signed char used_value;
-        if (act_value > std::numeric_limits<signed char>::max()) {
-            used_value = std::numeric_limits<signed char>::max();
-        } else if (act_value < std::numeric_limits<signed char>::min()) {
-            used_value = std::numeric_limits<signed char>::min();
-        } else {
-            used_value = static_cast<signed char>(act_value);
-        }
-        return std::make_unique<cache_type>(std::move(used_value));
+    construct(std::string_view data) {
+        signed char value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -199,6 +213,21 @@ struct cache_factory<unsigned char> {
      */
     using cache_type = uchar_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `unsigned char`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, unsigned char& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -210,21 +239,10 @@ struct cache_factory<unsigned char> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtoul(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        unsigned char used_value;
-        if (act_value > std::numeric_limits<unsigned char>::max()) {
-            used_value = std::numeric_limits<unsigned char>::max();
-        } else if (act_value < std::numeric_limits<unsigned char>::min()) {
-            used_value = std::numeric_limits<unsigned char>::min();
-        } else {
-            used_value = static_cast<unsigned char>(act_value);
-        }
-        return std::make_unique<cache_type>(std::move(used_value));
+    construct(std::string_view data) {
+        unsigned char value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -243,6 +261,21 @@ struct cache_factory<char> {
      */
     using cache_type = char_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `char`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, char& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -254,21 +287,10 @@ struct cache_factory<char> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtol(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        char used_value;
-        if (act_value > std::numeric_limits<char>::max()) {
-            used_value = std::numeric_limits<char>::max();
-        } else if (act_value < std::numeric_limits<char>::min()) {
-            used_value = std::numeric_limits<char>::min();
-        } else {
-            used_value = static_cast<char>(act_value);
-        }
-        return std::make_unique<cache_type>(std::move(used_value));
+    construct(std::string_view data) {
+        char value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -287,6 +309,21 @@ struct cache_factory<int> {
      */
     using cache_type = int_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `int`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, int& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -298,21 +335,10 @@ struct cache_factory<int> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtol(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        int used_value;
-        if (act_value > std::numeric_limits<int>::max()) {
-            used_value = std::numeric_limits<int>::max();
-        } else if (act_value < std::numeric_limits<int>::min()) {
-            used_value = std::numeric_limits<int>::min();
-        } else {
-            used_value = static_cast<int>(act_value);
-        }
-        return std::make_unique<cache_type>(std::move(used_value));
+    construct(std::string_view data) {
+        int value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -331,6 +357,21 @@ struct cache_factory<unsigned> {
      */
     using cache_type = uint_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `unsigned`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, unsigned& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -342,21 +383,10 @@ struct cache_factory<unsigned> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtoul(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        unsigned used_value;
-        if (act_value > std::numeric_limits<unsigned>::max()) {
-            used_value = std::numeric_limits<unsigned>::max();
-        } else if (act_value < std::numeric_limits<unsigned>::min()) {
-            used_value = std::numeric_limits<unsigned>::min();
-        } else {
-            used_value = static_cast<unsigned>(act_value);
-        }
-        return std::make_unique<cache_type>(std::move(used_value));
+    construct(std::string_view data) {
+        unsigned value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -375,6 +405,21 @@ struct cache_factory<long> {
      */
     using cache_type = long_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `long`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, long& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -386,12 +431,9 @@ struct cache_factory<long> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto value = std::strtol(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
+    construct(std::string_view data) {
+        long value;
+        if (!parse(data, value)) return nullptr;
         return std::make_unique<cache_type>(std::move(value));
     }
 };
@@ -411,6 +453,21 @@ struct cache_factory<unsigned long> {
      */
     using cache_type = ulong_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `unsigned long`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, unsigned long& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -422,12 +479,9 @@ struct cache_factory<unsigned long> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto value = std::strtoul(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
+    construct(std::string_view data) {
+        unsigned long value;
+        if (!parse(data, value)) return nullptr;
         return std::make_unique<cache_type>(std::move(value));
     }
 };
@@ -447,6 +501,21 @@ struct cache_factory<long long> {
      */
     using cache_type = long_long_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `long long`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, long long& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -458,12 +527,9 @@ struct cache_factory<long long> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto value = std::strtoll(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
+    construct(std::string_view data) {
+        long long value;
+        if (!parse(data, value)) return nullptr;
         return std::make_unique<cache_type>(std::move(value));
     }
 };
@@ -483,6 +549,21 @@ struct cache_factory<unsigned long long> {
      */
     using cache_type = ulong_long_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `unsigned long long`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, unsigned long long& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -494,12 +575,9 @@ struct cache_factory<unsigned long long> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto value = std::strtoull(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
+    construct(std::string_view data) {
+        unsigned long long value;
+        if (!parse(data, value)) return nullptr;
         return std::make_unique<cache_type>(std::move(value));
     }
 };
@@ -519,6 +597,21 @@ struct cache_factory<short> {
      */
     using cache_type = short_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `short`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, short& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -530,21 +623,10 @@ struct cache_factory<short> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtol(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        short used_value;
-        if (act_value > std::numeric_limits<short>::max()) {
-            used_value = std::numeric_limits<short>::max();
-        } else if (act_value < std::numeric_limits<short>::min()) {
-            used_value = std::numeric_limits<short>::min();
-        } else {
-            used_value = static_cast<short>(act_value);
-        }
-        return std::make_unique<cache_type>(std::move(used_value));
+    construct(std::string_view data) {
+        short value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -563,6 +645,21 @@ struct cache_factory<unsigned short> {
      */
     using cache_type = ushort_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `unsigned short`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, unsigned short& out) const noexcept {
+        return parse_integer(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -574,21 +671,10 @@ struct cache_factory<unsigned short> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtol(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        unsigned short used_value;
-        if (act_value > std::numeric_limits<unsigned short>::max()) {
-            used_value = std::numeric_limits<unsigned short>::max();
-        } else if (act_value < std::numeric_limits<unsigned short>::min()) {
-            used_value = std::numeric_limits<unsigned short>::min();
-        } else {
-            used_value = static_cast<unsigned short>(act_value);
-        }
-        return std::make_unique<cache_type>(std::move(used_value));
+    construct(std::string_view data) {
+        unsigned short value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -607,6 +693,24 @@ struct cache_factory<bool> {
      */
     using cache_type = bool_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `bool`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, bool& out) const noexcept {
+        long value;
+        if (!parse_integer(data, value)) return false;
+        out = value != 0;
+        return true;
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -618,13 +722,10 @@ struct cache_factory<bool> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtol(data.c_str(), &end, 10);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        return std::make_unique<cache_type>(act_value != 0);
+    construct(std::string_view data) {
+        bool value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -643,6 +744,21 @@ struct cache_factory<float> {
      */
     using cache_type = float_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `float`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, float& out) const noexcept {
+        return parse_floating(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -654,13 +770,10 @@ struct cache_factory<float> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtof(data.c_str(), &end);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        return std::make_unique<cache_type>(std::move(act_value));
+    construct(std::string_view data) {
+        float value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -679,6 +792,21 @@ struct cache_factory<double> {
      */
     using cache_type = double_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `double`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, double& out) const noexcept {
+        return parse_floating(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -690,13 +818,10 @@ struct cache_factory<double> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtod(data.c_str(), &end);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        return std::make_unique<cache_type>(std::move(act_value));
+    construct(std::string_view data) {
+        double value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -715,6 +840,21 @@ struct cache_factory<long double> {
      */
     using cache_type = long_double_cache;
 
+    /**
+     * \brief The parser function.
+     *
+     * This function is used to parse the passed string into an object of the requested `long double`
+     * type, without allocating.
+     *
+     * \param data The string stored as the value, parsed for the data.
+     * \param out The object receiving the parsed value, if parsing succeeds.
+     * \return Whether parsing succeeded.
+     */
+    bool
+    parse(std::string_view data, long double& out) const noexcept {
+        return parse_floating(data, out);
+    }
+
     /**
      * \brief The parser and type constructor function.
      *
@@ -726,13 +866,10 @@ struct cache_factory<long double> {
      * \return The cache containing the parsed object, or `nullptr` if parsing couldn't succeed.
      */
     std::unique_ptr<cache>
-    construct(const std::string& data) {
-        char* end;
-        auto act_value = std::strtold(data.c_str(), &end);
-        if (end == data.c_str()) { // couldn't parse anything
-            return nullptr;
-        }
-        return std::make_unique<cache_type>(std::move(act_value));
+    construct(std::string_view data) {
+        long double value;
+        if (!parse(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
     }
 };
 
@@ -0,0 +1,210 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file cache_table.hpp
+ * \brief Defines the cache_table type
+ *
+ * This file defines the cache_table class, which config uses to cache the conversions that do not
+ * fit its inline cache: to further built-in types, and to user-defined cachable types.
+ */
+
+#ifndef CONFY_CACHE_TABLE_HPP
+#define CONFY_CACHE_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "cache_factory.hpp"
+#include "cache_visitor_for.hpp"
+#include "caches.hpp"
+#include "inline_cache.hpp"
+#include "visitor.hpp"
+
+#ifndef CONFY_CACHED_TYPES
+/// The number of types each config entry caches the conversions to, once it has more than one
+#  define CONFY_CACHED_TYPES 2
+#endif
+
+/**
+ * \brief Table of cached conversions, indexed by type
+ *
+ * Holds the conversions of an entry to several types at once: the values of the built-in types,
+ * stored bytewise like in inline_cache, and the cache objects of user-defined types.
+ * Each conversion takes a slot of the table; the slot of a type is found through a position table
+ * indexed by the dense visit index of the type, so finding it is a single load, like the dispatch
+ * of the visitors.
+ * Types whose visit index does not fit the position table are found by comparing the visit indices
+ * of the few slots.
+ * Up to CONFY_CACHED_TYPES conversions are kept; storing more replaces the oldest one.
+ */
+struct cache_table {
+    /// The number of conversions kept at once
+    constexpr static std::size_t max_types = CONFY_CACHED_TYPES;
+
+    static_assert(max_types >= 1 && max_types < 255, "CONFY_CACHED_TYPES must be between 1 and 254");
+
+    /**
+     * \brief Gets the cached value of a built-in type
+     *
+     * \tparam T The type of the value, which must be a built-in type.
+     * \param out The object receiving the value, if one of type T is cached.
+     * \return Whether a value of type T is cached.
+     */
+    template<class T>
+    bool
+    get(T& out) const noexcept {
+        static_assert(inline_cache::builtin<T>(), "type not stored bytewise by cache_table");
+        auto idx = slot_of(visit_index<T>);
+        if (idx == max_types) return false;
+        std::memcpy(&out, _slots[idx].bytes, sizeof(T));
+        return true;
+    }
+
+    /**
+     * \brief Caches a value of a built-in type
+     *
+     * Replaces the value of T, if there is one, otherwise the oldest conversion, if the table is
+     * full.
+     *
+     * \tparam T The type of the value, which must be a built-in type.
+     * \param value The value to cache
+     */
+    template<class T>
+    void
+    store(const T& value) noexcept {
+        static_assert(inline_cache::builtin<T>(), "type not stored bytewise by cache_table");
+        static_assert(sizeof(T) <= sizeof(_slots[0].bytes), "type too large for cache_table");
+        std::memcpy(_slots[claim(visit_index<T>)].bytes, &value, sizeof(T));
+    }
+
+    /**
+     * \brief Finds the cached value of a user-defined type
+     *
+     * \tparam T The type of the value
+     * \return Pointer to the cached value, or nullptr, if there is none.
+     */
+    template<class T>
+    const T*
+    find() const noexcept {
+        auto idx = slot_of(visit_index<T>);
+        if (idx == max_types) return nullptr;
+        // store checked the type of the cache
+        return static_cast<const typename cache_factory<T>::cache_type&>(*_slots[idx].made).get_value_ptr();
+    }
+
+    /**
+     * \brief Stores the cache of a user-defined type
+     *
+     * Checks that the cache is of the cache type of T, then stores it as the cache of T.
+     * It replaces the cache of T, if there is one, otherwise the oldest conversion, if the table is
+     * full.
+     * If the cache is not of the right type, an `std::runtime_error` exception is thrown.
+     *
+     * \tparam T The type of the cached value
+     * \param made The cache constructed by the cache_factory of T
+     * \return The cached value, valid until the next conversion is stored
+     */
+    template<class T>
+    const T&
+    store(std::unique_ptr<cache> made) {
+        cache_visitor_for<T> vtor;
+        made->accept(vtor);
+        if (!vtor.valid()) throw std::runtime_error("unknown error occurred fetching config");
+
+        _slots[claim(visit_index<T>)].made = std::move(made);
+        return vtor.value();
+    }
+
+private:
+    /// The number of visit indices the position table has an entry for
+    constexpr static std::size_t indexed_types = visitor_base::dispatch_size;
+
+    /**
+     * \brief A cached conversion
+     */
+    struct slot {
+        std::size_t type = 0;                          ///< The visit index of the type, zero if unused
+        std::unique_ptr<cache> made;                   ///< The cache of a user-defined type
+        unsigned char bytes[sizeof(long double)] = {}; ///< The bytes of the value of a built-in type
+    };
+
+    /**
+     * \brief Finds the slot of a type
+     *
+     * \param type The visit index of the type
+     * \return The slot of the conversion to the type, or max_types, if there is none.
+     */
+    std::size_t
+    slot_of(std::size_t type) const noexcept {
+        // during the dynamic initialization, the visit index may not be assigned yet
+        if (type == 0) return max_types;
+        if (type < indexed_types) return _positions[type] == 0 ? max_types : _positions[type] - 1u;
+        for (std::size_t i = 0; i < max_types; ++i) {
+            if (_slots[i].type == type) return i;
+        }
+        return max_types;
+    }
+
+    /**
+     * \brief Takes the slot for a conversion to a type
+     *
+     * Returns the slot of the type, if it has one, otherwise takes the oldest slot from its type.
+     * A type without a visit index takes a slot without being found later.
+     *
+     * \param type The visit index of the type
+     * \return The slot to store the conversion in.
+     */
+    std::size_t
+    claim(std::size_t type) noexcept {
+        auto idx = slot_of(type);
+        if (idx != max_types) return idx;
+
+        idx = _next;
+        _next = static_cast<std::uint8_t>((_next + 1) % max_types);
+        auto& old = _slots[idx];
+        if (old.type != 0 && old.type < indexed_types) _positions[old.type] = 0;
+        old.type = type;
+        old.made.reset();
+        if (type != 0 && type < indexed_types) _positions[type] = static_cast<std::uint8_t>(idx + 1);
+        return idx;
+    }
+
+    std::uint8_t _positions[indexed_types] = {}; ///< The 1-based slots of the types, by visit index
+    slot _slots[max_types];                      ///< The cached conversions
+    std::uint8_t _next = 0;                      ///< The slot to store the next new type in
+};
+
+#endif
@@ -36,9 +36,25 @@
 
 #include "config.hpp"
 
-config::config(std::string name, std::string value)
-     : _name(std::move(name)),
-       _value(std::move(value)) { }
+config::config(string_ref value) noexcept
+     : _value(value) { }
+
+config::config(config&& other) noexcept
+     : _value(other._value),
+       _inline(other._inline) {
+    other._inline = inline_cache();
+}
+
+config&
+config::operator=(config&& other) noexcept {
+    if (this != &other) {
+        _value = other._value;
+        adopt_caches(other);
+    }
+    return *this;
+}
+
+config::~config() noexcept { delete _inline.table(); }
 
 std::string_view
-config::get_key() const noexcept { return _name; }
+config::get_value(const char* arena) const noexcept { return _value.in(arena); }
@@ -36,7 +36,8 @@
  * \file config.hpp
  * \brief A single configuration entry
  *
- * This file defines the config class, which stores a single key-value entry.
+ * This file defines the config class, which stores the value of a single key-value entry, and the
+ * string_ref type config_set uses to locate keys and values in its arena.
  */
 
 #ifndef CONFY_CONFIG_HPP
@@ -46,19 +47,25 @@
 #  define USE_CXX17
 #endif
 
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #ifdef USE_CXX17
+#  include <experimental/optional>
 #  include <experimental/string_view>
+#  define optional experimental::optional
 #  define string_view experimental::string_view
 #else
+#  include <optional>
 #  include <string_view>
 #endif
 
 #include "cache_factory.hpp"
+#include "cache_table.hpp"
 #include "cache_visitor_for.hpp"
 #include "caches.hpp"
+#include "inline_cache.hpp"
 
 #ifdef cachable
 #  undef cachable
@@ -66,30 +73,93 @@
 #include "cachable.hpp"
 
 /**
- * \brief Key-value config entry
+ * \brief A reference to a string in an arena
  *
- * A class that stores a single key-value entry in the system.
+ * Locates a string by its 32-bit offset and length in a contiguous buffer, the arena, holding all
+ * keys and values of a configuration.
+ * Half the size of a pointer and a length, and stays valid if the arena is moved.
+ */
+struct string_ref {
+    std::uint32_t offset; ///< The offset of the first byte of the string in the arena
+    std::uint32_t length; ///< The length of the string
+
+    /**
+     * \brief Returns the referred string
+     *
+     * \param arena The first byte of the arena
+     * \return The referred string
+     */
+    std::string_view
+    in(const char* arena) const noexcept { return {arena + offset, length}; }
+};
+
+/**
+ * \brief Value of a config entry
+ *
+ * A class that stores the value part of a single entry in the system, and the cache of its
+ * conversions.
+ * The key of the entry, and the bytes of the value are owned by the config_set: config only refers
+ * to the value by its position in the config_set's arena, so it may be stored in a compact array,
+ * separate from the keys that are compared on lookups.
+ *
+ * Conversions to several types are cached at once, so reading an entry alternately as different
+ * types does not parse it again on every read.
+ * The first conversion to a built-in cachable type is cached inline, in a small tagged buffer,
+ * without any heap allocation.
+ * Once an entry is converted to another type, or to a user-defined cachable type, the buffer gives
+ * way to a table indexed by type, which then caches all conversions of the entry; the table is only
+ * allocated by the entries that need it, so the others stay small.
  */
 struct config {
     /**
-     * \brief Constructs a key-value entry
+     * \brief Constructs a config entry
      *
-     * Takes a key and value pair, and creates a valid config entry for storage.
+     * Takes the reference to the value in the arena, and creates a valid config entry for storage.
+     * The value must be followed by a NUL byte in the arena, so that it may be handed out as a
+     * C-string.
      *
-     * \param name The key part of the entry
      * \param value The value part of the entry
      */
-    config(std::string name, std::string value);
+    explicit config(string_ref value) noexcept;
+
+    /**
+     * \brief Move constructor
+     *
+     * Takes over the value and the caches of the other entry, leaving its caches empty.
+     *
+     * \param other The entry to move from
+     */
+    config(config&& other) noexcept;
 
     /**
-     * \brief Returns the key
+     * \brief Move assignment
+     *
+     * Frees the caches of the entry, then takes over the value and the caches of the other entry,
+     * leaving its caches empty.
      *
-     * A getter for the key part of the configuration entry.
+     * \param other The entry to move from
+     * \return This entry
+     */
+    config&
+    operator=(config&& other) noexcept;
+
+    /**
+     * \brief Destructor
      *
-     * \return The name of the entry
+     * Frees the table of the caches, if the entry has one.
+     */
+    ~config() noexcept;
+
+    /**
+     * \brief Returns the raw value
+     *
+     * A getter for the unparsed value of the entry.
+     *
+     * \param arena The first byte of the arena holding the value
+     * \return The value of the entry
      */
     std::string_view
-    get_key() const noexcept;
+    get_value(const char* arena) const noexcept;
 
     /**
      * \brief Get the value of the entry
@@ -97,53 +167,292 @@ struct config {
      * A getter for the configuration entry.
      * The value is parsed into the requested type.
      * Caching is implemented, so multiple queries to the same type will not calculate the process
-     * again, if asked in direct succession.
+     * again, even if queries to other types come in between, as long as no more than
+     * CONFY_CACHED_TYPES types are used besides the one cached inline.
      *
      * \tparam T The type to parse the value into
+     * \param arena The first byte of the arena holding the value
      * \return The parsed value
      */
     template<class T>
     auto
-    get_as() const {
-        return get_as_impl<T, cachable<T>>::get(_value, _cache);
+    get_as(const char* arena) const {
+        return get_as_impl<T, cachable<T>>::get(get_value(arena), _inline);
+    }
+
+    /**
+     * \brief Try to get the value of the entry
+     *
+     * Like get_as, but a value that cannot be parsed into the requested type results in an empty
+     * optional instead of an exception.
+     * A failed conversion leaves the cache as it was.
+     *
+     * \tparam T The type to parse the value into
+     * \param arena The first byte of the arena holding the value
+     * \return The parsed value, or an empty optional, if the value cannot be parsed.
+     */
+    template<class T>
+    std::optional<T>
+    try_get_as(const char* arena) const {
+        return get_as_impl<T, cachable<T>>::try_get(get_value(arena), _inline);
+    }
+
+    /**
+     * \brief Converts the value of the entry without caching it
+     *
+     * Like try_get_as, but values of the types cached inline are parsed without storing the result,
+     * so the entry is only read.
+     * Used by bulk conversions, which keep the converted values themselves.
+     * Values of other types are converted and cached like with try_get_as.
+     *
+     * \tparam T The type to parse the value into
+     * \param arena The first byte of the arena holding the value
+     * \return The parsed value, or an empty optional, if the value cannot be parsed.
+     */
+    template<class T>
+    std::optional<T>
+    peek_as(const char* arena) const {
+        if constexpr (inline_cache::builtin<T>()) {
+            T result;
+            if (_inline.get(result) || (_inline.table() && _inline.table()->get(result))) return result;
+            if (!cache_factory<T>().parse(get_value(arena), result)) return {};
+            return result;
+        } else {
+            return try_get_as<T>(arena);
+        }
+    }
+
+    /**
+     * \brief Reads the value of the entry without writing the entry
+     *
+     * Returns the cached conversion to the requested type, if there is one, and converts the value
+     * into a new object otherwise, without caching it.
+     * As nothing is written, any number of threads may read the entry at once, as long as no thread
+     * converts it with the caching functions meanwhile.
+     *
+     * \tparam T The type to parse the value into
+     * \param arena The first byte of the arena holding the value
+     * \return The parsed value, or an empty optional, if the value cannot be parsed.
+     */
+    template<class T>
+    std::optional<T>
+    read_as(const char* arena) const {
+        return get_as_impl<T, cachable<T>>::read(get_value(arena), _inline);
+    }
+
+    /**
+     * \brief Converts the value into a separately owned object
+     *
+     * Parses the value into the requested type, into a new object, which is not affected by the
+     * later conversions of the entry.
+     * Used to pin a value that is referred to directly, without the cache of the entry.
+     *
+     * \tparam T The type to parse the value into
+     * \param arena The first byte of the arena holding the value
+     * \return The owner of the parsed value
+     */
+    template<class T>
+    std::shared_ptr<const T>
+    pin_as(const char* arena) const {
+        return get_as_impl<T, cachable<T>>::pin(get_value(arena));
+    }
+
+    /**
+     * \brief Points the entry to its parsed value
+     *
+     * Entries of a lazily loaded config_set first refer to their whole, unparsed line; once the line
+     * is parsed, the entry is settled on the value found in it.
+     * Must not be called after the value was converted, as the caches are kept.
+     *
+     * \param value The value part of the entry
+     */
+    void
+    settle(string_ref value) const noexcept { _value = value; }
+
+    /**
+     * \brief Takes over the caches of another entry
+     *
+     * Used when a configuration is reloaded, to keep the conversions of the entries whose value did
+     * not change.
+     * The value of the other entry must be the same string as ours; its caches are left empty.
+     *
+     * \param other The entry of the same value to take the caches of
+     */
+    void
+    adopt_caches(config& other) noexcept {
+        delete _inline.table();
+        _inline = other._inline;
+        other._inline = inline_cache();
     }
 
 private:
-    template<class T, bool>
+    /**
+     * \brief Returns the table of an entry
+     *
+     * Allocates the table, and stores it in place of the inline value, if the entry has none yet.
+     * The inline value moves into the table, so it is not converted again.
+     *
+     * \param slot The inline cache of the entry
+     * \return The table of the entry
+     */
+    static cache_table&
+    table_of(inline_cache& slot) {
+        if (auto table = slot.table()) return *table;
+        auto table = std::make_unique<cache_table>();
+        slot.visit([&table](const auto& value) { table->store(value); });
+        slot.spill(table.get());
+        return *table.release();
+    }
+
+    template<class T, bool, bool = inline_cache::builtin<T>()>
     struct get_as_impl;
 
-    template<class T>
-    struct get_as_impl<T, false> {
+    template<class T, bool Builtin>
+    struct get_as_impl<T, false, Builtin> {
         static auto
-        get(const std::string& value, std::unique_ptr<cache>&) {
+        get(std::string_view value, inline_cache&) {
+            auto cf = cache_factory<T>();
+            return cf.make(value);
+        }
+
+        static std::optional<T>
+        try_get(std::string_view value, inline_cache&) {
             auto cf = cache_factory<T>();
             return cf.make(value);
         }
+
+        static std::optional<T>
+        read(std::string_view value, const inline_cache&) {
+            auto cf = cache_factory<T>();
+            return cf.make(value);
+        }
+
+        static std::shared_ptr<const T>
+        pin(std::string_view value) {
+            auto cf = cache_factory<T>();
+            return std::make_shared<const T>(cf.make(value));
+        }
     };
 
     template<class T>
-    struct get_as_impl<T, true> {
+    struct get_as_impl<T, true, false> {
         static auto
-        get(const std::string& value, std::unique_ptr<cache>& _cache) {
-            if (_cache) {
-                cache_visitor_for<T> vtor;
-                _cache->accept(vtor);
-                if (vtor.valid()) return vtor.value();
+        get(std::string_view value, inline_cache& slot) {
+            if (auto table = slot.table()) {
+                if (auto hit = table->template find<T>()) return *hit;
             }
             auto cf = cache_factory<T>();
-            _cache = cf.construct(value);
-            if (!_cache) throw std::invalid_argument("requested type couldn't be constructed");
+            auto made = cf.construct(value);
+            if (!made) throw std::invalid_argument("requested type couldn't be constructed");
+
+            return table_of(slot).template store<T>(std::move(made));
+        }
+
+        static std::optional<T>
+        try_get(std::string_view value, inline_cache& slot) {
+            if (auto table = slot.table()) {
+                if (auto hit = table->template find<T>()) return *hit;
+            }
+            auto cf = cache_factory<T>();
+            auto made = cf.construct(value);
+            if (!made) return {};
+
+            return table_of(slot).template store<T>(std::move(made));
+        }
+
+        static std::optional<T>
+        read(std::string_view value, const inline_cache& slot) {
+            if (auto table = slot.table()) {
+                if (auto hit = table->template find<T>()) return *hit;
+            }
+            auto cf = cache_factory<T>();
+            auto made = cf.construct(value);
+            if (!made) return {};
 
             cache_visitor_for<T> vtor;
-            _cache->accept(vtor);
-            if (!vtor.valid()) throw std::runtime_error("unknown error occurred fetching config");
+            made->accept(vtor);
+            if (!vtor.valid()) return {};
             return vtor.value();
         }
+
+        static std::shared_ptr<const T>
+        pin(std::string_view value) {
+            auto cf = cache_factory<T>();
+            std::shared_ptr<cache> owner = cf.construct(value);
+            if (!owner) throw std::invalid_argument("requested type couldn't be constructed");
+
+            cache_visitor_for<T> vtor;
+            owner->accept(vtor);
+            if (!vtor.valid()) throw std::runtime_error("unknown error occurred fetching config");
+            return std::shared_ptr<const T>(owner, &vtor.value());
+        }
+    };
+
+    template<class T>
+    struct get_as_impl<T, true, true> : get_as_impl<T, true, false> {
+        static T
+        get(std::string_view value, inline_cache& slot) {
+            T result;
+            if (find(result, slot)) return result;
+            if (!cache_factory<T>().parse(value, result))
+                throw std::invalid_argument("requested type couldn't be constructed");
+            store(result, slot);
+            return result;
+        }
+
+        static std::optional<T>
+        try_get(std::string_view value, inline_cache& slot) {
+            T result;
+            if (find(result, slot)) return result;
+            if (!cache_factory<T>().parse(value, result)) return {};
+            store(result, slot);
+            return result;
+        }
+
+        static std::optional<T>
+        read(std::string_view value, const inline_cache& slot) {
+            T result;
+            if (find(result, slot)) return result;
+            if (!cache_factory<T>().parse(value, result)) return {};
+            return result;
+        }
+
+        /**
+         * \brief Finds a cached value, inline or in the table
+         *
+         * \param result The object receiving the value, if it is cached.
+         * \param slot The inline cache of the entry
+         * \return Whether the value is cached.
+         */
+        static bool
+        find(T& result, const inline_cache& slot) noexcept {
+            if (auto table = slot.table()) return table->get(result);
+            return slot.get(result);
+        }
+
+        /**
+         * \brief Caches a converted value
+         *
+         * The first converted type is cached inline, if it fits; once another type is cached, the
+         * inline value gives way to the table of the entry, which then caches every type.
+         *
+         * \param result The converted value
+         * \param slot The inline cache of the entry
+         */
+        static void
+        store(const T& result, inline_cache& slot) {
+            if constexpr (inline_cache::holds<T>()) {
+                if (slot.empty()) {
+                    slot.store(result);
+                    return;
+                }
+            }
+            table_of(slot).store(result);
+        }
     };
 
-    std::string _name;                     ///< The name, or key, of the config entry stored
-    std::string _value;                    ///< The value of the config entry
-    mutable std::unique_ptr<cache> _cache; ///< The cache used to speed up conversions to types
+    mutable string_ref _value;    ///< The value of the config entry in the arena
+    mutable inline_cache _inline; ///< The cached value, or the table of the cached conversions
 };
 
 #endif
@@ -0,0 +1,66 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file config_diff.hpp
+ * \brief Defines the config_diff type
+ *
+ * This file defines the config_diff class, the summary of the differences between two loads of a
+ * configuration, returned when the caches of one are carried over to the other.
+ */
+
+#ifndef CONFY_CONFIG_DIFF_HPP
+#define CONFY_CONFIG_DIFF_HPP
+
+#include <cstddef>
+
+/**
+ * \brief The differences between two loads of a configuration
+ *
+ * Counts the entries of the newer load by how they relate to the older one.
+ * Entries are matched by key; a matched entry is unchanged if its value is the same string.
+ */
+struct config_diff {
+    std::size_t unchanged = 0; ///< The entries with the same key and value in both loads
+    std::size_t changed = 0;   ///< The entries whose value is different in the newer load
+    std::size_t added = 0;     ///< The entries only in the newer load
+    std::size_t removed = 0;   ///< The entries only in the older load
+
+    /**
+     * \brief Checks whether the loads hold the same entries
+     *
+     * \return Whether no entry was changed, added, or removed.
+     */
+    bool
+    empty() const noexcept { return changed == 0 && added == 0 && removed == 0; }
+};
+
+#endif
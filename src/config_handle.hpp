@@ -0,0 +1,133 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file config_handle.hpp
+ * \brief Defines the config_handle type
+ *
+ * This file defines the config_handle class, a pre-resolved reference to the value of an entry of
+ * a config_set, converted to a given type.
+ */
+
+#ifndef CONFY_CONFIG_HANDLE_HPP
+#define CONFY_CONFIG_HANDLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief Returns a new configuration set generation
+ *
+ * Every load of a config_set is assigned a distinct generation, so handles resolved against an
+ * earlier load can be told apart from the current ones.
+ * Thread-safe.
+ *
+ * \return A generation never returned before, which is never zero.
+ */
+std::uint64_t
+next_set_generation() noexcept;
+
+/**
+ * \brief A pre-resolved value of a config entry
+ *
+ * Returned by config_set::resolve, and refers to the value of an entry already converted to T.
+ * Reading the value through the handle is a single load: there is no key search and no cache
+ * visitation.
+ *
+ * The handle remembers the generation of the set it was resolved from.
+ * config_set::get checks it against the current generation of the set, and rejects stale handles,
+ * while dereferencing the handle directly skips the check.
+ * The value lives as long as the set it was resolved from, so the handle must not outlive the set:
+ * a handle of a destroyed set refers to freed memory, which the generation check cannot detect.
+ *
+ * \tparam T The type of the value
+ */
+template<class T>
+struct config_handle {
+    /**
+     * \brief Constructs an empty handle
+     *
+     * The handle refers to nothing, and belongs to no generation.
+     * It may only be assigned to.
+     */
+    config_handle() noexcept = default;
+
+    /**
+     * \brief Constructs a handle
+     *
+     * \param value The converted value
+     * \param position The position of the entry in the set
+     * \param generation The generation of the set
+     */
+    config_handle(const T* value, std::size_t position, std::uint64_t generation) noexcept
+         : _value(value),
+           _position(position),
+           _generation(generation) { }
+
+    /**
+     * \brief Returns the value without checking the generation
+     *
+     * \return The value of the entry
+     */
+    const T&
+    operator*() const noexcept { return *_value; }
+
+    /**
+     * \brief Accesses the value without checking the generation
+     *
+     * \return Pointer to the value of the entry
+     */
+    const T*
+    operator->() const noexcept { return _value; }
+
+    /**
+     * \brief Getter for the position of the entry
+     *
+     * \return The position of the entry in the set it was resolved from.
+     */
+    std::size_t
+    position() const noexcept { return _position; }
+
+    /**
+     * \brief Getter for the generation of the handle
+     *
+     * \return The generation of the set the handle was resolved from, or zero for empty handles.
+     */
+    std::uint64_t
+    generation() const noexcept { return _generation; }
+
+private:
+    const T* _value = nullptr;    ///< The converted value
+    std::size_t _position = 0;    ///< The position of the entry
+    std::uint64_t _generation = 0; ///< The generation of the set
+};
+
+#endif
@@ -0,0 +1,275 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file config_image.cpp
+ * \brief Implements reading and writing compiled configuration images
+ */
+
+#include "config_image.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "key_hash.hpp"
+
+#include "memtrace.h"
+
+namespace {
+    /// The magic number starting every image; the line ending catches images mangled as text
+    constexpr char image_magic[8] = {'C', 'O', 'N', 'F', 'Y', 'B', '\r', '\n'};
+    /// Stored in the byte order of the compiling machine, so images of other machines are rejected
+    constexpr std::uint32_t byte_order_mark = 0x01020304;
+    /// The smallest supported page size, which divides every other supported page size
+    constexpr std::size_t min_page_size = std::size_t{1} << 12;
+
+    struct image_header {
+        char magic[8];             ///< The magic number of images
+        std::uint32_t version;     ///< The version of the format
+        std::uint32_t byte_order;  ///< The byte order mark
+        std::uint64_t entries;     ///< The number of entries
+        std::uint64_t keys;        ///< The offset of the table of key references
+        std::uint64_t values;      ///< The offset of the table of value references
+        std::uint64_t size;        ///< The size of the image, without the padding
+        image_source source;       ///< The identity of the file the image was compiled from
+        std::uint64_t body_hash;   ///< The hash of the bytes following the header
+        std::uint64_t header_hash; ///< The hash of the fields above
+    };
+
+    static_assert(sizeof(image_header) == 104, "image header must have no padding");
+    static_assert(sizeof(string_ref) == 8, "string_ref must have no padding");
+
+    std::uint64_t
+    hash_header(const image_header& header) noexcept {
+        return hash_key({reinterpret_cast<const char*>(&header), offsetof(image_header, header_hash)});
+    }
+
+    [[noreturn]] void
+    invalid_image(const std::filesystem::path& file, const char* why) {
+        throw std::invalid_argument("invalid_image " + file.string() + ": " + why);
+    }
+
+    /**
+     * \brief Checks the header of an image
+     *
+     * \param header The header to check
+     * \param available The number of bytes available for the image
+     * \return The reason the header is invalid, or nullptr, if it is valid.
+     */
+    const char*
+    check_header(const image_header& header, std::size_t available) noexcept {
+        if (std::memcmp(header.magic, image_magic, sizeof(image_magic)) != 0) return "bad magic";
+        if (header.byte_order != byte_order_mark) return "foreign byte order";
+        if (header.version != config_image_version) return "unsupported version";
+        if (header.header_hash != hash_header(header)) return "corrupt header";
+        if (header.size < sizeof(header) || header.size > available) return "truncated";
+        if (header.keys != sizeof(header)
+            || header.entries > (header.size - sizeof(header)) / (2 * sizeof(string_ref))
+            || header.values != header.keys + header.entries * sizeof(string_ref))
+            return "bad tables";
+        return nullptr;
+    }
+
+    string_ref
+    load_ref(const char* table, std::size_t idx) noexcept {
+        string_ref ref;
+        std::memcpy(&ref, table + idx * sizeof(string_ref), sizeof(string_ref));
+        return ref;
+    }
+
+    /**
+     * \brief Checks whether a reference points into the arena of an image
+     *
+     * \param ref The reference to check
+     * \param data The bytes of the image
+     * \param arena The offset of the arena
+     * \param size The size of the image, without the padding
+     * \return Whether the reference points to a NUL-terminated string of the arena
+     */
+    bool
+    in_arena(string_ref ref, const char* data, std::size_t arena, std::size_t size) noexcept {
+        return ref.offset >= arena && std::uint64_t{ref.offset} + ref.length + 1 <= size
+               && data[ref.offset + ref.length] == '\0';
+    }
+
+    /**
+     * \brief Checks the tables of an image whose header is valid
+     *
+     * Checks that every key and value refers to a NUL-terminated string of the arena, and that the
+     * keys are strictly increasing, as the key index relies on it.
+     *
+     * \param header The checked header of the image
+     * \param data The bytes of the image
+     * \return The reason the tables are invalid, or nullptr, if they are valid.
+     */
+    const char*
+    check_tables(const image_header& header, const char* data) noexcept {
+        auto arena = static_cast<std::size_t>(header.values + header.entries * sizeof(string_ref));
+        auto size = static_cast<std::size_t>(header.size);
+        std::string_view prev;
+        for (std::size_t i = 0; i < header.entries; ++i) {
+            auto key = load_ref(data + header.keys, i);
+            if (!in_arena(key, data, arena, size) || !in_arena(load_ref(data + header.values, i), data, arena, size))
+                return "bad reference";
+            if (i != 0 && !(prev < key.in(data))) return "unsorted keys";
+            prev = key.in(data);
+        }
+        return nullptr;
+    }
+}
+
+string_ref
+config_image::key(std::size_t idx) const {
+    auto ref = load_ref(keys, idx);
+    if (!in_arena(ref, data, arena, size)) invalid_image(file, "bad reference");
+    return ref;
+}
+
+string_ref
+config_image::value(std::size_t idx) const {
+    auto ref = load_ref(values, idx);
+    if (!in_arena(ref, data, arena, size)) invalid_image(file, "bad reference");
+    return ref;
+}
+
+bool
+is_config_image(const std::filesystem::path& file) {
+    std::ifstream ifs(file, std::ios::binary);
+    char magic[sizeof(image_magic)];
+    return ifs.read(magic, sizeof(magic)) && std::memcmp(magic, image_magic, sizeof(magic)) == 0;
+}
+
+config_image
+open_config_image(const source_buffer& image, const std::filesystem::path& file, bool verify) {
+    image_header header;
+    if (image.size() < sizeof(header)) invalid_image(file, "truncated header");
+    std::memcpy(&header, image.data(), sizeof(header));
+
+    if (auto why = check_header(header, image.size())) invalid_image(file, why);
+    if (verify) {
+        if (header.body_hash != hash_key({image.data() + sizeof(header), header.size - sizeof(header)}))
+            invalid_image(file, "corrupt body");
+        if (auto why = check_tables(header, image.data())) invalid_image(file, why);
+    }
+
+    return {static_cast<std::size_t>(header.entries),
+            image.data() + header.keys,
+            image.data() + header.values,
+            header.source,
+            image.data(),
+            static_cast<std::size_t>(header.values + header.entries * sizeof(string_ref)),
+            static_cast<std::size_t>(header.size),
+            file};
+}
+
+bool
+read_image_source(const std::filesystem::path& image, image_source& source) {
+    std::ifstream ifs(image, std::ios::binary | std::ios::ate);
+    if (!ifs.is_open()) return false;
+    auto available = static_cast<std::size_t>(ifs.tellg());
+
+    image_header header;
+    if (available < sizeof(header)
+        || !ifs.seekg(0).read(reinterpret_cast<char*>(&header), sizeof(header))
+        || check_header(header, available))
+        return false;
+    source = header.source;
+    return true;
+}
+
+void
+write_config_image(const std::filesystem::path& file,
+                   const std::vector<std::pair<std::string_view, std::string_view>>& entries,
+                   const image_source& source) {
+    image_header header{};
+    std::memcpy(header.magic, image_magic, sizeof(image_magic));
+    header.version = config_image_version;
+    header.byte_order = byte_order_mark;
+    header.entries = entries.size();
+    header.keys = sizeof(header);
+    header.values = header.keys + entries.size() * sizeof(string_ref);
+
+    auto arena_at = header.values + entries.size() * sizeof(string_ref);
+    auto size = arena_at;
+    for (const auto& ent : entries) size += ent.first.size() + ent.second.size() + 2;
+    if (size > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("configuration too large: " + file.string());
+
+    // a mapped image needs a zero byte past its end, which an image filling its last page lacks;
+    // an image ending inside a 4 KiB page ends inside a page of any larger size too
+    std::string image(size % min_page_size == 0 ? size + 1 : size, '\0');
+    auto append = [&image, &arena_at](std::string_view str) {
+        string_ref ref{static_cast<std::uint32_t>(arena_at), static_cast<std::uint32_t>(str.size())};
+        std::memcpy(&image[arena_at], str.data(), str.size());
+        arena_at += str.size() + 1;
+        return ref;
+    };
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        auto key = append(entries[i].first);
+        auto value = append(entries[i].second);
+        std::memcpy(&image[header.keys + i * sizeof(string_ref)], &key, sizeof(key));
+        std::memcpy(&image[header.values + i * sizeof(string_ref)], &value, sizeof(value));
+    }
+
+    header.size = size;
+    header.source = source;
+    header.body_hash = hash_key({image.data() + sizeof(header), size - sizeof(header)});
+    header.header_hash = hash_header(header);
+    std::memcpy(&image[0], &header, sizeof(header));
+
+    // concurrent writers of the same image each write their own file
+    auto partial = file;
+    partial += ".partial-" + std::to_string(std::random_device{}() ^ static_cast<std::uint64_t>(
+                                     std::chrono::steady_clock::now().time_since_epoch().count()));
+    {
+        std::ofstream ofs(partial, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) throw std::invalid_argument("invalid_file " + partial.string());
+        if (!ofs.write(image.data(), static_cast<std::streamsize>(image.size())).flush()) {
+            ofs.close();
+            std::filesystem::remove(partial);
+            throw std::invalid_argument("invalid_file " + partial.string());
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(partial, file, ec);
+    if (ec) {
+        // the temporary file is not left behind, not even when the target cannot be replaced
+        std::filesystem::remove(partial, ec);
+        throw std::invalid_argument("invalid_file " + file.string());
+    }
+}
@@ -0,0 +1,208 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file config_image.hpp
+ * \brief Declares the functions reading and writing compiled configuration images
+ *
+ * A compiled image holds the entries of a configuration in the layout config_set uses in memory, so
+ * it can be mapped and used without parsing.
+ *
+ * The image starts with a 104-byte header: a magic number, the format version, a byte order mark,
+ * the number of entries, the offsets of the tables, the size of the image, the identity of the file
+ * the image was compiled from, if it was recorded, and the hashes of the body and of the header
+ * itself.
+ * The header is followed by the table of the key references, sorted by key, then the table of the
+ * value references, in the same order, both made of string_ref objects.
+ * The rest of the image is the arena: the bytes of all keys and values, each followed by a NUL byte.
+ * The references are offsets from the start of the image, so the whole image is the arena of the
+ * config_set using it.
+ * All numbers are stored in the byte order of the machine compiling the image.
+ */
+
+#ifndef CONFY_CONFIG_IMAGE_HPP
+#define CONFY_CONFIG_IMAGE_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/filesystem>
+#  include <experimental/string_view>
+#  define filesystem experimental::filesystem
+#  define string_view experimental::string_view
+#else
+#  include <filesystem>
+#  include <string_view>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "config.hpp"
+#include "source_buffer.hpp"
+
+/// The version of the image format written by write_config_image
+constexpr std::uint32_t config_image_version = 2;
+
+/**
+ * \brief Tag selecting the config_set constructor opening a compiled image
+ */
+struct compiled_image_t {
+    explicit compiled_image_t() = default;
+};
+
+/// The tag selecting the config_set constructor opening a compiled image
+constexpr compiled_image_t compiled_image{};
+
+/**
+ * \brief The identity of the file an image was compiled from
+ *
+ * Recorded in images used as caches, to tell whether the file has changed since.
+ * All fields are zero in images whose source was not recorded.
+ */
+struct image_source {
+    std::uint64_t path = 0;   ///< The hash of the canonical path of the file
+    std::uint64_t size = 0;   ///< The size of the file
+    std::int64_t mtime = 0;   ///< The last modification time of the file, in file clock ticks
+    std::uint64_t hash = 0;   ///< The hash of the contents of the file
+    std::int64_t checked = 0; ///< The time the contents were hashed, in file clock ticks
+};
+
+/**
+ * \brief The tables of an opened image
+ *
+ * Refers to the tables of an image held by a source_buffer, valid as long as the buffer is.
+ * Every reference is checked as it is read, so even an unverified image never makes its users read
+ * outside the buffer.
+ */
+struct config_image {
+    std::size_t entries;        ///< The number of entries
+    const char* keys;           ///< The first byte of the table of key references
+    const char* values;         ///< The first byte of the table of value references
+    image_source source;        ///< The identity of the file the image was compiled from
+    const char* data;           ///< The first byte of the image
+    std::size_t arena;          ///< The offset of the arena
+    std::size_t size;           ///< The size of the image, without the padding
+    std::filesystem::path file; ///< The file the image was loaded from, used in error messages
+
+    /**
+     * \brief Returns the reference to a key
+     *
+     * If the reference does not point to a NUL-terminated string of the arena, an
+     * `std::invalid_argument` exception is thrown.
+     *
+     * \param idx The index of the entry
+     * \return The reference to the key of the entry, in the arena of the image
+     */
+    string_ref
+    key(std::size_t idx) const;
+
+    /**
+     * \brief Returns the reference to a value
+     *
+     * If the reference does not point to a NUL-terminated string of the arena, an
+     * `std::invalid_argument` exception is thrown.
+     *
+     * \param idx The index of the entry
+     * \return The reference to the value of the entry, in the arena of the image
+     */
+    string_ref
+    value(std::size_t idx) const;
+};
+
+/**
+ * \brief Checks whether a file is a compiled image
+ *
+ * Only reads the magic number at the start of the file.
+ *
+ * \param file The file to check
+ * \return Whether the file starts like a compiled image, false if it cannot be read.
+ */
+bool
+is_config_image(const std::filesystem::path& file);
+
+/**
+ * \brief Opens an image
+ *
+ * Checks the header of the image, in constant time: its magic number, version, byte order, and
+ * hash, and that the tables it describes fit the buffer.
+ * The tables are not read; config_image checks each reference when it is read.
+ * If verify is set, the hash of the whole body is checked too, and so are the tables: every
+ * reference must point to a NUL-terminated string inside the image, and the keys must be strictly
+ * increasing. This takes time linear in the size of the image.
+ * If any check fails, an `std::invalid_argument` exception is thrown.
+ *
+ * \param image The buffer holding the image
+ * \param file The file the image was loaded from, used in error messages
+ * \param verify Whether to check the hash of the body
+ * \return The tables of the image
+ */
+config_image
+open_config_image(const source_buffer& image, const std::filesystem::path& file, bool verify);
+
+/**
+ * \brief Reads the source identity of an image
+ *
+ * Only reads and checks the header of the image.
+ *
+ * \param image The image file
+ * \param source The object receiving the identity recorded in the image
+ * \return Whether the file is a valid image of the current version, false if it cannot be read.
+ */
+bool
+read_image_source(const std::filesystem::path& image, image_source& source);
+
+/**
+ * \brief Writes an image
+ *
+ * Lays out the entries as described in config_image.hpp and writes them to the file.
+ * The image is written to a uniquely named temporary file next to the target first, then renamed
+ * over it, so readers opening the target never see a partially written image, even if several
+ * writers replace it at once.
+ *
+ * If the file cannot be written, an `std::invalid_argument` exception is thrown; if the image
+ * would be too large to be addressed by string_ref, an `std::length_error`.
+ *
+ * \param file The file to write
+ * \param entries The keys and values of the entries, sorted by key, with unique keys
+ * \param source The identity of the file the entries were read from, to record in the image
+ */
+void
+write_config_image(const std::filesystem::path& file,
+                   const std::vector<std::pair<std::string_view, std::string_view>>& entries,
+                   const image_source& source = {});
+
+#endif
@@ -31,11 +31,22 @@
 
 /**
  * \file config_set.cpp
- * \brief This file is mostly useless. Used as compilation check.
+ * \brief Used as compilation check, and implements the set generations.
  *
  * This file would be used to implement the config_set class, however, it is a template.
- * Its sole purpose is to allow us to make sure that config_set.hpp can be compiled without
+ * Its main purpose is to allow us to make sure that config_set.hpp can be compiled without
  * including anything before it.
+ * It also holds the counter of the set generations.
  */
 
 #include "config_set.hpp"
+
+#include <atomic>
+
+#include "memtrace.h"
+
+std::uint64_t
+next_set_generation() noexcept {
+    static std::atomic<std::uint64_t> generation{0};
+    return generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
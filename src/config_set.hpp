@@ -50,27 +50,53 @@
 
 #ifdef USE_CXX17
 #  include <experimental/filesystem>
+#  include <experimental/optional>
 #  include <experimental/string_view>
+#  define optional experimental::optional
 #  define string_view experimental::string_view
 #  define filesystem experimental::filesystem
 #else
 #  include <filesystem>
+#  include <optional>
 #  include <string_view>
 #endif
 
-#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
 #include <fstream>
 #include <istream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
 #include <numeric>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "bad_key.hpp"
+#include "bad_syntax.hpp"
+#include "batch_result.hpp"
 #include "config.hpp"
+#include "config_diff.hpp"
+#include "config_image.hpp"
+#include "config_handle.hpp"
+#include "key_index.hpp"
 #include "parser.hpp"
+#include "prefetch.hpp"
+#include "scanner.hpp"
+#include "sorted_index.hpp"
+#include "source_buffer.hpp"
+#include "type_id.hpp"
 
 #ifdef USE_CXX17
 #  define parser class
+#  define key_index class
 #endif
 
 /**
@@ -81,9 +107,25 @@
  * After reading and parsing, the key-value entries will be made available to the user for query in
  * a read-only fashion.
  *
+ * The bytes of all keys and values are stored in one contiguous arena: the mapped file, or a single
+ * heap buffer.
+ * The entries refer to the arena with 32-bit offsets and lengths: the keys, which lookups compare,
+ * are kept in one compact array, while the values and their caches are kept in another.
+ *
+ * The entries are looked up through a key index, which is sorted_index by default.
+ * Sets that are read very often may use perfect_hash_index instead, which costs more to build, but
+ * answers lookups with a single key comparison, or swiss_index, a hash table which uses more memory,
+ * but rejects absent keys fastest.
+ * eytzinger_index keeps the sorted semantics of the default, but searches a cache-friendly array of
+ * key prefixes instead of the keys themselves.
+ *
+ * A loaded set may be compiled into an image file, laid out like the set in memory, which later
+ * opens without any parsing; see config_image.hpp.
+ *
  * \tparam P The type of the parser object to parse configuration with
+ * \tparam I The type of the key index to look up entries with
  */
-template<parser P>
+template<parser P, key_index I = sorted_index>
 struct config_set {
     /**
      * \brief Reads the configuration from a file
@@ -92,14 +134,20 @@ struct config_set {
      * When using this constructor, error messages will contain the name of the file given here, for
      * easier interpretation of error diagnostics.
      *
+     * If the parser supports parsing from a buffer, the file is memory-mapped, and the entries refer
+     * directly to the mapped bytes, so no per-entry copies are made.
+     * The mapping lives as long as the config_set.
+     *
+     * If more than one thread is requested, and the parser can also be started from an arbitrary
+     * line, the file is split into chunks at line boundaries, and the chunks are parsed in parallel.
+     * The results and the reported errors are the same as with a single thread.
+     *
      * \param file The configuration file
+     * \param threads The maximum number of threads to parse the file with
      */
-    explicit config_set(const std::filesystem::path& file)
+    explicit config_set(const std::filesystem::path& file, unsigned threads = 1)
          : _file(file) {
-        std::ifstream ifs(file);
-        if (!ifs.is_open())
-            throw std::invalid_argument("invalid_file " + _file.string());
-        parse_stream(ifs);
+        load_file(is_view_parser<P>{}, threads);
     }
 
     /**
@@ -109,30 +157,423 @@ struct config_set {
      * While this allows any generic istream to be used as an input, the name of the file will be
      * lost, therefore, this will result in lower-quality error diagnostics.
      *
+     * If the parser supports parsing from a buffer, the stream is read into a buffer first, and the
+     * entries refer to it, so no per-entry copies are made.
+     *
      * \param strm The stream to read from
      */
     explicit config_set(std::istream& strm) {
-        parse_stream(strm);
+        load_stream(is_view_parser<P>{}, strm);
+    }
+
+    /**
+     * \brief Parses a configuration already read into a buffer
+     *
+     * Like the file constructor, but parses the given buffer, and only uses the file name for error
+     * diagnostics.
+     * Used to load the contents of a file read with source_buffer::read, which, unlike a mapping, is
+     * not affected if the file is rewritten while the set is alive.
+     *
+     * \param src The contents of the configuration file
+     * \param file The name of the configuration file
+     * \param threads The maximum number of threads to parse the buffer with
+     */
+    config_set(source_buffer src, const std::filesystem::path& file, unsigned threads = 1)
+         : _file(file) {
+        load_buffer(is_view_parser<P>{}, std::move(src), threads);
+    }
+
+    /**
+     * \brief Reads the configuration from a file, deferring the parsing of the values
+     *
+     * Like the file constructor, but if the parser supports it, only the keys are parsed while
+     * loading: each value is parsed when it is first accessed, so values that are never read are
+     * never parsed.
+     * Malformed keys and repeated keys are still reported by the constructor; a malformed value is
+     * reported by the first accessor that reaches it, with the same `bad_syntax` exception the file
+     * constructor would have thrown.
+     * Call validate_all to check every value at once.
+     *
+     * Parsers that cannot parse keys alone load the file like the file constructor does.
+     *
+     * \param file The configuration file
+     * \param threads The maximum number of threads to parse the file with
+     */
+    config_set(lazy_values_t, const std::filesystem::path& file, unsigned threads = 1)
+         : _file(file),
+           _lazy(is_lazy_parser<P>::value) {
+        load_file(is_view_parser<P>{}, threads);
+    }
+
+    /**
+     * \brief Opens a compiled image
+     *
+     * Maps an image written by compile, and uses its tables and arena as they are: nothing is parsed,
+     * and the keys, which the image stores sorted, are not sorted again.
+     * Opening the image only checks its header, in constant time; the references of the entries are
+     * bounds-checked as the set reads them, while its entries are stored.
+     * If verify is set, the hash of the whole image and the order of its keys are checked too, in
+     * time linear in the size of the image.
+     * Key indices keeping the entries sorted, like the default sorted_index, are built without
+     * looking at the keys; other indices are built from the stored keys.
+     *
+     * If the image cannot be opened, or its checks fail, an `std::invalid_argument` exception is
+     * thrown.
+     *
+     * \param image The compiled image file
+     * \param verify Whether to check the hash of the whole image
+     */
+    config_set(compiled_image_t, const std::filesystem::path& image, bool verify = false)
+         : _file(image) {
+        adopt_source(source_buffer(image));
+        store_image(open_config_image(_source, _file, verify));
     }
 
     template<class T>
     auto
     get(std::string_view key) const {
-        const auto& cfg = _configs;
+        return value_at(position_of(key)).template get_as<T>(_source.data());
+    }
+
+    /**
+     * \brief Tries to get a value
+     *
+     * Looks up the key, and converts its value to T, like get, but never throws for a missing key or
+     * a value that cannot be converted: both result in an empty optional.
+     * A miss neither allocates nor unwinds, so probing for optional keys is cheap.
+     *
+     * \tparam T The type to get the value as
+     * \param key The key to look up
+     * \return The converted value, or an empty optional.
+     */
+    template<class T>
+    std::optional<T>
+    try_get(std::string_view key) const {
+        auto pos = find_position(key);
+        if (pos == I::npos) return {};
+        return value_at(pos).template try_get_as<T>(_source.data());
+    }
+
+    /**
+     * \brief Reads a value without writing the set
+     *
+     * Like try_get, but never fills the caches: the cached conversion to T is returned, if the entry
+     * has one, otherwise the value is converted into a new object.
+     * As nothing is written, any number of threads may call read, key_at, and size on the same set
+     * at once, as long as no thread uses the other accessors meanwhile; see config_snapshots.
+     *
+     * Lazily loaded values must be parsed before being read, by validate_all, or an
+     * `std::logic_error` exception is thrown.
+     *
+     * \tparam T The type to get the value as
+     * \param key The key to look up
+     * \return The converted value, or an empty optional.
+     */
+    template<class T>
+    std::optional<T>
+    read(std::string_view key) const {
+        auto pos = find_position(key);
+        if (pos == I::npos) return {};
+        if (!_raw.empty() && is_raw(pos))
+            throw std::logic_error("unparsed value read: " + std::string(key.data(), key.size()));
+        return _configs[pos].template read_as<T>(_source.data());
+    }
+
+    /**
+     * \brief Gets a value, or a fallback
+     *
+     * Like try_get, but returns the given fallback, if the key is missing, or its value cannot be
+     * converted.
+     *
+     * \tparam T The type to get the value as
+     * \param key The key to look up
+     * \param fallback The value to return if the key has no value of type T
+     * \return The converted value, or the fallback.
+     */
+    template<class T>
+    T
+    get_or(std::string_view key, T fallback) const {
+        auto value = try_get<T>(key);
+        if (!value) return fallback;
+        return std::move(*value);
+    }
+
+    /**
+     * \brief Reads a value through a handle
+     *
+     * Checks that the handle was resolved from the currently loaded entries of this set, and returns
+     * the value it refers to.
+     * If the handle is stale, or empty, an `std::out_of_range` exception is thrown.
+     *
+     * \tparam T The type of the value
+     * \param handle The handle returned by resolve
+     * \return The value of the entry
+     */
+    template<class T>
+    const T&
+    get(const config_handle<T>& handle) const {
+        if (handle.generation() != _generation) throw std::out_of_range("stale config handle used");
+        return *handle;
+    }
+
+    /**
+     * \brief Resolves a key into a handle
+     *
+     * Looks up the key, and converts its value to T once, so later reads through the returned
+     * handle need neither a search nor a conversion.
+     * The converted value is pinned by the set: it is not affected by conversions of the entry to
+     * other types, and lives as long as the set.
+     * The value is pinned once per entry and type; resolving the key again returns a handle to the
+     * same value.
+     *
+     * Handles must not outlive the set: only their generation is checked, so reading through a
+     * handle of a destroyed (or reassigned) set reads freed memory.
+     *
+     * If the key is not in the set, an `std::out_of_range` exception is thrown; if the value cannot
+     * be converted to T, the same exception is thrown as by get.
+     *
+     * \tparam T The type to get the value as
+     * \param key The key to resolve
+     * \return The handle of the value
+     */
+    template<class T>
+    config_handle<T>
+    resolve(std::string_view key) const {
+        auto pos = position_of(key);
+        auto type = visit_index<T>;
+        auto tid = type_id::id_of<T>();
+        auto unindexed = std::find_if(_unindexed_pins.begin(), _unindexed_pins.end(), [pos, tid](const unindexed_pin& pin) {
+            return pin.pos == pos && pin.type == tid;
+        });
+        if (unindexed != _unindexed_pins.end())
+            return config_handle<T>(static_cast<const T*>(unindexed->value.get()), pos, _generation);
+        if (type == 0) {
+            // during the dynamic initialization, the visit index of T may not be assigned yet
+            const auto& pin = _unindexed_pins.emplace_back(unindexed_pin{pos, tid, value_at(pos).template pin_as<T>(_source.data())});
+            return config_handle<T>(static_cast<const T*>(pin.value.get()), pos, _generation);
+        }
+        auto& pinned = _pinned[std::make_pair(pos, type)];
+        if (!pinned) pinned = value_at(pos).template pin_as<T>(_source.data());
+        return config_handle<T>(static_cast<const T*>(pinned.get()), pos, _generation);
+    }
+
+    /**
+     * \brief Checks whether a handle is current
+     *
+     * \tparam T The type of the value
+     * \param handle The handle to check
+     * \return Whether the handle was resolved from the currently loaded entries of this set.
+     */
+    template<class T>
+    bool
+    is_current(const config_handle<T>& handle) const noexcept { return handle.generation() == _generation; }
+
+    /**
+     * \brief Getter for the generation of the set
+     *
+     * The generation identifies the loaded entries; handles resolved from other generations are
+     * stale.
+     *
+     * \return The generation of the loaded entries
+     */
+    std::uint64_t
+    generation() const noexcept { return _generation; }
+
+    /**
+     * \brief Looks up a batch of keys at once
+     *
+     * Finds all keys of the batch, and returns their values, converted to T, in one contiguous
+     * array, in the order of the keys.
+     * Keys not in the set do not throw, but are marked missing in the result.
+     * Values that cannot be converted to T throw, just like with get.
+     *
+     * If the key index supports it, the lookups of the batch are interleaved, so their cache misses
+     * overlap; otherwise the keys are looked up one by one.
+     *
+     * \tparam T The type to get the values as
+     * \param keys The keys to look up
+     * \return The values of the keys and the mask of the keys found
+     */
+    template<class T>
+    auto
+    get_many(key_batch_t keys) const {
+        using value_type = std::decay_t<decltype(std::declval<const config&>().get_as<T>(nullptr))>;
+
+        std::vector<std::size_t> positions(keys.size());
+        find_positions(is_batched_key_index<I>{}, keys.data(), keys.size(), positions.data());
+        for (auto pos : positions) {
+            if (pos != I::npos) prefetch(&_configs[pos]);
+        }
+
+        batch_result<value_type> result(keys.size());
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            if (positions[i] != I::npos)
+                result.set(i, value_at(positions[i]).template get_as<T>(_source.data()));
+        }
+        return result;
+    }
+
+    /**
+     * \brief Carries the caches of an earlier load over
+     *
+     * Matches the entries of the set to the entries of an earlier load of the same configuration, in
+     * one linear merge of the two sequences sorted by key, and moves the caches of the entries whose
+     * value did not change into ours, so their conversions are not repeated.
+     * The entries of sets kept in key order, like with the default sorted_index, are merged as they
+     * are; the others are sorted by key first.
+     * Lazily loaded values of either set are parsed to be compared; malformed ones count as changed.
+     *
+     * Call it right after loading the set, before reading it: caches of our entries are replaced.
+     * Handles resolved from the earlier load are not carried over, they stay stale.
+     *
+     * \param previous The earlier load, whose caches are left empty
+     * \return The differences between the earlier load and the set
+     */
+    config_diff
+    carry_over(config_set& previous) {
+        auto ours = key_order();
+        auto theirs = previous.key_order();
+        config_diff diff;
+        auto lhs = ours.begin();
+        auto rhs = theirs.begin();
+        while (lhs != ours.end() && rhs != theirs.end()) {
+            auto dir = key_at(*lhs).compare(previous.key_at(*rhs));
+            if (dir < 0) {
+                ++diff.added;
+                ++lhs;
+            } else if (dir > 0) {
+                ++diff.removed;
+                ++rhs;
+            } else {
+                auto value = try_value_at(*lhs);
+                auto old_value = previous.try_value_at(*rhs);
+                if (value && old_value && *value == *old_value) {
+                    _configs[*lhs].adopt_caches(previous._configs[*rhs]);
+                    ++diff.unchanged;
+                } else {
+                    ++diff.changed;
+                }
+                ++lhs;
+                ++rhs;
+            }
+        }
+        diff.added += static_cast<std::size_t>(ours.end() - lhs);
+        diff.removed += static_cast<std::size_t>(theirs.end() - rhs);
+        return diff;
+    }
+
+    /**
+     * \brief Compiles the set into an image
+     *
+     * Writes the entries into an image file, which the compiled_image constructor opens without
+     * parsing.
+     * The file is replaced atomically, so processes opening it concurrently see either the old or
+     * the new image.
+     * The values of a lazily loaded set are validated first, see validate_all.
+     *
+     * \param image The file to write the image to
+     * \param source The identity of the file the set was loaded from, to record in the image
+     */
+    void
+    compile(const std::filesystem::path& image, const image_source& source = {}) const {
+        validate_all();
+        std::vector<std::pair<std::string_view, std::string_view>> entries;
+        entries.reserve(_configs.size());
+        for (std::size_t i = 0; i < _configs.size(); ++i) {
+            entries.emplace_back(key_at(i), _configs[i].get_value(_source.data()));
+        }
+        auto by_key = [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        };
+        // only the hashing indices store the entries out of order
+        if (!std::is_sorted(entries.begin(), entries.end(), by_key)) std::sort(entries.begin(), entries.end(), by_key);
+        write_config_image(image, entries, source);
+    }
+
+    /**
+     * \brief Converts every entry at once
+     *
+     * Converts the values of all entries to T in one linear pass over the entries, into one
+     * contiguous column, in the order of the entries: the value at index i is the value of key_at(i).
+     * Values that cannot be converted do not throw, but are marked missing in the result, so the
+     * failures are the cleared bits of its mask.
+     * Built-in values are parsed without being cached in the entries, the column holds them instead.
+     *
+     * Sets with many entries are split into ranges of whole mask words, which are converted on
+     * separate threads.
+     *
+     * \tparam T The type to get the values as
+     * \param threads The maximum number of threads to convert with
+     * \return The values of the entries and the mask of the converted ones
+     */
+    template<class T>
+    auto
+    get_all_as(unsigned threads = 1) const {
+        return convert_all<T>([](std::string_view) { return true; }, threads);
+    }
 
-        return callback_binary_search(
-               _configs,
-               [&key](const config& cfg) {
-                   return std::strcmp(cfg.get_key().data(), key.data());
-               },
-               [&cfg](std::size_t, std::size_t middle, std::size_t) -> decltype(auto) {
-                   return cfg[middle].template get_as<T>();
-               },
-               [&key](auto&&...) -> T {
-                   throw std::out_of_range("invalid key looked up: " + std::string(key));
-               });
+    /**
+     * \brief Converts the entries of the selected keys at once
+     *
+     * Like get_all_as, but only converts the values whose keys satisfy the predicate; the other
+     * entries are left missing in the result, the same as values that cannot be converted.
+     * The result still has an element for every entry, in the order of the entries.
+     *
+     * \tparam T The type to get the values as
+     * \tparam Pred The type of the predicate selecting the keys.
+     * \param select The predicate called with each key, which returns whether to convert its value
+     * \param threads The maximum number of threads to convert with
+     * \return The values of the entries and the mask of the converted ones
+     */
+    template<class T, class Pred,
+             class = std::enable_if_t<std::is_invocable<Pred&, std::string_view>::value>>
+    auto
+    get_all_as(Pred select, unsigned threads = 1) const {
+        return convert_all<T>(select, threads);
+    }
+
+    /**
+     * \brief Parses every value not parsed yet
+     *
+     * Makes a lazily loaded set report its syntax errors eagerly: parses all values that have not
+     * been accessed yet, and throws the `bad_syntax` exception of the malformed line that comes first
+     * in the file, if there is one.
+     * Values parsed successfully stay parsed even if another value is malformed.
+     * Sets loaded eagerly have no values left to parse.
+     */
+    void
+    validate_all() const {
+        if (_raw.empty()) return;
+        auto first_bad = _configs.size();
+        for (std::size_t pos = 0; pos < _configs.size(); ++pos) {
+            if (!is_raw(pos)) continue;
+            try {
+                settle(pos);
+            } catch (...) {
+                // the entries are in index order, so the file order is that of their lines
+                if (first_bad == _configs.size()
+                    || _configs[pos].get_value(_source.data()).data() < _configs[first_bad].get_value(_source.data()).data())
+                    first_bad = pos;
+            }
+        }
+        // a malformed line stays raw, so settling it again rethrows its error
+        if (first_bad != _configs.size()) settle(first_bad);
+        _raw = {};
+        _lines = {};
     }
 
+    /**
+     * \brief Returns the key of an entry
+     *
+     * The entries are in the order of the columns returned by get_all_as, which depends on the key
+     * index used.
+     *
+     * \param idx The index of the entry, less than size()
+     * \return The key of the entry
+     */
+    std::string_view
+    key_at(std::size_t idx) const noexcept { return _keys[idx].in(_source.data()); }
+
     /**
      * \brief Getter for the size of the configuration set
      *
@@ -144,81 +585,663 @@ struct config_set {
     size() const noexcept { return _configs.size(); }
 
 private:
+    /**
+     * \brief A value referred to by handles, whose type had no visit index when it was resolved
+     */
+    struct unindexed_pin {
+        std::size_t pos;                   ///< The position of the entry
+        type_id type;                      ///< The type of the value
+        std::shared_ptr<const void> value; ///< The value
+    };
+
+    /**
+     * \brief Returns the value of an entry, parsing it first if it was loaded lazily
+     *
+     * \param pos The position of the entry
+     * \return The value of the entry
+     */
+    const config&
+    value_at(std::size_t pos) const {
+        if (!_raw.empty() && is_raw(pos)) settle(pos);
+        return _configs[pos];
+    }
+
+    /**
+     * \brief Returns the value of an entry, if it is well-formed
+     *
+     * \param pos The position of the entry
+     * \return The raw value of the entry, or an empty optional, if it is lazily loaded and malformed.
+     */
+    std::optional<std::string_view>
+    try_value_at(std::size_t pos) const {
+        try {
+            return value_at(pos).get_value(_source.data());
+        } catch (const bad_syntax&) {
+            return {};
+        }
+    }
+
+    /**
+     * \brief Returns the positions of the entries in key order
+     *
+     * \return The positions of the entries, sorted by their keys
+     */
+    std::vector<std::size_t>
+    key_order() const {
+        std::vector<std::size_t> order(_keys.size());
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        auto by_key = [this](std::size_t lhs, std::size_t rhs) {
+            return key_at(lhs) < key_at(rhs);
+        };
+        if (!std::is_sorted(order.begin(), order.end(), by_key)) std::sort(order.begin(), order.end(), by_key);
+        return order;
+    }
+
+    /**
+     * \brief Checks whether the line of an entry still waits to be parsed
+     */
+    bool
+    is_raw(std::size_t pos) const noexcept { return (_raw[pos / 64] >> (pos % 64)) & 1; }
+
+    /**
+     * \brief Parses the line of a lazily loaded entry
+     *
+     * Points the entry to its value, and terminates the key and the value in place, like an eager
+     * load would.
+     * Lines are parsed from the first line of the file, as the line number is only needed for the
+     * error message: if parsing fails, the line is read and parsed again by a parser started where
+     * the parser of the load was, to throw the same exception as an eager load.
+     * The line numbers are recorded while loading, as settling overwrites line endings.
+     * Entries of different mask words may be settled on different threads at once.
+     *
+     * \param pos The position of the entry
+     */
+    void
+    settle([[maybe_unused]] std::size_t pos) const {
+        // only lazy parsers load raw entries
+        if constexpr (is_lazy_parser<P>::value) {
+            auto line = _configs[pos].get_value(_source.data());
+            std::pair<std::string_view, std::string_view> conf;
+            try {
+                conf = make_parser(1).parse_line_view(line);
+            } catch (...) {
+                auto parse = make_parser(static_cast<int>(_lines[pos]));
+                auto rest = line;
+                parse.next_line_view(rest);
+                parse.parse_line_view(line);
+                throw;
+            }
+            terminate(conf.first);
+            _configs[pos].settle(ref_of(terminate(conf.second)));
+            _raw[pos / 64] &= ~(std::uint64_t{1} << (pos % 64));
+        }
+    }
+
+    /**
+     * \brief Finds the position of a key
+     *
+     * \return The position of the key, or I::npos, if it is not in the set.
+     */
+    std::size_t
+    find_position(std::string_view key) const {
+        return _index.find(key, [this](std::size_t idx) {
+            return _keys[idx].in(_source.data());
+        });
+    }
+
+    /**
+     * \brief Finds the position of a key
+     *
+     * If the key is not in the set, an `std::out_of_range` exception is thrown.
+     */
+    std::size_t
+    position_of(std::string_view key) const {
+        auto pos = find_position(key);
+        if (pos == I::npos)
+            throw std::out_of_range("invalid key looked up: " + std::string(key.data(), key.size()));
+        return pos;
+    }
+
+    /**
+     * \brief Finds the positions of a batch of keys with a batched key index
+     */
+    void
+    find_positions(std::true_type, const std::string_view* keys, std::size_t count, std::size_t* out) const {
+        _index.find_many(keys, count, out, [this](std::size_t idx) {
+            return _keys[idx].in(_source.data());
+        });
+    }
+
+    /**
+     * \brief Finds the positions of a batch of keys one by one
+     */
+    void
+    find_positions(std::false_type, const std::string_view* keys, std::size_t count, std::size_t* out) const {
+        for (std::size_t i = 0; i < count; ++i) out[i] = find_position(keys[i]);
+    }
+
+    /**
+     * \brief Converts the values of the selected entries into a column
+     *
+     * Splits the entries into at most threads ranges, each a multiple of 64 entries long except the
+     * last, so no two ranges share a word of the mask, and fills them in parallel.
+     * A range is only given its own thread if it is at least min_column_chunk entries long.
+     */
+    template<class T, class Pred>
+    auto
+    convert_all(Pred&& select, unsigned threads) const {
+        using value_type = std::decay_t<decltype(*std::declval<const config&>().template peek_as<T>(nullptr))>;
+
+        batch_result<value_type> result(_configs.size());
+        auto chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, _configs.size() / min_column_chunk));
+        auto chunk_size = ((_configs.size() + chunks - 1) / chunks + 63) / 64 * 64;
+        run_parallel(chunks, [this, &select, &result, chunk_size](std::size_t i) {
+            auto first = std::min(i * chunk_size, _configs.size());
+            auto last = std::min(first + chunk_size, _configs.size());
+            result.fill(first, last, [this, &select](std::size_t idx) -> std::optional<value_type> {
+                if (!select(key_at(idx))) return {};
+                try {
+                    return value_at(idx).template peek_as<T>(_source.data());
+                } catch (const std::exception&) {
+                    return {};
+                }
+            });
+        });
+        result.recount();
+        return result;
+    }
+
+    void
+    load_file(std::true_type, unsigned threads) {
+        load_buffer(std::true_type{}, source_buffer(_file), threads);
+    }
+
+    void
+    load_file(std::false_type, unsigned) {
+        std::ifstream ifs(_file);
+        if (!ifs.is_open())
+            throw std::invalid_argument("invalid_file " + _file.string());
+        parse_stream(ifs);
+    }
+
+    void
+    load_buffer(std::true_type, source_buffer src, unsigned threads) {
+        adopt_source(std::move(src));
+        if constexpr (std::is_constructible<P, const std::filesystem::path&, int>::value) {
+            auto chunks = std::min<std::size_t>(threads, _source.size() / min_chunk_size);
+            if (chunks > 1) return parse_source_parallel(chunks);
+        }
+        parse_source();
+    }
+
+    void
+    load_buffer(std::false_type, source_buffer src, unsigned) {
+        std::istringstream iss(std::string(src.data(), src.size()));
+        parse_stream(iss);
+    }
+
+    void
+    load_stream(std::true_type, std::istream& strm) {
+        adopt_source(source_buffer(strm));
+        parse_source();
+    }
+
+    void
+    load_stream(std::false_type, std::istream& strm) {
+        parse_stream(strm);
+    }
+
+    /**
+     * \brief Takes over a source buffer
+     *
+     * Throws an \`std::length_error\` if the buffer is too large to be addressed by string_ref.
+     *
+     * \param src The source buffer to use
+     */
+    void
+    adopt_source(source_buffer src) {
+        if (src.size() > max_arena_size)
+            throw std::length_error("configuration too large: " + _file.string());
+        _source = std::move(src);
+    }
+
+    /**
+     * \brief Parses a stream with the copying parser interface
+     *
+     * Reads the stream line by line, appending the parsed keys and values to one string, each
+     * followed by a NUL byte.
+     * The string becomes the source buffer, then the set is built from the collected entries at
+     * once.
+     *
+     * \param strm The stream to read from
+     */
     void
     parse_stream(std::istream& strm) {
-        auto parse = P(_file);
-        std::optional<std::string> maybe_next_ln;
-        while ((maybe_next_ln = parse.next_line(strm))) {
-            auto next_ln = maybe_next_ln.value();
-            auto conf = parse.parse_line(next_ln);
-            emplace_config(std::move(conf.first), std::move(conf.second));
-        }
-    }
-
-    /**
-     * \brief Universal callback-based binary search
-     *
-     * A callback oriented binary search. Searches the given vec vector and calls succ if it
-     * successfully finds an equal value, according to the given unary predicate cmpr.
-     * If it doesn't find anything searched, it calls fail.
-     * In all cases returns the return values of the callbacks, so they must have an equal return
-     * type.
-     *
-     * \tparam T The type of the container to search.
-     * \tparam CmprFn The type of the comparison unary predicate.
-     * \tparam SuccFn The type of the success function.
-     * \tparam FailFn The type of the failure function.
-     * \param vec The container to search in. Requires to have random access support.
-     * \param cmpr The unary predicate, that provides three way comparison.
-     * \param succ The function called if the search succeeds.
-     * \param fail The function called if the search fails.
-     * \return The return value of the called completion function.
-     */
-    template<class T, class CmprFn, class SuccFn, class FailFn>
-    static auto
-    callback_binary_search(const T& vec,
-                           CmprFn&& cmpr,
-                           SuccFn&& succ,
-                           FailFn&& fail) {
-        std::size_t begin = 0;
-        std::size_t middle;
-        std::size_t end = vec.size();
-        while (begin != end) {
-#ifndef USE_CXX17
-            middle = std::midpoint(begin, end);
-#else
-            middle = (end + begin) / 2;
-#endif
-            auto dir = std::forward<CmprFn>(cmpr)(vec[middle]);
-            if (dir == 0) {
-                return std::forward<SuccFn>(succ)(begin, middle, end);
-            } else if (dir < 0) {
-                begin = middle + 1;
-            } else if (dir > 0) {
-                end = middle;
+        std::string arena;
+        std::vector<std::pair<string_ref, string_ref>> refs;
+        auto append = [&arena](const std::string& str) {
+            string_ref ref{static_cast<std::uint32_t>(arena.size()), static_cast<std::uint32_t>(str.size())};
+            arena.append(str).push_back('\0');
+            return ref;
+        };
+
+        std::vector<chunk_result> results(1);
+        auto& res = results.front();
+        try {
+            auto parse = P(_file);
+            std::optional<std::string> maybe_next_ln;
+            while ((res.error_order = refs.size(), maybe_next_ln = parse.next_line(strm))) {
+                auto conf = parse.parse_line(maybe_next_ln.value());
+                if (arena.size() + conf.first.size() + conf.second.size() + 2 > max_arena_size)
+                    throw std::length_error("configuration too large: " + _file.string());
+                auto key = append(conf.first);
+                refs.emplace_back(key, append(conf.second));
+            }
+            res.error_order = no_error;
+        } catch (...) {
+            res.error = std::current_exception();
+        }
+
+        _source = source_buffer::copy_of(arena);
+        res.entries.reserve(refs.size());
+        for (std::size_t i = 0; i < refs.size(); ++i) {
+            res.entries.push_back({refs[i].first.in(_source.data()), refs[i].second.in(_source.data()), i});
+        }
+        std::sort(res.entries.begin(), res.entries.end(), &entry_less);
+        store_results(results);
+    }
+
+    /**
+     * \brief Parses the source buffer on the calling thread
+     *
+     * Parses the whole buffer as a single chunk, reserving space for as many entries as there are
+     * lines, then builds the set from the collected entries at once.
+     */
+    void
+    parse_source() {
+        std::vector<chunk_result> results(1);
+        auto buf = _source.view();
+        parse_chunk(buf, 1, count_newlines(buf.data(), buf.data() + buf.size()) + 1, results.front());
+        store_results(results);
+    }
+
+    /**
+     * \brief A parsed, not yet stored entry
+     *
+     * The order of the entry is any value that increases with the position of the entry in the
+     * input, such as its offset in the buffer.
+     */
+    struct entry {
+        std::string_view key;   ///< The key of the entry
+        std::string_view value; ///< The value of the entry
+        std::size_t order;      ///< The position of the entry in the input
+        std::uint32_t line = 0; ///< The line the parser was at before reading a lazily loaded entry
+    };
+
+    /// The error_order of chunks without an error
+    constexpr static std::size_t no_error = static_cast<std::size_t>(-1);
+
+    /**
+     * \brief The result of parsing one chunk of the input
+     *
+     * Contains the entries parsed from the chunk, sorted by key and then by order, and the error
+     * that stopped the parsing of the chunk, if any.
+     */
+    struct chunk_result {
+        std::vector<entry> entries;        ///< The sorted entries of the chunk
+        std::exception_ptr error{};        ///< The first error of the chunk
+        std::size_t error_order = no_error; ///< The order of the line the first error occurred on
+    };
+
+    /**
+     * \brief Orders entries by key, then by position in the input
+     *
+     * Sorting with this ordering keeps entries with equal keys in input order, exactly like a stable
+     * sort by key would.
+     *
+     * \param lhs The left-hand side entry
+     * \param rhs The right-hand side entry
+     * \return Whether lhs precedes rhs.
+     */
+    static bool
+    entry_less(const entry& lhs, const entry& rhs) noexcept {
+        auto dir = lhs.key.compare(rhs.key);
+        return dir < 0 || (dir == 0 && lhs.order < rhs.order);
+    }
+
+    /**
+     * \brief Runs a function for each index in [0, n) on separate threads
+     *
+     * Index 0 is run on the calling thread.
+     * Returns after all invocations have finished.
+     *
+     * \tparam Fn The type of the function to run.
+     * \param n The number of invocations
+     * \param fn The function to run, called with the index of the invocation
+     */
+    template<class Fn>
+    static void
+    run_parallel(std::size_t n, Fn&& fn) {
+        std::vector<std::thread> workers;
+        workers.reserve(n);
+        auto join_all = [&workers] {
+            for (auto& worker : workers) worker.join();
+        };
+        try {
+            for (std::size_t i = 1; i < n; ++i) {
+                workers.emplace_back([&fn, i] { fn(i); });
+            }
+            if (n > 0) fn(0);
+        } catch (...) {
+            join_all();
+            throw;
+        }
+        join_all();
+    }
+
+    /**
+     * \brief Splits the buffer into chunks at line boundaries
+     *
+     * Cuts the buffer into at most parts, roughly equal chunks.
+     * Each chunk, except maybe the last, ends with a line feed.
+     *
+     * \param buf The buffer to split
+     * \param parts The number of chunks to create
+     * \return The chunks in file order
+     */
+    static std::vector<std::string_view>
+    split_chunks(std::string_view buf, std::size_t parts) {
+        std::vector<std::string_view> chunks;
+        auto first = buf.data();
+        auto last = buf.data() + buf.size();
+        for (std::size_t i = 1; i <= parts && first != last; ++i) {
+            auto target = buf.data() + buf.size() / parts * i;
+            auto cut = last;
+            if (i != parts) {
+                cut = scan_newline(std::max(target, first), last);
+                if (cut != last) ++cut;
+            }
+            chunks.emplace_back(first, static_cast<std::size_t>(cut - first));
+            first = cut;
+        }
+        return chunks;
+    }
+
+    /**
+     * \brief Parses one chunk of the source buffer
+     *
+     * Parses the lines of the chunk, and sorts the entries found.
+     * The order of the entries is their offset in the source buffer.
+     * Parsing stops at the first error, which is stored in the result instead of being thrown.
+     *
+     * \param chunk The chunk to parse
+     * \param first_line The line number of the first line of the chunk
+     * \param lines The number of lines in the chunk, used to reserve space for the entries
+     * \param res The result to fill
+     */
+    void
+    parse_chunk(std::string_view chunk, int first_line, std::size_t lines, chunk_result& res) noexcept {
+        try {
+            res.entries.reserve(lines);
+            auto parse = make_parser(first_line);
+            auto line = first_line;
+            auto line_end = chunk.data();
+            std::optional<std::string_view> maybe_next_ln;
+            while ((maybe_next_ln = parse.next_line_view(chunk))) {
+                auto order = static_cast<std::size_t>(maybe_next_ln.value().data() - _source.data());
+                res.error_order = order;
+                res.entries.push_back(split_line(parse, maybe_next_ln.value(), order));
+                if (_lazy) {
+                    // only the line endings and the skipped lines are between the lines read
+                    line += static_cast<int>(count_newlines(line_end, maybe_next_ln.value().data()));
+                    line_end = maybe_next_ln.value().data() + maybe_next_ln.value().size();
+                    res.entries.back().line = static_cast<std::uint32_t>(line);
+                }
+            }
+            res.error_order = no_error;
+        } catch (...) {
+            res.error = std::current_exception();
+        }
+        std::sort(res.entries.begin(), res.entries.end(), &entry_less);
+    }
+
+    /**
+     * \brief Parses a line into an entry
+     *
+     * Lazily loaded entries only have their key parsed, and keep the whole line as their value,
+     * unterminated, until they are settled.
+     *
+     * \param parse The parser to use
+     * \param ln The line to parse
+     * \param order The order of the entry
+     * \return The entry of the line
+     */
+    entry
+    split_line(const P& parse, std::string_view ln, std::size_t order) {
+        if constexpr (is_lazy_parser<P>::value) {
+            if (_lazy) return {parse.parse_key_view(ln), ln, order};
+        }
+        auto conf = parse.parse_line_view(ln);
+        return {terminate(conf.first), terminate(conf.second), order};
+    }
+
+    /**
+     * \brief Creates a parser starting at the given line
+     *
+     * Parsers that cannot be started at an arbitrary line are only ever used from the first line.
+     *
+     * \param first_line The number of the first line to parse
+     * \return The parser
+     */
+    P
+    make_parser([[maybe_unused]] int first_line) const {
+        if constexpr (std::is_constructible<P, const std::filesystem::path&, int>::value) {
+            return P(_file, first_line);
+        } else {
+            return P(_file);
+        }
+    }
+
+    /**
+     * \brief Parses the source buffer on multiple threads
+     *
+     * Splits the source buffer into chunks, counts the lines of each chunk to find out where they
+     * start, then parses the chunks in parallel.
+     *
+     * \param parts The number of chunks to parse
+     */
+    void
+    parse_source_parallel(std::size_t parts) {
+        auto chunks = split_chunks(_source.view(), parts);
+
+        std::vector<int> first_lines(chunks.size() + 1, 0);
+        run_parallel(chunks.size(), [&chunks, &first_lines](std::size_t i) {
+            first_lines[i + 1] = static_cast<int>(count_newlines(chunks[i].data(), chunks[i].data() + chunks[i].size()));
+        });
+        first_lines[0] = 1;
+        std::partial_sum(first_lines.begin(), first_lines.end(), first_lines.begin());
+
+        std::vector<chunk_result> results(chunks.size());
+        run_parallel(chunks.size(), [this, &chunks, &first_lines, &results](std::size_t i) {
+            auto lines = static_cast<std::size_t>(first_lines[i + 1] - first_lines[i]) + 1;
+            parse_chunk(chunks[i], first_lines[i], lines, results[i]);
+        });
+        store_results(results);
+    }
+
+    /**
+     * \brief Builds the set from the parsed chunks
+     *
+     * The sorted entries of the chunks are merged, in parallel if there are multiple chunks, then
+     * repeated keys are found in a single pass over the neighboring entries.
+     *
+     * Errors are reported exactly like parsing and inserting the lines one by one would: whichever
+     * comes first in the input, the first syntax error or the first repeated key, is thrown.
+     *
+     * \param results The results of the chunks, in input order
+     */
+    void
+    store_results(std::vector<chunk_result>& results) {
+        // the chunks after the first failing one are never reached by a sequential parse
+        auto used = std::find_if(results.begin(), results.end(), [](const chunk_result& res) {
+            return res.error != nullptr;
+        });
+        auto error = used == results.end() ? nullptr : used->error;
+        auto error_order = used == results.end() ? no_error : used->error_order;
+        if (used != results.end()) ++used;
+
+        std::vector<entry> entries;
+        if (std::next(results.begin()) == used) {
+            entries = std::move(results.front().entries);
+        } else {
+            std::vector<std::size_t> runs{0};
+            entries.reserve(std::accumulate(results.begin(), used, std::size_t{}, [](std::size_t acc, const chunk_result& res) {
+                return acc + res.entries.size();
+            }));
+            for (auto it = results.begin(); it != used; ++it) {
+                entries.insert(entries.end(), it->entries.begin(), it->entries.end());
+                runs.push_back(entries.size());
+                it->entries = {};
+            }
+            merge_runs(entries, runs);
+        }
+
+        const entry* repeated = nullptr;
+        for (std::size_t i = 1; i < entries.size(); ++i) {
+            if (entries[i - 1].key == entries[i].key
+                && (!repeated || entries[i].order < repeated->order)) {
+                repeated = &entries[i];
             }
         }
-        return std::forward<FailFn>(fail)(begin, middle, end);
+        if (repeated && repeated->order < error_order)
+            throw bad_key(std::string(repeated->key.data(), repeated->key.size()), _file);
+        if (error) std::rethrow_exception(error);
+
+        auto order = _index.build(entries.size(), [&entries](std::size_t idx) {
+            return entries[idx].key;
+        });
+        _keys.reserve(entries.size());
+        _configs.reserve(entries.size());
+        auto store = [this](const entry& ent) {
+            _keys.push_back(ref_of(ent.key));
+            _configs.emplace_back(ref_of(ent.value));
+            if (_lazy) _lines.push_back(ent.line);
+        };
+        if (_lazy) _lines.reserve(entries.size());
+        if (order.empty()) {
+            for (const auto& ent : entries) store(ent);
+        } else {
+            for (auto idx : order) store(entries[idx]);
+        }
+        if (_lazy) _raw.assign((entries.size() + 63) / 64, ~std::uint64_t{0});
     }
 
+    /**
+     * \brief Builds the set from the tables of an image
+     *
+     * The image was written sorted by compile, so the key index is built from its entries directly.
+     * Their order is only checked when verifying, but every reference is checked as it is read, so a
+     * damaged image throws an `std::invalid_argument` here, instead of being read outside the
+     * mapping.
+     *
+     * \param image The tables of the image held by the source buffer
+     */
     void
-    emplace_config(std::string&& name, std::string&& value) {
-        callback_binary_search(
-               _configs,
-               [&name](const config& cfg) {
-                   // C++20: cfg.get_key() <=> name;
-                   return std::strcmp(cfg.get_key().data(), name.c_str());
-               },
-               [&name, this](auto...) {
-                   throw bad_key(name, _file);
-               },
-               [this, &name, &value](std::size_t, std::size_t, std::size_t end) {
-                   _configs.emplace(std::next(_configs.begin(), static_cast<std::ptrdiff_t>(end)), name, value);
-               });
+    store_image(const config_image& image) {
+        auto order = _index.build(image.entries, [this, &image](std::size_t idx) {
+            return image.key(idx).in(_source.data());
+        });
+        _keys.reserve(image.entries);
+        _configs.reserve(image.entries);
+        auto store = [this, &image](std::size_t idx) {
+            _keys.push_back(image.key(idx));
+            _configs.emplace_back(image.value(idx));
+        };
+        if (order.empty()) {
+            for (std::size_t i = 0; i < image.entries; ++i) store(i);
+        } else {
+            for (auto idx : order) store(idx);
+        }
+    }
+
+    /**
+     * \brief Merges sorted runs of entries
+     *
+     * Merges neighboring runs pairwise, until only one run remains.
+     * The merges of each round are performed in parallel.
+     *
+     * \param entries The entries consisting of the sorted runs
+     * \param runs The boundaries of the runs, starting with 0 and ending with the size of entries
+     */
+    static void
+    merge_runs(std::vector<entry>& entries, std::vector<std::size_t> runs) {
+        while (runs.size() > 2) {
+            std::vector<std::size_t> merged;
+            for (std::size_t i = 0; i < runs.size(); i += 2) merged.push_back(runs[i]);
+            if (merged.back() != runs.back()) merged.push_back(runs.back());
+
+            run_parallel((runs.size() - 1) / 2, [&entries, &runs](std::size_t i) {
+                auto first = std::next(entries.begin(), static_cast<std::ptrdiff_t>(runs[2 * i]));
+                auto middle = std::next(entries.begin(), static_cast<std::ptrdiff_t>(runs[2 * i + 1]));
+                auto last = std::next(entries.begin(), static_cast<std::ptrdiff_t>(runs[2 * i + 2]));
+                std::inplace_merge(first, middle, last, &entry_less);
+            });
+            runs = std::move(merged);
+        }
+    }
+
+    /**
+     * \brief Converts a view into the source buffer to a reference
+     *
+     * \param str The view to convert, which must point into the source buffer
+     * \return The reference to the same bytes
+     */
+    string_ref
+    ref_of(std::string_view str) const noexcept {
+        return {static_cast<std::uint32_t>(str.data() - _source.data()), static_cast<std::uint32_t>(str.size())};
     }
 
+    /**
+     * \brief NUL-terminates a view into the source buffer in place
+     *
+     * Overwrites the byte following the view with a NUL byte, so the viewed string may be used as a
+     * C-string.
+     * The overwritten byte is always a delimiter (`=`, a quote, or a line ending) that has already
+     * been consumed by the parser.
+     * Views not pointing into the source buffer are left alone.
+     *
+     * \param str The view to terminate
+     * \return The same view
+     */
+    std::string_view
+    terminate(std::string_view str) const noexcept {
+        auto end = str.data() + str.size();
+        if (end >= _source.data() && end <= _source.data() + _source.size()) {
+            _source.data()[end - _source.data()] = '\0';
+        }
+        return str;
+    }
+
+    /// The smallest chunk worth parsing on a separate thread
+    constexpr static std::size_t min_chunk_size = std::size_t{1} << 16;
+    /// The fewest entries worth converting on a separate thread
+    constexpr static std::size_t min_column_chunk = std::size_t{1} << 14;
+    /// The largest source buffer the 32-bit string references can address
+    constexpr static std::size_t max_arena_size = std::numeric_limits<std::uint32_t>::max();
+
     std::filesystem::path _file{}; ///< The currently used file's path
-    std::vector<config> _configs;  ///< The set of configurations stored
+    mutable source_buffer _source; ///< The arena holding the bytes of all keys and values
+    std::vector<string_ref> _keys; ///< The keys of the entries, compared on lookups
+    std::vector<config> _configs;  ///< The values of the entries, in the same order as the keys
+    I _index;                      ///< The index used to look up the configurations
+    std::uint64_t _generation = next_set_generation(); ///< The generation of the loaded entries
+    /// The values referred to by handles, by the position of their entry and the visit index of their type
+    mutable std::map<std::pair<std::size_t, std::size_t>, std::shared_ptr<const void>> _pinned;
+    /// The values referred to by handles, resolved before the visit index of their type was assigned
+    mutable std::vector<unindexed_pin> _unindexed_pins;
+    bool _lazy = false;                      ///< Whether the values are parsed on first access
+    mutable std::vector<std::uint64_t> _raw; ///< The mask of the entries whose lines are not parsed yet
+    mutable std::vector<std::uint32_t> _lines; ///< The lines the entries were read from, while any is not parsed
 };
 
 #endif
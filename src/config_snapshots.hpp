@@ -0,0 +1,255 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file config_snapshots.hpp
+ * \brief Defines the config_snapshots type
+ *
+ * This file defines the config_snapshots class, which shares immutable versions of a configuration
+ * between threads, and lets a writer replace them while the readers keep reading.
+ */
+
+#ifndef CONFY_CONFIG_SNAPSHOTS_HPP
+#define CONFY_CONFIG_SNAPSHOTS_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "config_set.hpp"
+
+/**
+ * \brief Immutable versions of a configuration, shared between threads
+ *
+ * Publishes config_set versions through an atomic shared pointer, in a read-copy-update fashion: a
+ * writer loads the new version privately, then publishes it with a single atomic store, while
+ * readers keep using the version they hold, which is destroyed when the last of them lets it go.
+ *
+ * Published versions are never written: readers reach them through snapshot, which only exposes
+ * the accessors of config_set that do not write the set, read, key_at, and size.
+ * The other accessors, even though they are const, fill the caches of the set, so they are not
+ * safe to call from several threads, and are not available on a snapshot.
+ * Caches filled before publishing, for example by getting the hot keys, are used by read; nothing
+ * is cached after publishing.
+ *
+ * Readers on hot paths should hold a reader each, which keeps its own reference to the current
+ * version, and only checks a version counter on each access: readers neither take locks nor write
+ * shared memory, unless a new version was published.
+ *
+ * \tparam P The type of the parser object the versions were parsed with
+ * \tparam I The type of the key index of the versions
+ */
+template<parser P, key_index I = sorted_index>
+struct config_snapshots {
+    /// The type of the published versions
+    using set_type = config_set<P, I>;
+
+    /**
+     * \brief A published version, as seen by the readers
+     *
+     * Shares the ownership of the version, which is destroyed when the last snapshot of it is.
+     * Only provides the accessors which do not write the set, so any number of threads may read the
+     * same version at once.
+     */
+    struct snapshot {
+        /**
+         * \brief Reads a value without writing the set
+         *
+         * \tparam T The type to get the value as
+         * \param key The key to look up
+         * \return The converted value, or an empty optional.
+         * \see config_set::read
+         */
+        template<class T>
+        std::optional<T>
+        read(std::string_view key) const { return _set->template read<T>(key); }
+
+        /**
+         * \brief Returns the key of an entry
+         *
+         * \param idx The index of the entry
+         * \return The key of the entry
+         * \see config_set::key_at
+         */
+        std::string_view
+        key_at(std::size_t idx) const noexcept { return _set->key_at(idx); }
+
+        /**
+         * \brief Getter for the number of entries
+         *
+         * \return The number of entries of the version
+         */
+        std::size_t
+        size() const noexcept { return _set->size(); }
+
+    private:
+        friend struct config_snapshots;
+
+        /**
+         * \brief Creates a snapshot of a published version
+         *
+         * \param set The owner of the version
+         */
+        explicit snapshot(std::shared_ptr<const set_type> set) noexcept
+             : _set(std::move(set)) { }
+
+        std::shared_ptr<const set_type> _set; ///< The owner of the version
+    };
+
+    /**
+     * \brief A thread's view of the published versions
+     *
+     * Holds a reference to the version that was current when it was last checked.
+     * Not thread-safe itself: each reading thread should have its own.
+     */
+    struct reader {
+        /**
+         * \brief Creates a reader of the published versions
+         *
+         * \param source The holder of the versions, which must outlive the reader
+         */
+        explicit reader(const config_snapshots& source)
+             : _source(&source),
+               _seen(source.version()),
+               _snapshot(source.current()) { }
+
+        /**
+         * \brief Returns the current version
+         *
+         * Only loads the version counter, unless a new version was published since the last call,
+         * in which case the reference to the new version is loaded, and the old one is released.
+         * The returned snapshot stays valid until the next call.
+         *
+         * \return The current version of the configuration
+         */
+        const snapshot&
+        current() {
+            auto version = _source->version();
+            if (version != _seen) {
+                _snapshot = _source->current();
+                _seen = version;
+            }
+            return _snapshot;
+        }
+
+    private:
+        const config_snapshots* _source; ///< The holder of the versions
+        std::uint64_t _seen;             ///< The version counter when the snapshot was loaded
+        snapshot _snapshot;              ///< The version in use
+    };
+
+    /**
+     * \brief Publishes the first version
+     *
+     * \param initial The first version of the configuration
+     */
+    explicit config_snapshots(std::unique_ptr<set_type> initial)
+         : _current(freeze(std::move(initial))) { }
+
+    /**
+     * \brief Returns the current version
+     *
+     * Loads the atomic shared pointer, which updates its reference count; prefer a reader on hot
+     * paths.
+     *
+     * \return The current version of the configuration
+     */
+    snapshot
+    current() const noexcept {
+#ifdef USE_CXX17
+        return snapshot(std::atomic_load(&_current));
+#else
+        return snapshot(_current.load());
+#endif
+    }
+
+    /**
+     * \brief Getter for the version counter
+     *
+     * \return The number of versions published after the first one
+     */
+    std::uint64_t
+    version() const noexcept { return _version.load(std::memory_order_acquire); }
+
+    /**
+     * \brief Publishes a new version
+     *
+     * Parses the lazily loaded values of the set first, so readers never have to, then replaces
+     * the current version.
+     * If the set has malformed values, their `bad_syntax` exception is thrown, and the current
+     * version is kept.
+     * The replaced version is destroyed when no reader refers to it anymore.
+     * Versions should be published by one writer at a time.
+     *
+     * \param next The new version of the configuration
+     */
+    void
+    publish(std::unique_ptr<set_type> next) {
+        auto frozen = freeze(std::move(next));
+#ifdef USE_CXX17
+        std::atomic_store(&_current, std::move(frozen));
+#else
+        _current.store(std::move(frozen));
+#endif
+        // readers seeing the new count load the new version, or a later one
+        _version.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    /**
+     * \brief Prepares a set to be shared
+     *
+     * \param set The set to share
+     * \return The owner of the set, sharing it as immutable
+     */
+    static std::shared_ptr<const set_type>
+    freeze(std::unique_ptr<set_type> set) {
+        set->validate_all();
+        return std::shared_ptr<const set_type>(std::move(set));
+    }
+
+#ifdef USE_CXX17
+    std::shared_ptr<const set_type> _current; ///< The current version, only accessed through the atomic shared_ptr functions
+#else
+    std::atomic<std::shared_ptr<const set_type>> _current; ///< The current version
+#endif
+    std::atomic<std::uint64_t> _version{0}; ///< The number of versions published after the first
+};
+
+#endif
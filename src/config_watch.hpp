@@ -0,0 +1,237 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file config_watch.hpp
+ * \brief Defines the config_watch type
+ *
+ * This file defines the config_watch class, which keeps a config_set up to date with its file,
+ * reloading it in the background when the file changes.
+ */
+
+#ifndef CONFY_CONFIG_WATCH_HPP
+#define CONFY_CONFIG_WATCH_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/filesystem>
+#  include <experimental/optional>
+#  define filesystem experimental::filesystem
+#  define optional experimental::optional
+#else
+#  include <filesystem>
+#  include <optional>
+#endif
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "config_diff.hpp"
+#include "config_set.hpp"
+#include "file_watch.hpp"
+#include "source_buffer.hpp"
+
+/**
+ * \brief A configuration reloaded when its file changes
+ *
+ * Loads a configuration file, then watches it with a file_watch, and loads it again on a
+ * background thread whenever it changes.
+ * The reloaded set is only installed by refresh, on the thread reading the configuration, as a
+ * config_set may only be used by one thread at a time.
+ * On installing it, the caches of the entries whose value did not change are carried over from the
+ * replaced set, so only the conversions of the changed entries are repeated.
+ *
+ * The file is read, not mapped, so the loaded sets are not affected by rewriting or truncating the
+ * file in place.
+ *
+ * \tparam P The type of the parser object to parse configuration with
+ * \tparam I The type of the key index to look up entries with
+ * \tparam W The type of the watch reporting the changes of the file, with the interface of file_watch
+ */
+template<parser P, key_index I = sorted_index, class W = file_watch>
+struct config_watch {
+    /// The type of the watched configuration set
+    using set_type = config_set<P, I>;
+
+    /**
+     * \brief Loads and starts watching a configuration file
+     *
+     * The file is loaded on the calling thread, so its errors are thrown by the constructor, like
+     * by the config_set constructor.
+     * Changes made to the file after the constructor returns are reloaded.
+     *
+     * \param file The configuration file
+     * \param threads The maximum number of threads to parse the file with
+     */
+    explicit config_watch(const std::filesystem::path& file, unsigned threads = 1)
+         : _file(file),
+           _threads(threads),
+           _watch(file),
+           _current(load()) {
+        _watcher = std::thread([this] { watch(); });
+    }
+
+    config_watch(const config_watch&) = delete;
+    config_watch&
+    operator=(const config_watch&) = delete;
+
+    /**
+     * \brief Stops watching the file
+     *
+     * Waits for a reload in progress to finish.
+     */
+    ~config_watch() noexcept {
+        _watch.stop();
+        _watcher.join();
+    }
+
+    /**
+     * \brief Returns the installed configuration
+     *
+     * The returned set is replaced, and destroyed, by the next refresh installing a reloaded one.
+     *
+     * \return The installed configuration set
+     */
+    const set_type&
+    current() const noexcept { return *_current; }
+
+    /**
+     * \brief Installs the reloaded configuration, if there is one
+     *
+     * If the file was reloaded since the last refresh, carries the caches of the unchanged entries
+     * over to the reloaded set, and replaces the installed set with it.
+     * The work done on the calling thread is a linear merge of the two sets: parsing happened in the
+     * background.
+     *
+     * If the last reload failed, its exception is thrown, once, and the installed set is kept.
+     *
+     * \return The differences between the replaced and the installed set, or an empty optional, if
+     *         there was nothing to install.
+     */
+    std::optional<config_diff>
+    refresh() {
+        std::unique_ptr<set_type> next;
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            next = std::move(_pending);
+            error = std::exchange(_error, nullptr);
+        }
+        if (error) std::rethrow_exception(error);
+        if (!next) return {};
+
+        auto diff = next->carry_over(*_current);
+        _current = std::move(next);
+        return diff;
+    }
+
+    /**
+     * \brief Waits for a reload
+     *
+     * Blocks until a reloaded set, or the error of a failed reload, is waiting for refresh, or the
+     * timeout expires.
+     *
+     * \param timeout The longest time to wait
+     * \return Whether refresh has something to install, or to throw.
+     */
+    bool
+    wait_for_reload(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _reloaded.wait_for(lock, timeout, [this] { return _pending != nullptr || _error != nullptr; });
+    }
+
+private:
+    /**
+     * \brief Loads the current contents of the file
+     *
+     * \return The loaded set
+     */
+    std::unique_ptr<set_type>
+    load() const {
+        return std::make_unique<set_type>(source_buffer::read(_file), _file, _threads);
+    }
+
+    /**
+     * \brief The body of the background thread
+     *
+     * Reloads the file on every change, until the watch is stopped.
+     * A newer reload replaces the one not yet installed.
+     * If the watch fails, its error is left for refresh, and the file is no longer watched.
+     */
+    void
+    watch() noexcept {
+        try {
+            while (_watch.wait()) {
+                std::unique_ptr<set_type> next;
+                std::exception_ptr error;
+                try {
+                    next = load();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _pending = std::move(next);
+                    _error = error;
+                }
+                _reloaded.notify_all();
+            }
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _error = std::current_exception();
+            }
+            // the watch failed, and no reload follows, so the waiting threads are woken to see the error
+            _reloaded.notify_all();
+        }
+    }
+
+    std::filesystem::path _file;          ///< The watched configuration file
+    unsigned _threads;                    ///< The maximum number of threads to parse the file with
+    W _watch;                             ///< The watch reporting the changes of the file
+    std::unique_ptr<set_type> _current;   ///< The installed set
+    std::mutex _mutex;                    ///< The mutex guarding the results of the reloads
+    std::condition_variable _reloaded;    ///< Signaled when a reload finishes
+    std::unique_ptr<set_type> _pending{}; ///< The reloaded set waiting to be installed
+    std::exception_ptr _error{};          ///< The error of the last reload, if it failed
+    std::thread _watcher;                 ///< The background thread reloading the file
+};
+
+#endif
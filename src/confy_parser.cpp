@@ -33,10 +33,17 @@
  */
 #include "confy_parser.hpp"
 
+#include <cctype>
+
 #include "bad_syntax.hpp"
+#include "scanner.hpp"
 
 confy_parser::confy_parser(const std::filesystem::path& file) noexcept
-     : _file(file) { }
+     : confy_parser(file, 1) { }
+
+confy_parser::confy_parser(const std::filesystem::path& file, int first_line) noexcept
+     : _ln_cnt(first_line),
+       _file(file) { }
 
 std::optional<std::string>
 confy_parser::next_line(std::istream& strm) const {
@@ -56,36 +63,58 @@ confy_parser::next_line(std::istream& strm) const {
     return std::nullopt;
 }
 
+std::optional<std::string_view>
+confy_parser::next_line_view(std::string_view& buf) const {
+    while (!buf.empty()) {
+        auto eol = static_cast<std::size_t>(scan_newline(buf.data(), buf.data() + buf.size()) - buf.data());
+        auto next_ln = buf.substr(0, eol);
+        buf.remove_prefix(eol == buf.size() ? eol : eol + 1);
+        while (!next_ln.empty() && next_ln.back() == '\r') {
+            next_ln.remove_suffix(1);
+        }
+        ++_ln_cnt;
+        if (next_ln.empty()) continue;
+        if (next_ln.front() == '#') continue;
+
+        return {next_ln};
+    }
+    return std::nullopt;
+}
+
 std::pair<std::string, std::string>
 confy_parser::parse_line(std::string_view ln) const {
-    if (ln.empty() || !std::isalpha(ln.front())) throw bad_syntax({ln.data(), ln.size()}, _ln_cnt, 1, _file);
-    std::string key;
-    std::size_t i = 0;
-
-    while (i < ln.size() && ln[i] != '=') {
-        if (!std::isalnum(ln[i])) throw bad_syntax({ln.data(), ln.size()}, _ln_cnt, static_cast<int>(i + 1), _file);
-        key.push_back(ln[i]);
-        ++i;
-    }
-    if (i == ln.size()) throw bad_syntax({ln.data(), ln.size()}, _ln_cnt, static_cast<int>(i + 1), _file);
-    ++i;
+    auto conf = parse_line_view(ln);
+    return {std::string(conf.first.data(), conf.first.size()),
+            std::string(conf.second.data(), conf.second.size())};
+}
 
-    if (ln.size() == i) return {key, ""};
+std::string_view
+confy_parser::parse_key_view(std::string_view ln) const {
+    if (ln.empty() || !std::isalpha(static_cast<unsigned char>(ln.front()))) throw bad_syntax({ln.data(), ln.size()}, _ln_cnt, 1, _file);
+
+    // the key ends at the first non-alphanumeric byte, which must be the equals sign
+    auto i = static_cast<std::size_t>(scan_non_alnum(ln.data(), ln.data() + ln.size()) - ln.data());
+    if (i == ln.size() || ln[i] != '=') throw bad_syntax({ln.data(), ln.size()}, _ln_cnt, static_cast<int>(i + 1), _file);
+    return ln.substr(0, i);
+}
+
+std::pair<std::string_view, std::string_view>
+confy_parser::parse_line_view(std::string_view ln) const {
+    auto key = parse_key_view(ln);
+    auto end = ln.data() + ln.size();
+    auto i = key.size() + 1;
+
+    if (ln.size() == i) return {key, ln.substr(i)};
 
     if (ln[i] == '\'' || ln[i] == '"') {
         auto value = ln.substr(i + 1);
-        if (value.back() != ln[i]) throw bad_syntax({ln.data(), ln.size()}, _ln_cnt, static_cast<int>(ln.size() + 1), _file);
-        auto str_value = value.substr(0, value.size() - 1);
-        return {key, {str_value.data(), str_value.size()}};
+        if (value.empty() || value.back() != ln[i]) throw bad_syntax({ln.data(), ln.size()}, _ln_cnt, static_cast<int>(ln.size() + 1), _file);
+        return {key, value.substr(0, value.size() - 1)};
     }
 
-    std::string value;
-    value.reserve(ln.size() - i);
-    while (i < ln.size() && std::isalnum(ln[i])) {
-        value.push_back(ln[i]);
-        ++i;
-    }
+    auto value_begin = i;
+    i = static_cast<std::size_t>(scan_non_alnum(ln.data() + i, end) - ln.data());
     if (i != ln.size()) throw bad_syntax({ln.data(), ln.size()}, _ln_cnt, static_cast<int>(i + 1), _file);
 
-    return {key, value};
+    return {key, ln.substr(value_begin)};
 }
@@ -70,6 +70,8 @@
  *
  * May be replaced by any class with an equivalent interface, that conforms to the parser concept
  * and config_set will be happy to use it.
+ * Also conforms to the view_parser concept, so config_set can load files through it without per-line
+ * allocations, and to the lazy_parser concept, so it can defer parsing the values.
  */
 struct confy_parser {
     /**
@@ -83,6 +85,20 @@ struct confy_parser {
      */
     confy_parser(const std::filesystem::path& file) noexcept;
 
+    /**
+     * \brief The confy_parser constructor for parsing a part of a file.
+     *
+     * Constructs a confy_parser object that is going to parse a file starting from the given line,
+     * instead of the beginning.
+     * Used to parse a file in multiple chunks, while still reporting the correct line numbers on
+     * errors.
+     * The file reference is not copied, and MUST LIVE THROUGHOUT THE LIFE OF THE PARSER OBJECT.
+     *
+     * \param file The file we are currently reading. May be empty.
+     * \param first_line The number of the first line that is going to be parsed.
+     */
+    confy_parser(const std::filesystem::path& file, int first_line) noexcept;
+
     /**
      * \brief Parses the stream and returns the next valid line.
      *
@@ -115,8 +131,46 @@ struct confy_parser {
     std::pair<std::string, std::string>
     parse_line(std::string_view ln) const;
 
+    /**
+     * \brief Returns the next valid line of a buffer.
+     *
+     * Works exactly like the stream based next_line, but does not copy anything: the returned line
+     * is a view into the buffer.
+     * The consumed lines are removed from the front of the passed buffer view.
+     *
+     * \param buf The rest of the buffer to read from. Updated to point after the returned line.
+     * \return The next non-empty line, or `std::nullopt` if the buffer is exhausted.
+     */
+    std::optional<std::string_view>
+    next_line_view(std::string_view& buf) const;
+
+    /**
+     * \brief Parses a key-value line into views of the key and the value.
+     *
+     * Works exactly like parse_line, including the error reporting, but the returned key and value
+     * are views into the passed line, therefore no allocation is performed.
+     *
+     * \param ln The line to parse
+     * \return Views of the key and the value packed into a pair
+     */
+    std::pair<std::string_view, std::string_view>
+    parse_line_view(std::string_view ln) const;
+
+    /**
+     * \brief Parses only the key of a key-value line.
+     *
+     * Checks the key, and the equals sign following it, like parse_line_view, but not the value.
+     * Used to load a configuration lazily, which parses the rest of the line only when the value is
+     * first needed.
+     *
+     * \param ln The line to parse
+     * \return A view of the key
+     */
+    std::string_view
+    parse_key_view(std::string_view ln) const;
+
 private:
-    mutable int _ln_cnt = 1;            ///< The current line count
+    mutable int _ln_cnt;                ///< The current line count
     const std::filesystem::path& _file; ///< The file
 };
 
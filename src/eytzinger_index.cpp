@@ -0,0 +1,119 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file eytzinger_index.cpp
+ * \brief Implements the eytzinger_index type
+ *
+ * Contains the construction of the Eytzinger layout, and the branchless search over it.
+ */
+
+#include "eytzinger_index.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "prefetch.hpp"
+
+#include "memtrace.h"
+
+namespace {
+    /// The number of levels the search prefetches ahead: 2^3 nodes fill a cache line
+    constexpr std::size_t prefetch_nodes = 8;
+
+    /**
+     * \brief Lays out the sorted prefixes
+     *
+     * Walks the tree in order, assigning the next sorted prefix, and its position, to each node.
+     */
+    void
+    lay_out(const std::vector<std::uint64_t>& sorted,
+            std::vector<std::uint64_t>& prefixes,
+            std::vector<std::uint32_t>& positions) {
+        std::size_t next = 0;
+        std::size_t node = 1;
+        // iterative in-order walk, the tree may be too deep for recursion on small stacks
+        std::vector<std::size_t> stack;
+        while (node < prefixes.size() || !stack.empty()) {
+            if (node < prefixes.size()) {
+                stack.push_back(node);
+                node = 2 * node;
+                continue;
+            }
+            node = stack.back();
+            stack.pop_back();
+            prefixes[node] = sorted[next];
+            positions[node] = static_cast<std::uint32_t>(next);
+            ++next;
+            node = 2 * node + 1;
+        }
+    }
+}
+
+std::uint64_t
+eytzinger_index::prefix_of(std::string_view key) noexcept {
+    std::uint64_t prefix = 0;
+    auto len = key.size() < 8 ? key.size() : 8;
+    for (std::size_t i = 0; i < 8; ++i) {
+        prefix <<= 8;
+        if (i < len) prefix |= static_cast<unsigned char>(key[i]);
+    }
+    return prefix;
+}
+
+void
+eytzinger_index::build_prefixes(const std::vector<std::uint64_t>& prefixes) {
+    if (prefixes.size() >= (std::size_t{1} << 32))
+        throw std::length_error("too many keys for eytzinger_index");
+
+    _size = prefixes.size();
+    _prefixes.assign(_size + 1, 0);
+    _positions.assign(_size + 1, 0);
+    lay_out(prefixes, _prefixes, _positions);
+}
+
+std::size_t
+eytzinger_index::lower_bound(std::uint64_t prefix) const noexcept {
+    const auto* nodes = _prefixes.data();
+    std::size_t node = 1;
+    while (node <= _size) {
+        if (node * prefetch_nodes <= _size) prefetch(nodes + node * prefetch_nodes);
+        node = 2 * node + (nodes[node] < prefix);
+    }
+    // the path turned left at the answer, then only right: drop those right turns and the left one
+#if defined(__GNUC__) || defined(__clang__)
+    node >>= __builtin_ffsll(static_cast<long long>(~node));
+#else
+    while (node & 1) node >>= 1;
+    node >>= 1;
+#endif
+    return node;
+}
@@ -0,0 +1,200 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file eytzinger_index.hpp
+ * \brief Defines the eytzinger_index type
+ *
+ * This file defines the eytzinger_index class, a key index of config_set, which binary searches the
+ * prefixes of the keys laid out in breadth-first order.
+ */
+
+#ifndef CONFY_EYTZINGER_INDEX_HPP
+#define CONFY_EYTZINGER_INDEX_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <string_view>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Key index searching key prefixes in Eytzinger order
+ *
+ * Keeps the entries sorted, but searches a separate array holding the first 8 bytes of every key,
+ * packed into an integer that compares like the bytes do.
+ * The bytes all keys start with are skipped, and are checked only once per lookup: configuration keys
+ * often share a common prefix, which would make the first 8 bytes of many keys the same.
+ * The array is in Eytzinger, or breadth-first, order: the children of the node k are the nodes 2k
+ * and 2k + 1, so the first levels of the search share a few cache lines, and the nodes of the next
+ * levels can be prefetched while the current one is compared.
+ * The search loop itself is branchless, its only branch is the loop condition, which depends only on
+ * the number of keys.
+ *
+ * The keys themselves are only compared if the prefix of the looked up key is found: once, if the
+ * prefix is unique, and a logarithmic number of times in the run of keys sharing that prefix
+ * otherwise.
+ * Memory use is 12 bytes per key.
+ */
+struct eytzinger_index {
+    /// The position returned for keys not in the index
+    constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * \brief Builds the index
+     *
+     * Lays out the prefixes of the sorted keys in Eytzinger order.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param n The number of entries
+     * \param key_at The function returning the key of the entry at a given position
+     * \return An empty order, to keep the entries sorted
+     */
+    template<class KeyAt>
+    std::vector<std::size_t>
+    build(std::size_t n, KeyAt&& key_at) {
+        _common.clear();
+        if (n != 0) {
+            auto first = key_at(0);
+            auto last = key_at(n - 1);
+            std::size_t len = 0;
+            while (len < first.size() && len < last.size() && first[len] == last[len]) ++len;
+            _common.assign(first.data(), len);
+        }
+        std::vector<std::uint64_t> prefixes(n);
+        for (std::size_t i = 0; i < n; ++i) prefixes[i] = prefix_of(key_at(i).substr(_common.size()));
+        build_prefixes(prefixes);
+        return {};
+    }
+
+    /**
+     * \brief Finds a key
+     *
+     * Checks the prefix common to all keys, then finds the first key with a prefix not less than the
+     * looked up key's, and compares full keys from there on.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param key The key to look for
+     * \param key_at The function returning the key of the entry at a given position
+     * \return The position of the entry with the given key, or npos, if there is none.
+     */
+    template<class KeyAt>
+    std::size_t
+    find(std::string_view key, KeyAt&& key_at) const {
+        if (key.size() < _common.size() || key.substr(0, _common.size()) != _common) return npos;
+        auto prefix = prefix_of(key.substr(_common.size()));
+        auto node = lower_bound(prefix);
+        if (node == 0 || _prefixes[node] != prefix) return npos;
+
+        std::size_t first = _positions[node];
+        auto dir = key_at(first).compare(key);
+        if (dir == 0) return first;
+        if (dir > 0) return npos;
+
+        // gallop through the keys sharing the prefix, then binary search the last step
+        std::size_t step = 1;
+        while (first + step < _size && key_at(first + step).compare(key) < 0) {
+            first += step;
+            step *= 2;
+        }
+        auto last = first + step < _size ? first + step + 1 : _size;
+        ++first;
+        while (first < last) {
+            auto middle = first + (last - first) / 2;
+            dir = key_at(middle).compare(key);
+            if (dir == 0) return middle;
+            if (dir < 0) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        return npos;
+    }
+
+    /**
+     * \brief Packs the prefix of a key into an integer
+     *
+     * The first 8 bytes of the key are packed in big-endian order, with missing bytes as zeros, so
+     * the integers of two keys compare like the first 8 bytes of the keys do.
+     *
+     * \param key The key
+     * \return The prefix of the key
+     */
+    static std::uint64_t
+    prefix_of(std::string_view key) noexcept;
+
+    /**
+     * \brief Getter for the size of the index
+     *
+     * \return The number of bytes used by the prefix and position arrays, and the common prefix.
+     */
+    std::size_t
+    memory_usage() const noexcept {
+        return _prefixes.size() * sizeof(std::uint64_t) + _positions.size() * sizeof(std::uint32_t) + _common.size();
+    }
+
+private:
+    /**
+     * \brief Lays out the prefixes in Eytzinger order
+     *
+     * \param prefixes The prefixes of the sorted keys
+     */
+    void
+    build_prefixes(const std::vector<std::uint64_t>& prefixes);
+
+    /**
+     * \brief Finds the first node with a prefix not less than the given one
+     *
+     * \param prefix The prefix to look for
+     * \return The node found, or 0 if all prefixes are less than the given one.
+     */
+    std::size_t
+    lower_bound(std::uint64_t prefix) const noexcept;
+
+    std::string _common;                   ///< The bytes all keys start with
+    std::vector<std::uint64_t> _prefixes;  ///< The prefixes in Eytzinger order, from index 1
+    std::vector<std::uint32_t> _positions; ///< The sorted position of each node's key
+    std::size_t _size = 0;                 ///< The number of entries
+};
+
+#endif
@@ -0,0 +1,163 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file file_watch.cpp
+ * \brief Implements the file_watch type
+ */
+
+#include "file_watch.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#ifdef CONFY_HAS_INOTIFY
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <sys/inotify.h>
+#  include <unistd.h>
+#endif
+
+#include "memtrace.h"
+
+namespace {
+    [[noreturn]] void
+    unwatchable(const std::filesystem::path& file) {
+        throw std::invalid_argument("invalid_file " + file.string());
+    }
+}
+
+#ifdef CONFY_HAS_INOTIFY
+
+file_watch::file_watch(const std::filesystem::path& file)
+     : _file(file) {
+    auto dir = _file.parent_path();
+    if (dir.empty()) dir = ".";
+
+    _inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotify < 0) unwatchable(_file);
+    if (::inotify_add_watch(_inotify, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0
+        || ::pipe2(_stop, O_CLOEXEC) != 0) {
+        ::close(_inotify);
+        unwatchable(_file);
+    }
+}
+
+file_watch::~file_watch() noexcept {
+    ::close(_inotify);
+    ::close(_stop[0]);
+    ::close(_stop[1]);
+}
+
+bool
+file_watch::wait() {
+    auto name = _file.filename().string();
+    // inotify_event is followed by its name, so the buffer is aligned for the structure
+    alignas(inotify_event) char buf[4096];
+    for (;;) {
+        pollfd fds[2] = {{_stop[0], POLLIN, 0}, {_inotify, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "cannot watch " + _file.string());
+        }
+        if (fds[0].revents != 0) return false;
+
+        auto changed = false;
+        ssize_t len;
+        while ((len = ::read(_inotify, buf, sizeof(buf))) > 0) {
+            for (auto at = buf; at < buf + len;) {
+                inotify_event event;
+                std::memcpy(&event, at, sizeof(event));
+                if (event.len != 0 && name == at + sizeof(event)) changed = true;
+                at += sizeof(event) + event.len;
+            }
+        }
+        if (changed) return true;
+    }
+}
+
+void
+file_watch::stop() noexcept {
+    char byte = 0;
+    while (::write(_stop[1], &byte, 1) < 0 && errno == EINTR) { }
+}
+
+#else
+
+file_watch::file_watch(const std::filesystem::path& file)
+     : _file(file) {
+    auto dir = _file.parent_path();
+    std::error_code ec;
+    if (!dir.empty() && !std::filesystem::is_directory(dir, ec)) unwatchable(_file);
+    stat(_mtime, _size);
+}
+
+file_watch::~file_watch() noexcept = default;
+
+bool
+file_watch::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;) {
+        if (_stopped_cv.wait_for(lock, poll_interval, [this] { return _stopped; })) return false;
+
+        std::filesystem::file_time_type mtime;
+        std::uintmax_t size;
+        stat(mtime, size);
+        if (mtime != _mtime || size != _size) {
+            _mtime = mtime;
+            _size = size;
+            return true;
+        }
+    }
+}
+
+void
+file_watch::stop() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _stopped_cv.notify_all();
+}
+
+void
+file_watch::stat(std::filesystem::file_time_type& mtime, std::uintmax_t& size) const {
+    std::error_code ec;
+    mtime = std::filesystem::last_write_time(_file, ec);
+    if (ec) mtime = {};
+    size = std::filesystem::file_size(_file, ec);
+    if (ec) size = 0;
+}
+
+#endif
@@ -0,0 +1,140 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file file_watch.hpp
+ * \brief Defines the file_watch type
+ *
+ * This file defines the file_watch class, which blocks a thread until a file is changed on disk.
+ */
+
+#ifndef CONFY_FILE_WATCH_HPP
+#define CONFY_FILE_WATCH_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/filesystem>
+#  define filesystem experimental::filesystem
+#else
+#  include <filesystem>
+#endif
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#if defined(__linux__)
+#  define CONFY_HAS_INOTIFY
+#endif
+
+/**
+ * \brief Watches a file for changes
+ *
+ * Where inotify is available, the directory of the file is watched, and a change is reported when a
+ * file of the watched name is closed after writing, or is moved into the directory, so both
+ * rewriting the file in place and atomically replacing it with a rename are noticed.
+ * Elsewhere, the modification time and the size of the file are polled every poll_interval.
+ *
+ * One thread may wait for changes, while any other thread may stop the watch.
+ */
+struct file_watch {
+    /// The period of checking the file where inotify is not available
+    constexpr static std::chrono::milliseconds poll_interval{250};
+
+    /**
+     * \brief Starts watching a file
+     *
+     * Changes made after the constructor returns are reported by wait.
+     * If the directory of the file cannot be watched, an `std::invalid_argument` exception is
+     * thrown.
+     *
+     * \param file The file to watch
+     */
+    explicit file_watch(const std::filesystem::path& file);
+
+    file_watch(const file_watch&) = delete;
+    file_watch&
+    operator=(const file_watch&) = delete;
+
+    /**
+     * \brief Stops watching the file
+     */
+    ~file_watch() noexcept;
+
+    /**
+     * \brief Waits for a change of the file
+     *
+     * Blocks until the file changes, or the watch is stopped.
+     * Changes made in quick succession may be reported once.
+     *
+     * \return True, if the file changed, false, if the watch was stopped.
+     */
+    bool
+    wait();
+
+    /**
+     * \brief Stops the watch
+     *
+     * Makes the current and all later calls to wait return false.
+     * Thread-safe.
+     */
+    void
+    stop() noexcept;
+
+private:
+    std::filesystem::path _file; ///< The watched file
+#ifdef CONFY_HAS_INOTIFY
+    int _inotify = -1;      ///< The inotify instance watching the directory of the file
+    int _stop[2] = {-1, -1}; ///< The pipe written to stop the watch
+#else
+    /**
+     * \brief Reads the identity of the file
+     *
+     * \param mtime The modification time of the file, if it exists
+     * \param size The size of the file, if it exists
+     */
+    void
+    stat(std::filesystem::file_time_type& mtime, std::uintmax_t& size) const;
+
+    std::mutex _mutex;                   ///< The mutex guarding _stopped
+    std::condition_variable _stopped_cv; ///< Signaled when the watch is stopped
+    bool _stopped = false;               ///< Whether the watch was stopped
+    std::filesystem::file_time_type _mtime{}; ///< The last seen modification time of the file
+    std::uintmax_t _size = 0;                 ///< The last seen size of the file
+#endif
+};
+
+#endif
@@ -0,0 +1,142 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file image_cache.cpp
+ * \brief Implements the image_cache class
+ */
+
+#include "image_cache.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "key_hash.hpp"
+
+#include "memtrace.h"
+
+namespace {
+    using file_time = std::filesystem::file_time_type;
+
+    /// How long after its modification a file may still change without changing its modification time
+    constexpr std::chrono::seconds racy_window{2};
+
+    std::int64_t
+    ticks_of(file_time time) noexcept {
+        return static_cast<std::int64_t>(time.time_since_epoch().count());
+    }
+
+    /**
+     * \brief Checks whether a file was recorded too soon after its modification
+     *
+     * File systems with a coarse timestamp granularity may give a file modified again right after it
+     * was recorded the same modification time, so such records cannot be trusted without comparing
+     * the contents.
+     *
+     * \param source The recorded identity of the file
+     * \return Whether the modification time of the file cannot tell apart later changes.
+     */
+    bool
+    racy(const image_source& source) noexcept {
+        auto window = std::chrono::duration_cast<file_time::duration>(racy_window).count();
+        return source.checked - source.mtime < window;
+    }
+}
+
+image_cache::image_cache(const std::filesystem::path& cfg_file)
+     : _file(cfg_file) {
+    auto dir = directory();
+    if (dir.empty()) return;
+    try {
+        _source.path = hash_key(std::filesystem::canonical(cfg_file).string());
+    } catch (const std::exception&) {
+        return;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.confyb", static_cast<unsigned long long>(_source.path));
+    _image = dir / name;
+}
+
+std::filesystem::path
+image_cache::directory() {
+    if (std::getenv("CONFY_NO_CACHE")) return {};
+    auto xdg = std::getenv("XDG_CACHE_HOME");
+    // relative paths are invalid in XDG_CACHE_HOME, and must be ignored
+    if (xdg && std::filesystem::path(xdg).is_absolute()) return std::filesystem::path(xdg) / "confy";
+    auto home = std::getenv("HOME");
+    if (home && *home) return std::filesystem::path(home) / ".cache" / "confy";
+    return {};
+}
+
+bool
+image_cache::fresh() {
+    _outdated = false;
+    _same_file = false;
+    _identified = enabled() && identify();
+    if (!_identified) return false;
+
+    auto readable = read_image_source(_image, _cached);
+    _same_file = readable && _cached.path == _source.path && _cached.size == _source.size;
+    return _same_file && _cached.mtime == _source.mtime && !racy(_cached);
+}
+
+bool
+image_cache::fresh(std::string_view contents) {
+    _outdated = false;
+    if (!_identified) return false;
+
+    _source.hash = hash_key(contents);
+    if (_same_file && _cached.hash == _source.hash) {
+        // rerecord a touched file, or a file no longer modified too recently, so it is not hashed again
+        _outdated = _cached.mtime != _source.mtime || !racy(_source);
+        return true;
+    }
+    _outdated = true;
+    return false;
+}
+
+bool
+image_cache::identify() {
+    // taken before the contents are read, so changes made while reading count as too recent
+    auto checked = ticks_of(file_time::clock::now());
+    std::error_code ec;
+    auto size = std::filesystem::file_size(_file, ec);
+    if (ec) return false;
+    auto mtime = std::filesystem::last_write_time(_file, ec);
+    if (ec) return false;
+    _source.size = static_cast<std::uint64_t>(size);
+    _source.mtime = ticks_of(mtime);
+    _source.checked = checked;
+    return true;
+}
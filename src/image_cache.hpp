@@ -0,0 +1,189 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file image_cache.hpp
+ * \brief Defines the image_cache type
+ *
+ * This file defines the image_cache class, which keeps compiled images of configuration files in a
+ * per-user cache directory, so the files need not be parsed again while they do not change.
+ */
+
+#ifndef CONFY_IMAGE_CACHE_HPP
+#define CONFY_IMAGE_CACHE_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/filesystem>
+#  define filesystem experimental::filesystem
+#else
+#  include <filesystem>
+#endif
+#include <exception>
+#include <string_view>
+#include <system_error>
+
+#include "config_image.hpp"
+
+/**
+ * \brief Sidecar cache of compiled images
+ *
+ * Finds the cached image of a configuration file, and tells whether it is still fresh.
+ * The images are kept in the confy directory of `$XDG_CACHE_HOME`, or of `$HOME/.cache`, if the
+ * former is not set, named after the hash of the canonical path of the file.
+ * Setting `$CONFY_NO_CACHE` disables the cache.
+ *
+ * An image is fresh if it was compiled from a file at the same path, with the same size, and either
+ * the same modification time, or the same contents.
+ * The contents are only compared if the modification time differs, or if the file was modified
+ * shortly before the image recorded it, in which case a later change could have kept the same
+ * modification time.
+ * So looking up a key in an unchanged file only costs a few system calls, and mapping the image.
+ * The contents are hashed from the buffer the caller loads to parse, so a file is read once, whether
+ * its image turns out to be fresh or not.
+ */
+struct image_cache {
+    /**
+     * \brief Locates the cached image of a file
+     *
+     * Only resolves the canonical path of the file; if it cannot be resolved, the cache is disabled.
+     *
+     * \param cfg_file The configuration file
+     */
+    explicit image_cache(const std::filesystem::path& cfg_file);
+
+    /**
+     * \brief Returns the cache directory
+     *
+     * \return The directory holding the cached images, or an empty path, if the cache is disabled.
+     */
+    static std::filesystem::path
+    directory();
+
+    /**
+     * \brief Checks whether the cache is used
+     *
+     * \return Whether there is a cache directory to keep the image in.
+     */
+    bool
+    enabled() const noexcept { return !_image.empty(); }
+
+    /**
+     * \brief Getter for the cached image
+     *
+     * \return The path of the cached image of the file
+     */
+    const std::filesystem::path&
+    image() const noexcept { return _image; }
+
+    /**
+     * \brief Checks whether the cached image is fresh by the identity of the file
+     *
+     * Compares the size and modification time of the file to the ones recorded in the image, without
+     * reading the file.
+     * If the image is not found fresh, the file is to be loaded, and its contents passed to the
+     * overload taking them.
+     *
+     * \return Whether the image may be used instead of the file.
+     */
+    bool
+    fresh();
+
+    /**
+     * \brief Checks whether the cached image is fresh by the contents of the file
+     *
+     * Called after the identity check failed, with the contents of the file loaded to parse it.
+     * Hashes the contents before the parse writes to them, so a following store can record them,
+     * and compares the hash to the one recorded in the image.
+     *
+     * \param contents The contents of the file
+     * \return Whether the image may be used instead of the file.
+     */
+    bool
+    fresh(std::string_view contents);
+
+    /**
+     * \brief Marks the cached image as unusable
+     *
+     * Called when an image found fresh fails to open, so the contents check fails, and the following
+     * store replaces the image instead of keeping the damaged image around.
+     */
+    void
+    reject() noexcept { _same_file = false; }
+
+    /**
+     * \brief Stores the image of a set loaded from the file
+     *
+     * Compiles the set into the cache, recording the identity of the file found by the freshness
+     * checks, unless the image was fresh and already records it.
+     * Errors are ignored: a cache that cannot be written is just not used.
+     *
+     * \tparam Set The type of the set.
+     * \param set The set loaded from the file, or from the image
+     */
+    template<class Set>
+    void
+    store(const Set& set) noexcept {
+        if (!_outdated) return;
+        try {
+            std::error_code ec;
+            std::filesystem::create_directories(_image.parent_path(), ec);
+            set.compile(_image, _source);
+            _outdated = false;
+        } catch (const std::exception&) {
+            // a read-only or full cache directory only costs the next lookup a parse
+        }
+    }
+
+private:
+    /**
+     * \brief Finds the size and modification time of the file
+     *
+     * \return Whether the file exists and could be examined.
+     */
+    bool
+    identify();
+
+    std::filesystem::path _file;  ///< The configuration file
+    std::filesystem::path _image; ///< The cached image of the file, empty if the cache is disabled
+    image_source _source;         ///< The identity of the file
+    image_source _cached;         ///< The identity recorded in the image
+    bool _identified = false;     ///< Whether the file could be examined
+    bool _same_file = false;      ///< Whether the image was compiled from a file at the same path, of the same size
+    bool _outdated = false;       ///< Whether store needs to write the image
+};
+
+#endif
@@ -0,0 +1,249 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file inline_cache.hpp
+ * \brief Defines the inline_cache type
+ *
+ * This file defines the inline_cache class, the allocation-free cache config uses for the built-in
+ * cachable types.
+ */
+
+#ifndef CONFY_INLINE_CACHE_HPP
+#define CONFY_INLINE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * \brief A list of types
+ *
+ * \tparam Ts The types of the list
+ */
+template<class... Ts>
+struct inline_cache_types { };
+
+/// The built-in cachable types, in the order of their tags
+using inline_cached_types = inline_cache_types<signed char, unsigned char, char,
+                                               short, unsigned short,
+                                               int, unsigned,
+                                               long, unsigned long,
+                                               long long, unsigned long long,
+                                               bool,
+                                               float, double, long double>;
+
+/**
+ * \brief Returns the tag of a type in a list of types
+ *
+ * \tparam T The type to look for
+ * \tparam Ts The types of the list
+ * \return The 1-based index of T in the list, or 0, if it is not in the list.
+ */
+template<class T, class... Ts>
+constexpr std::uint8_t
+inline_cache_tag_in(inline_cache_types<Ts...>) noexcept {
+    std::uint8_t tag = 0;
+    std::uint8_t idx = 0;
+    static_cast<void>(((++idx, tag = std::is_same<T, Ts>::value ? idx : tag), ...));
+    return tag;
+}
+
+/**
+ * \brief The tag of a type in an inline_cache
+ *
+ * Non-zero for the fifteen built-in cachable types, zero for every other type.
+ *
+ * \tparam T The type to get the tag of
+ */
+template<class T>
+constexpr std::uint8_t inline_cache_tag = inline_cache_tag_in<T>(inline_cached_types{});
+
+struct cache_table;
+
+/**
+ * \brief Inline cache of a built-in value
+ *
+ * Stores a value of one of the built-in cachable types in a small buffer, along with a tag telling
+ * which type it is, so no cache object needs to be allocated.
+ * The buffer is as large as the common built-in types, so every config entry stays small; values of
+ * larger types, like `long double` on most platforms, are not stored.
+ * Once an entry caches conversions to more types, its buffer points to the cache_table of the entry
+ * instead, which then holds all its conversions, including the one moved from the buffer.
+ * Looking up the value is a single tag comparison.
+ * All the stored types are trivially copyable, so the value is copied in and out of the buffer
+ * bytewise.
+ */
+struct inline_cache {
+    /**
+     * \brief Checks whether a type is a built-in cachable type
+     *
+     * The values of these types are cached bytewise, inline or in a cache_table.
+     *
+     * \tparam T The type to check
+     * \return Whether T is one of the built-in cachable types.
+     */
+    template<class T>
+    constexpr static bool
+    builtin() noexcept { return inline_cache_tag<T> != 0; }
+
+    /**
+     * \brief Checks whether a type may be stored
+     *
+     * \tparam T The type to check
+     * \return Whether the values of T fit the cache.
+     */
+    template<class T>
+    constexpr static bool
+    holds() noexcept { return builtin<T>() && sizeof(T) <= storage_size; }
+
+    /**
+     * \brief Gets the stored value
+     *
+     * \tparam T The type of the value to get, which must be a built-in type.
+     * \param out The object receiving the value, if one of type T is stored.
+     * \return Whether a value of type T is stored.
+     */
+    template<class T>
+    bool
+    get(T& out) const noexcept {
+        static_assert(builtin<T>(), "type not cached by inline_cache");
+        if constexpr (!holds<T>()) {
+            return false;
+        } else {
+            if (_tag != inline_cache_tag<T>) return false;
+            std::memcpy(&out, _storage, sizeof(T));
+            return true;
+        }
+    }
+
+    /**
+     * \brief Stores a value
+     *
+     * Replaces the stored value, whatever its type.
+     * Must not be called once the cache points to a table.
+     *
+     * \tparam T The type of the value to store, which the cache must hold.
+     * \param value The value to store
+     */
+    template<class T>
+    void
+    store(const T& value) noexcept {
+        static_assert(holds<T>(), "type not stored by inline_cache");
+        std::memcpy(_storage, &value, sizeof(T));
+        _tag = inline_cache_tag<T>;
+    }
+
+    /**
+     * \brief Passes the stored value to a function
+     *
+     * \tparam F The type of the function, callable with each type the cache holds.
+     * \param fn The function to call with the stored value
+     * \return Whether a value is stored, and was passed to the function.
+     */
+    template<class F>
+    bool
+    visit(F&& fn) const { return visit_in(fn, inline_cached_types{}); }
+
+    /**
+     * \brief Checks whether a value is stored
+     *
+     * \return Whether neither a value, nor a table is stored.
+     */
+    bool
+    empty() const noexcept { return _tag == 0; }
+
+    /**
+     * \brief Returns the table stored instead of a value
+     *
+     * \return The stored table, or nullptr, if there is none.
+     */
+    cache_table*
+    table() const noexcept {
+        if (_tag != table_tag) return nullptr;
+        cache_table* table;
+        std::memcpy(&table, _storage, sizeof(table));
+        return table;
+    }
+
+    /**
+     * \brief Stores a table instead of the value
+     *
+     * The stored value, if any, is dropped; visit it first to keep it.
+     * The table is not owned by the cache; its owner has to delete it.
+     *
+     * \param table The table to store
+     */
+    void
+    spill(cache_table* table) noexcept {
+        std::memcpy(_storage, &table, sizeof(table));
+        _tag = table_tag;
+    }
+
+private:
+    /**
+     * \brief Passes the stored value to a function, if it is of one of the listed types
+     *
+     * \return Whether the value was passed.
+     */
+    template<class F, class... Ts>
+    bool
+    visit_in(F& fn, inline_cache_types<Ts...>) const { return (visit_as<Ts>(fn) || ...); }
+
+    /**
+     * \brief Passes the stored value to a function, if it is of type T
+     *
+     * \return Whether the value was passed.
+     */
+    template<class T, class F>
+    bool
+    visit_as(F& fn) const {
+        if constexpr (!holds<T>()) {
+            return false;
+        } else {
+            T value;
+            if (!get(value)) return false;
+            fn(static_cast<const T&>(value));
+            return true;
+        }
+    }
+
+    /// The size of the buffer, fitting the common built-in types and a pointer
+    constexpr static std::size_t storage_size = sizeof(long long) > sizeof(void*) ? sizeof(long long) : sizeof(void*);
+    /// The tag of the buffer holding a table
+    constexpr static std::uint8_t table_tag = 0xff;
+
+    unsigned char _storage[storage_size] = {}; ///< The bytes of the stored value, or table
+    std::uint8_t _tag = 0;                     ///< The tag of the type of the stored value
+};
+
+#endif
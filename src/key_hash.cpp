@@ -0,0 +1,81 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file key_hash.cpp
+ * \brief Implements the hash function of configuration keys
+ */
+
+#include "key_hash.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include "memtrace.h"
+
+namespace {
+    constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+
+    std::uint64_t
+    mix(std::uint64_t x) noexcept {
+        x ^= x >> 32;
+        x *= 0xd6e8feb86659fd93ULL;
+        x ^= x >> 32;
+        x *= 0xd6e8feb86659fd93ULL;
+        x ^= x >> 32;
+        return x;
+    }
+
+    std::uint64_t
+    load64(const char* ptr, std::size_t n) noexcept {
+        std::uint64_t word = 0;
+        std::memcpy(&word, ptr, n);
+        return word;
+    }
+}
+
+std::uint64_t
+hash_key(std::string_view key) noexcept {
+    auto h = mix(key.size() * multiplier);
+    auto ptr = key.data();
+    auto rest = key.size();
+    for (; rest >= 8; ptr += 8, rest -= 8) {
+        h = (h ^ load64(ptr, 8)) * multiplier;
+        h = (h << 29) | (h >> 35);
+    }
+    if (rest) h = (h ^ load64(ptr, rest)) * multiplier;
+    return mix(h);
+}
+
+std::uint64_t
+rehash_key(std::uint64_t h, std::uint64_t seed) noexcept {
+    return mix(h + (seed + 1) * multiplier);
+}
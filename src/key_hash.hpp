@@ -0,0 +1,80 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file key_hash.hpp
+ * \brief Declares the hash function of configuration keys
+ *
+ * The hashing key indices of config_set all derive their hashes from hash_key.
+ */
+
+#ifndef CONFY_KEY_HASH_HPP
+#define CONFY_KEY_HASH_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <string_view>
+#endif
+#include <cstdint>
+
+/**
+ * \brief Hashes a configuration key
+ *
+ * A fast 64-bit hash reading the key 8 bytes at a time, with a final avalanche step, so that any
+ * bits of the result may be used as independent hashes.
+ *
+ * \param key The key to hash
+ * \return The hash of the key
+ */
+std::uint64_t
+hash_key(std::string_view key) noexcept;
+
+/**
+ * \brief Remixes a hash
+ *
+ * Derives a new, independent hash from a hash and a seed.
+ *
+ * \param h The hash to remix
+ * \param seed The seed of the new hash
+ * \return The new hash
+ */
+std::uint64_t
+rehash_key(std::uint64_t h, std::uint64_t seed) noexcept;
+
+#endif
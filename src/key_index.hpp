@@ -0,0 +1,138 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file key_index.hpp
+ * \brief Defines the key index concept
+ *
+ * Defines the formalized concept of a key index that config_set may use to look up its entries.
+ */
+
+#ifndef CONFY_KEY_INDEX_HPP
+#define CONFY_KEY_INDEX_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <concepts>
+#  include <string_view>
+#endif
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef USE_CXX17
+
+/**
+ * \brief The key index concept
+ *
+ * This concept is used to check whether a given type meets the formal requirements of being a key
+ * index type.
+ *
+ * A key index is built once, after all entries of a config_set are known, from the number of
+ * entries and a function returning the key of the entry at a given position.
+ * At build time the keys are sorted and unique.
+ * Building returns the order in which the entries are to be stored: the ith stored entry is the
+ * entry at position order[i] of the sorted entries.
+ * An empty order keeps the entries sorted.
+ *
+ * Afterwards, the index finds the position of the stored entry with a given key, using the same kind
+ * of function to access the keys of the stored entries, or returns npos, if there is no such entry.
+ *
+ * \tparam T The type to check.
+ */
+template<class T>
+concept key_index = std::default_initializable<T>
+                    && requires(T t, const T ct, std::string_view (&key_at)(std::size_t)) {
+                           { t.build(std::size_t{}, key_at) } -> std::same_as<std::vector<std::size_t>>;
+                           { ct.find(std::string_view{}, key_at) } -> std::same_as<std::size_t>;
+                           { T::npos } -> std::convertible_to<std::size_t>;
+                       };
+
+/**
+ * \brief The batched key index concept
+ *
+ * Checks whether a key index can also look up a batch of keys at once.
+ * Such an index finds the positions of count keys, writing them, or npos for the missing keys, to
+ * the output array.
+ * Looking up many keys at once allows the index to interleave the lookups, and overlap their memory
+ * accesses.
+ *
+ * \tparam T The type to check.
+ */
+template<class T>
+concept batched_key_index = key_index<T>
+                            && requires(const T ct, std::string_view (&key_at)(std::size_t),
+                                        const std::string_view* keys, std::size_t* out) {
+                                   ct.find_many(keys, std::size_t{}, out, key_at);
+                               };
+
+/**
+ * \brief Checks whether a type is a batched key index
+ *
+ * \tparam T The type to check.
+ */
+template<class T>
+struct is_batched_key_index : std::bool_constant<batched_key_index<T>> { };
+
+#else
+
+/**
+ * \brief Checks whether a type is a batched key index
+ *
+ * Substitutes the batched_key_index concept, where concepts are not available.
+ * Checks that the type provides the find_many member function.
+ *
+ * \tparam T The type to check.
+ */
+template<class T, class = void>
+struct is_batched_key_index : std::false_type { };
+
+template<class T>
+struct is_batched_key_index<T, decltype(std::declval<const T&>().find_many(std::declval<const std::string_view*>(),
+                                                                           std::size_t{},
+                                                                           std::declval<std::size_t*>(),
+                                                                           std::declval<std::string_view (&)(std::size_t)>()),
+                                        void())>
+     : std::true_type { };
+
+#endif
+
+#endif
@@ -59,6 +59,7 @@
 
 int
 main(int argc, char** argv) try {
+    if (is_compile_mode(argc, argv)) return compile_mode(argv[2], argv[3]);
     if (argc >= 3) {
         std::vector<std::string_view> args(argv + 2,
                                            argv + argc);
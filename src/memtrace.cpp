@@ -262,14 +262,19 @@ END_NAMESPACE
 
 START_NAMESPACE
 static int allocated_blks;
+static unsigned long allocations;
 
 int
 allocated_blocks() { return allocated_blks; }
 
+unsigned long
+allocations_made() { return allocations; }
+
 static BOOL
 register_memory(void* p, size_t size, call_t call) {
     initialize();
     allocated_blks++;
+    allocations++;
 #  ifdef MEMTRACE_TO_FILE
     fprintf(trace_file, "%p\t%d\t%s%s", PU(p), (int) size, pretty[call.f], call.par_txt ? call.par_txt : "?");
     if (call.f <= 3) fprintf(trace_file, ")");
@@ -98,6 +98,8 @@ inclue-ok:  2017., 2018., 2019., 2021.
 START_NAMESPACE
 int
 allocated_blocks();
+unsigned long
+allocations_made();
 END_NAMESPACE
 
 #  if defined(MEMTRACE_TO_MEMORY)
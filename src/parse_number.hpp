@@ -0,0 +1,762 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file parse_number.hpp
+ * \brief Locale independent number parsing on string views
+ *
+ * Defines the parse_integer and parse_floating functions the built-in cache_factory types use to
+ * convert the stored values.
+ * These follow the behavior of the `std::strtol` family in the "C" locale--leading whitespace and
+ * a sign are accepted, parsing stops at the first character that cannot be part of the number, and
+ * a number that does not fit its type saturates--but need no NUL-terminated string, read nothing
+ * past the view, and do not depend on the current locale.
+ */
+
+#ifndef CONFY_PARSE_NUMBER_HPP
+#define CONFY_PARSE_NUMBER_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <cfloat>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <string_view>
+#endif
+
+/**
+ * \brief Skips the leading whitespace of a number
+ *
+ * Whitespace is the set of characters `std::isspace` accepts in the "C" locale.
+ *
+ * \param first The beginning of the text.
+ * \param last The end of the text.
+ * \return The first non-whitespace character, or last.
+ */
+inline const char*
+skip_number_space(const char* first, const char* last) noexcept {
+    while (first != last
+           && (*first == ' ' || *first == '\t' || *first == '\n'
+               || *first == '\v' || *first == '\f' || *first == '\r')) {
+        ++first;
+    }
+    return first;
+}
+
+/**
+ * \brief Saturates a parsed magnitude to T
+ *
+ * Signed types saturate at their minimum and maximum.
+ * `unsigned short` was always parsed as a signed long, so it saturates at 0 and its maximum: "-1" is
+ * 0.
+ * The other unsigned types behave like `std::strtoull` followed by saturation at the maximum of T: a
+ * negative number is negated in unsigned arithmetic, so "-1" is the maximum of T.
+ *
+ * \tparam T The integral type parsed.
+ * \param magnitude The absolute value of the number parsed.
+ * \param negative Whether the number had a minus sign.
+ * \param overflow Whether the magnitude did not fit 64 bits.
+ * \return The saturated value.
+ */
+template<class T>
+T
+saturate_integer(unsigned long long magnitude, bool negative, bool overflow) noexcept {
+    if (std::is_signed<T>::value) {
+        using limits = std::numeric_limits<T>;
+        const auto max = static_cast<unsigned long long>(limits::max());
+        if (negative) {
+            return overflow || magnitude > max + 1 ? limits::min()
+                                                   : static_cast<T>(-static_cast<long long>(magnitude - 1) - 1);
+        }
+        return overflow || magnitude > max ? limits::max() : static_cast<T>(magnitude);
+    }
+    if (std::is_same<T, unsigned short>::value) {
+        auto wide = saturate_integer<long long>(magnitude, negative, overflow);
+        if (wide < 0) return 0;
+        return wide > std::numeric_limits<T>::max() ? std::numeric_limits<T>::max() : static_cast<T>(wide);
+    }
+    const auto max = static_cast<unsigned long long>(std::numeric_limits<T>::max());
+    unsigned long long value = overflow ? std::numeric_limits<unsigned long long>::max()
+                                        : negative ? 0ULL - magnitude : magnitude;
+    return value > max ? std::numeric_limits<T>::max() : static_cast<T>(value);
+}
+
+/**
+ * \brief Parses an integer, saturating at the bounds of T
+ *
+ * Parses an optionally signed integer from the beginning of the data.
+ * The integer is decimal, unless prefixed with `0x` for hexadecimal, `0o` for octal, or `0b` for
+ * binary, in either case. A prefix with no digits after it is the number 0, followed by text.
+ * The value saturates as saturate_integer describes.
+ *
+ * \tparam T The integral type to parse.
+ * \param data The text to parse.
+ * \param out The object receiving the parsed value, if parsing succeeds.
+ * \return Whether there was a number to parse.
+ */
+template<class T>
+bool
+parse_integer(std::string_view data, T& out) noexcept {
+    static_assert(std::is_integral<T>::value, "parse_integer parses integral types");
+    const char* first = skip_number_space(data.data(), data.data() + data.size());
+    const char* last = data.data() + data.size();
+
+    bool negative = false;
+    if (first != last && (*first == '-' || *first == '+')) {
+        negative = *first == '-';
+        ++first;
+    }
+
+    int base = 10;
+    if (last - first > 1 && first[0] == '0') {
+        switch (first[1]) {
+        case 'x':
+        case 'X': base = 16; break;
+        case 'o':
+        case 'O': base = 8; break;
+        case 'b':
+        case 'B': base = 2; break;
+        default: break;
+        }
+    }
+
+    unsigned long long magnitude;
+    std::from_chars_result res;
+    if (base == 10) {
+        res = std::from_chars(first, last, magnitude);
+        if (res.ec == std::errc::invalid_argument) return false;
+    } else {
+        res = std::from_chars(first + 2, last, magnitude, base);
+        if (res.ec == std::errc::invalid_argument) { // just the 0 before the prefix letter
+            magnitude = 0;
+            res.ec = std::errc();
+        }
+    }
+    out = saturate_integer<T>(magnitude, negative, res.ec == std::errc::result_out_of_range);
+    return true;
+}
+
+/**
+ * \brief Decodes a fixed width run of hexadecimal digits
+ *
+ * Decodes 1 to 8 hexadecimal digits, in either case, like the 6 or 8 digits of an `RRGGBB` or
+ * `RRGGBBAA` color, into the packed integer they spell, e.g. `0xRRGGBB`.
+ * The digits are validated and converted as a single 64-bit word, without a per-character loop.
+ *
+ * \param digits The digits to decode, at least width characters.
+ * \param width The number of digits, from 1 to 8.
+ * \param out The object receiving the decoded value, if all characters were hexadecimal digits.
+ * \return Whether all characters were hexadecimal digits.
+ */
+inline bool
+decode_hex_fixed(const char* digits, std::size_t width, std::uint32_t& out) noexcept {
+    constexpr std::uint64_t ones = 0x0101010101010101;
+    constexpr std::uint64_t highs = 0x8080808080808080;
+    if (width == 0 || width > 8) return false;
+
+    // right-align the digits in eight, padded with leading '0's, the first digit the lowest byte
+    std::uint64_t word = ones * '0';
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (width == 8) {
+        std::memcpy(&word, digits, sizeof word);
+    } else {
+        // at most two overlapping loads, no byte at a time copying
+        std::uint64_t tail;
+        if (width >= 4) {
+            std::uint32_t head, rest;
+            std::memcpy(&head, digits, sizeof head);
+            std::memcpy(&rest, digits + width - 4, sizeof rest);
+            tail = head | std::uint64_t(rest) << (width - 4) * 8;
+        } else {
+            auto byte = [digits](std::size_t idx) { return std::uint64_t(static_cast<unsigned char>(digits[idx])); };
+            tail = byte(0) | byte(width / 2) << (width / 2 * 8) | byte(width - 1) << ((width - 1) * 8);
+        }
+        auto pad_bits = (8 - width) * 8;
+        word = tail << pad_bits | word >> (64 - pad_bits);
+    }
+#else
+    unsigned char bytes[8] = {'0', '0', '0', '0', '0', '0', '0', '0'};
+    std::memcpy(bytes + 8 - width, digits, width);
+    for (int i = 7; i >= 0; --i) word = word << 8 | bytes[i];
+#endif
+
+    // the bytes of in_range have their high bit set where lo <= byte <= hi, for bytes below 0x80
+    auto in_range = [](std::uint64_t w, std::uint64_t lo, std::uint64_t hi) {
+        return (w + ones * (0x80 - lo)) & ~(w + ones * (0x7F - hi)) & highs;
+    };
+    auto lower = word | ones * 0x20;
+    auto valid = in_range(word, '0', '9') | in_range(lower, 'a', 'f');
+    if ((word & highs) != 0 || valid != highs) return false;
+
+    // '0'-'9' are 0x30-0x39, letters 0x41-0x46 or 0x61-0x66: the low nibble, plus 9 for letters
+    auto nibbles = (word & ones * 0x0F) + ((word >> 6) & ones) * 9;
+    // pair the nibbles into bytes, the earlier digit the high nibble, then the bytes into a word
+    auto packed = ((nibbles << 4) | (nibbles >> 8)) & 0x00FF00FF00FF00FF;
+    packed = (packed | (packed >> 8)) & 0x0000FFFF0000FFFF;
+    packed = (packed | (packed >> 16)) & 0x00000000FFFFFFFF;
+    auto value = static_cast<std::uint32_t>(packed);
+    out = (value >> 24) | ((value >> 8) & 0x0000FF00) | ((value << 8) & 0x00FF0000) | (value << 24);
+    return true;
+}
+
+/**
+ * \brief Parses a bare hexadecimal integer, saturating at the maximum of T
+ *
+ * Parses an unprefixed, unsigned hexadecimal integer, like the `RRGGBB` colors, from the
+ * beginning of the data, after optional whitespace.
+ * Values of at most 8 digits with nothing after them are decoded by decode_hex_fixed.
+ *
+ * \tparam T The integral type to parse.
+ * \param data The text to parse.
+ * \param out The object receiving the parsed value, if parsing succeeds.
+ * \return Whether there was a number to parse.
+ */
+template<class T>
+bool
+parse_hex(std::string_view data, T& out) noexcept {
+    static_assert(std::is_integral<T>::value, "parse_hex parses integral types");
+    std::uint32_t fixed;
+    if (decode_hex_fixed(data.data(), data.size(), fixed)) {
+        out = saturate_integer<T>(fixed, false, false);
+        return true;
+    }
+
+    const char* first = skip_number_space(data.data(), data.data() + data.size());
+    const char* last = data.data() + data.size();
+    unsigned long long magnitude;
+    auto res = std::from_chars(first, last, magnitude, 16);
+    if (res.ec == std::errc::invalid_argument) return false;
+    out = saturate_integer<T>(magnitude, false, res.ec == std::errc::result_out_of_range);
+    return true;
+}
+
+/**
+ * \brief Converts a number with the C library's `strto*` function for T
+ *
+ * The number is copied to a terminated buffer first, on the stack when it is short enough, so the
+ * whole number is converted however long it is.
+ *
+ * \tparam T The floating point type to parse.
+ * \param first The first character of the number, after its sign.
+ * \param last The end of the number.
+ * \param value The object receiving the converted value.
+ * \return The end of the converted number, first if there was no number to convert.
+ */
+template<class T>
+const char*
+strto_floating(const char* first, const char* last, T& value) noexcept {
+    char small[128];
+    std::string large;
+    auto len = static_cast<std::size_t>(last - first);
+    char* buf = small;
+    if (len >= sizeof small) {
+        large.assign(first, len);
+        buf = &large[0];
+    } else {
+        std::memcpy(buf, first, len);
+        buf[len] = '\0';
+    }
+    char* end;
+    if (std::is_same<T, float>::value) {
+        value = static_cast<T>(std::strtof(buf, &end));
+    } else if (std::is_same<T, double>::value) {
+        value = static_cast<T>(std::strtod(buf, &end));
+    } else {
+        value = static_cast<T>(std::strtold(buf, &end));
+    }
+    return first + (end - buf);
+}
+
+/**
+ * \brief A decimal number split into its parts
+ *
+ * The value of the number is `mantissa * 10^exponent`.
+ */
+struct decimal_number {
+    std::uint64_t mantissa = 0; ///< The first at most 19 significant digits
+    long exponent = 0;          ///< The decimal exponent of the mantissa
+    bool truncated = false;     ///< Whether there were more significant digits than the mantissa holds
+};
+
+/**
+ * \brief Accumulates the run of digits at the beginning of a text
+ *
+ * Appends the digits to the mantissa, eight at a time where possible, by checking and converting
+ * eight characters in a 64-bit word, then one at a time.
+ * The mantissa wraps around if there are too many digits, the caller shall count them.
+ *
+ * \param first The beginning of the text.
+ * \param last The end of the text.
+ * \param mantissa The mantissa to append the digits to.
+ * \return The first character that is not a digit, or last.
+ */
+inline const char*
+accumulate_digits(const char* first, const char* last, std::uint64_t& mantissa) noexcept {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (last - first >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, first, sizeof word);
+        // every byte is 0x30-0x39: the high nibbles are 3, and adding 6 does not carry into them
+        if (((word & 0xF0F0F0F0F0F0F0F0) | (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+            != 0x3333333333333333) {
+            break;
+        }
+        word -= 0x3030303030303030;
+        word = word * 10 + (word >> 8);
+        word = (((word & 0x000000FF000000FF) * 0x000F424000000064)
+                + (((word >> 16) & 0x000000FF000000FF) * 0x0000271000000001))
+               >> 32;
+        mantissa = mantissa * 100'000'000 + static_cast<std::uint32_t>(word);
+        first += 8;
+    }
+#endif
+    for (; first != last && static_cast<unsigned char>(*first - '0') < 10; ++first) {
+        mantissa = mantissa * 10 + static_cast<unsigned>(*first - '0');
+    }
+    return first;
+}
+
+/**
+ * \brief Splits a decimal number into its parts
+ *
+ * Reads the digits, the fraction and the exponent of a decimal number, without its sign.
+ * An `e` not followed by an exponent is not part of the number, as for `std::strtod`.
+ *
+ * \param first The first character of the number, after its sign.
+ * \param last The end of the text.
+ * \param out The parts of the number.
+ * \return Whether the text started with a decimal number.
+ */
+inline bool
+split_decimal(const char* first, const char* last, decimal_number& out) noexcept {
+    constexpr long max_digits = 19;
+
+    // most numbers are short: accumulate all digits, redo it below if there were too many
+    auto int_first = first;
+    first = accumulate_digits(first, last, out.mantissa);
+    auto int_last = first;
+    auto frac_first = first;
+    if (first != last && *first == '.') {
+        frac_first = ++first;
+        first = accumulate_digits(first, last, out.mantissa);
+    }
+    auto frac_last = first;
+    if (int_first == int_last && frac_first == frac_last) return false;
+    out.exponent = -(frac_last - frac_first);
+
+    auto sig_first = int_first;
+    while (sig_first != int_last && *sig_first == '0') ++sig_first;
+    if (sig_first == int_last) {
+        sig_first = frac_first;
+        while (sig_first != frac_last && *sig_first == '0') ++sig_first;
+    }
+    auto significant = sig_first < int_last ? (int_last - sig_first) + (frac_last - frac_first)
+                                            : frac_last - sig_first;
+    if (significant > max_digits) {
+        // keep the first max_digits significant digits, the rest only move the exponent
+        out.mantissa = 0;
+        out.exponent = 0;
+        long kept = 0;
+        for (auto it = sig_first; it != frac_last; ++it) {
+            if (it == int_last) continue; // the decimal point
+            bool fraction = it >= frac_first;
+            if (kept < max_digits) {
+                out.mantissa = out.mantissa * 10 + static_cast<unsigned>(*it - '0');
+                ++kept;
+                if (fraction) --out.exponent;
+            } else {
+                out.truncated |= *it != '0';
+                if (!fraction) ++out.exponent;
+            }
+        }
+        if (sig_first >= frac_first) out.exponent -= sig_first - frac_first; // leading fraction zeros
+    }
+
+    if (first != last && (*first == 'e' || *first == 'E')) {
+        auto exp_first = first + 1;
+        bool exp_negative = false;
+        if (exp_first != last && (*exp_first == '-' || *exp_first == '+')) {
+            exp_negative = *exp_first == '-';
+            ++exp_first;
+        }
+        if (exp_first != last && *exp_first >= '0' && *exp_first <= '9') {
+            long exp_value = 0;
+            for (; exp_first != last && *exp_first >= '0' && *exp_first <= '9'; ++exp_first) {
+                if (exp_value < 100'000) exp_value = exp_value * 10 + (*exp_first - '0');
+            }
+            out.exponent += exp_negative ? -exp_value : exp_value;
+        }
+    }
+    return true;
+}
+
+/**
+ * \brief The largest power of ten exactly representable in T
+ *
+ * 10^e is exact in T if 5^e fits its significand. Limited to 27, the largest such exponent of the
+ * 64-bit significand of the x87 long double.
+ *
+ * \tparam T The floating point type.
+ * \return The largest exponent e, for which 10^e is exact in T.
+ */
+template<class T>
+constexpr int
+exact_pow10_max() noexcept {
+    constexpr int digits = std::numeric_limits<T>::digits;
+    int e = 0;
+    std::uint64_t pow5 = 1;
+    while (e < 27 && (digits >= 64 || pow5 * 5 < (std::uint64_t(1) << (digits < 64 ? digits : 0)))) {
+        pow5 *= 5;
+        ++e;
+    }
+    return e;
+}
+
+/**
+ * \brief Converts the common, short decimal numbers exactly
+ *
+ * Clinger's fast path: if the mantissa of the number is exactly representable in T, and so is the
+ * power of ten it is to be scaled with, a single correctly rounded multiplication or division gives
+ * the correctly rounded result.
+ *
+ * \tparam T The floating point type to convert to.
+ * \param number The number to convert.
+ * \param out The object receiving the value, if the fast path applies.
+ * \return Whether the fast path applied.
+ */
+template<class T>
+bool
+clinger_floating(const decimal_number& number, T& out) noexcept {
+#if FLT_EVAL_METHOD != 0
+    // excess precision would round the intermediate results twice
+    if (!std::is_same<T, long double>::value) return false;
+#endif
+    static constexpr long double powers[] = {1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L,
+                                             1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L,
+                                             1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L,
+                                             1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L};
+    constexpr int digits = std::numeric_limits<T>::digits;
+    constexpr int max_exp = exact_pow10_max<T>();
+    constexpr std::uint64_t max_mantissa = digits >= 64 ? ~std::uint64_t(0)
+                                                        : std::uint64_t(1) << (digits < 64 ? digits : 0);
+
+    if (number.truncated || number.mantissa > max_mantissa) return false;
+    if (number.exponent < -max_exp || number.exponent > max_exp) return false;
+    T value = static_cast<T>(number.mantissa);
+    if (number.exponent < 0) {
+        value /= static_cast<T>(powers[-number.exponent]);
+    } else {
+        value *= static_cast<T>(powers[number.exponent]);
+    }
+    out = value;
+    return true;
+}
+
+/// The smallest decimal exponent in pow10_128
+constexpr int pow10_128_min = -348;
+/// The largest decimal exponent in pow10_128
+constexpr int pow10_128_max = 347;
+
+/**
+ * \brief The powers of ten as 128-bit mantissas
+ *
+ * Entry `e - pow10_128_min` holds the high and low 64 bits of 10^e, normalized so the highest bit is
+ * set, then rounded down.
+ */
+extern const std::uint64_t pow10_128[pow10_128_max - pow10_128_min + 1][2];
+
+/**
+ * \brief The bit layout of the IEEE binary floating point types
+ *
+ * Defined for the float and double types only, the types the Eisel-Lemire algorithm is used for.
+ *
+ * \tparam T The floating point type.
+ */
+template<class T>
+struct binary_format { };
+
+/**
+ * \brief The bit layout of the IEEE binary32 type
+ */
+template<>
+struct binary_format<float> {
+    using bits_type = std::uint32_t;                           ///< The same sized unsigned type
+    static constexpr int mantissa_bits = 23;                   ///< The stored bits of the significand
+    static constexpr std::uint64_t bias = 127;                 ///< The bias of the exponent
+    static constexpr std::uint64_t max_exponent = 0xFF;        ///< The exponent of infinities
+    static constexpr std::uint64_t low_mask = 0x3F'FFFF'FFFF;  ///< The bits shifted out of the product
+};
+
+/**
+ * \brief The bit layout of the IEEE binary64 type
+ */
+template<>
+struct binary_format<double> {
+    using bits_type = std::uint64_t;                           ///< The same sized unsigned type
+    static constexpr int mantissa_bits = 52;                   ///< The stored bits of the significand
+    static constexpr std::uint64_t bias = 1023;                ///< The bias of the exponent
+    static constexpr std::uint64_t max_exponent = 0x7FF;       ///< The exponent of infinities
+    static constexpr std::uint64_t low_mask = 0x1FF;           ///< The bits shifted out of the product
+};
+
+/**
+ * \brief Multiplies two 64-bit numbers into a 128-bit one
+ *
+ * \param lhs The left operand.
+ * \param rhs The right operand.
+ * \param lo The low 64 bits of the product.
+ * \return The high 64 bits of the product.
+ */
+inline std::uint64_t
+mul_64x64(std::uint64_t lhs, std::uint64_t rhs, std::uint64_t& lo) noexcept {
+#ifdef __SIZEOF_INT128__
+    __extension__ using uint128 = unsigned __int128;
+    auto product = static_cast<uint128>(lhs) * rhs;
+    lo = static_cast<std::uint64_t>(product);
+    return static_cast<std::uint64_t>(product >> 64);
+#else
+    std::uint64_t lhs_lo = lhs & 0xFFFF'FFFF, lhs_hi = lhs >> 32;
+    std::uint64_t rhs_lo = rhs & 0xFFFF'FFFF, rhs_hi = rhs >> 32;
+    std::uint64_t ll = lhs_lo * rhs_lo, lh = lhs_lo * rhs_hi, hl = lhs_hi * rhs_lo, hh = lhs_hi * rhs_hi;
+    std::uint64_t mid = (ll >> 32) + (lh & 0xFFFF'FFFF) + (hl & 0xFFFF'FFFF);
+    lo = (mid << 32) | (ll & 0xFFFF'FFFF);
+    return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+/**
+ * \brief Counts the leading zero bits of a non-zero number
+ *
+ * \param value The number, not zero.
+ * \return The number of leading zero bits.
+ */
+inline int
+leading_zeros(std::uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#else
+    int ret = 0;
+    for (; (value & (std::uint64_t(1) << 63)) == 0; value <<= 1) ++ret;
+    return ret;
+#endif
+}
+
+/**
+ * \brief Converts a decimal number with the Eisel-Lemire algorithm
+ *
+ * Multiplies the mantissa with the 128-bit approximation of the power of ten, and if the bits of
+ * the product decide the rounding, constructs the correctly rounded value from them.
+ * The ambiguous cases, results that are subnormal, infinite, or lie too close to a halfway point,
+ * and truncated mantissas are left to the exact conversion of the library.
+ *
+ * \tparam T The floating point type to convert to, float or double.
+ * \param number The number to convert.
+ * \param out The object receiving the value, if the conversion is decided.
+ * \return Whether the conversion is decided.
+ */
+template<class T>
+bool
+eisel_lemire_floating(const decimal_number& number, T& out) noexcept {
+    using format = binary_format<T>;
+    if (number.truncated) return false;
+    if (number.mantissa == 0) {
+        out = T(0);
+        return true;
+    }
+    if (number.exponent < pow10_128_min || number.exponent > pow10_128_max) return false;
+
+    const auto& pow10 = pow10_128[number.exponent - pow10_128_min];
+    auto clz = leading_zeros(number.mantissa);
+    auto man = number.mantissa << clz;
+    // floor(log2(10) * 2^16) == 217706
+    auto exp2 = static_cast<std::uint64_t>((217706 * number.exponent >> 16) + 64 + static_cast<long>(format::bias))
+                - static_cast<std::uint64_t>(clz);
+
+    std::uint64_t lo;
+    auto hi = mul_64x64(man, pow10[0], lo);
+    if ((hi & format::low_mask) == format::low_mask && lo + man < man) {
+        std::uint64_t lo2;
+        auto hi2 = mul_64x64(man, pow10[1], lo2);
+        auto merged_lo = lo + hi2;
+        auto merged_hi = hi + (merged_lo < lo ? 1 : 0);
+        if ((merged_hi & format::low_mask) == format::low_mask && merged_lo + 1 == 0 && lo2 + man < man) {
+            return false;
+        }
+        hi = merged_hi;
+        lo = merged_lo;
+    }
+
+    auto msb = hi >> 63;
+    auto mantissa = hi >> (msb + 64 - format::mantissa_bits - 3);
+    exp2 -= 1 ^ msb;
+    if (lo == 0 && (hi & format::low_mask) == 0 && (mantissa & 3) == 1) return false; // halfway
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >> (format::mantissa_bits + 1) > 0) {
+        mantissa >>= 1;
+        ++exp2;
+    }
+    if (exp2 - 1 >= format::max_exponent - 1) return false; // subnormal or infinite
+
+    auto bits = static_cast<typename format::bits_type>(
+           exp2 << format::mantissa_bits | (mantissa & ((std::uint64_t(1) << format::mantissa_bits) - 1)));
+    std::memcpy(&out, &bits, sizeof out);
+    return true;
+}
+
+/**
+ * \brief Converts a decimal number with the Eisel-Lemire algorithm
+ *
+ * Overload for the IEEE float and double types.
+ *
+ * \tparam T The floating point type to convert to.
+ * \param number The number to convert.
+ * \param out The object receiving the value, if the conversion is decided.
+ * \return Whether the conversion is decided.
+ */
+template<class T>
+bool
+binary_floating(const decimal_number& number, T& out, std::true_type) noexcept {
+    return eisel_lemire_floating(number, out);
+}
+
+/**
+ * \brief Skips the Eisel-Lemire algorithm
+ *
+ * Overload for the types the algorithm is not implemented for, like long double.
+ *
+ * \tparam T The floating point type to convert to.
+ * \return false
+ */
+template<class T>
+bool
+binary_floating(const decimal_number&, T&, std::false_type) noexcept {
+    return false;
+}
+
+/**
+ * \brief Converts a decimal number without the library, if possible
+ *
+ * Tries Clinger's fast path, then for float and double, the Eisel-Lemire algorithm.
+ *
+ * \tparam T The floating point type to convert to.
+ * \param number The number to convert.
+ * \param out The object receiving the value, if the conversion succeeds.
+ * \return Whether the conversion succeeded.
+ */
+template<class T>
+bool
+fast_floating(const decimal_number& number, T& out) noexcept {
+    using is_binary = std::integral_constant<bool, (std::is_same<T, float>::value || std::is_same<T, double>::value)
+                                                          && std::numeric_limits<T>::is_iec559>;
+    return clinger_floating(number, out) || binary_floating(number, out, is_binary{});
+}
+
+/**
+ * \brief Parses a floating point number
+ *
+ * Parses a decimal or hexadecimal (`0x` prefixed) floating point number, infinity or NaN from the
+ * beginning of the data, accepting the same forms as `std::strtod`.
+ * Numbers too large for T become infinite, too small ones become subnormal or zero.
+ * Decimal numbers are converted by fast_floating where it can decide the result, the rest by the
+ * library's correctly rounding `std::from_chars`, so the result is always the correctly rounded
+ * value, the same `std::strtod` returns.
+ *
+ * \tparam T The floating point type to parse.
+ * \param data The text to parse.
+ * \param out The object receiving the parsed value, if parsing succeeds.
+ * \return Whether there was a number to parse.
+ */
+template<class T>
+bool
+parse_floating(std::string_view data, T& out) noexcept {
+    static_assert(std::is_floating_point<T>::value, "parse_floating parses floating point types");
+    const char* first = skip_number_space(data.data(), data.data() + data.size());
+    const char* last = data.data() + data.size();
+
+    bool negative = false;
+    if (first != last && (*first == '-' || *first == '+')) {
+        negative = *first == '-';
+        ++first;
+    }
+    if (first != last && (*first == '-' || *first == '+')) return false;
+
+    T value;
+    bool hex = last - first > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X');
+    decimal_number number;
+    if (!hex && split_decimal(first, last, number) && fast_floating(number, value)) {
+        out = negative ? -value : value;
+        return true;
+    }
+
+#if defined(__cpp_lib_to_chars)
+    std::from_chars_result res;
+    if (hex) {
+        res = std::from_chars(first + 2, last, value, std::chars_format::hex);
+        if (res.ec == std::errc::invalid_argument) { // just the 0 before the x
+            value = T(0);
+            res.ec = std::errc();
+        }
+    } else {
+        res = std::from_chars(first, last, value);
+    }
+    if (res.ec == std::errc::invalid_argument) return false;
+    if (res.ec == std::errc::result_out_of_range) {
+        // from_chars leaves value alone; strto* gives infinity, zero or the subnormal value
+        strto_floating(first, res.ptr, value);
+    }
+    out = negative ? -value : value;
+    return true;
+#else
+    // no floating point from_chars
+    const char* end = strto_floating(first, last, value);
+    if (end == first || skip_number_space(first, last) != first) return false;
+    out = negative ? -value : value;
+    return true;
+#endif
+}
+
+#endif
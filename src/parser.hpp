@@ -33,7 +33,8 @@
  * \file parser.hpp
  * \brief Defines the parser concept
  *
- * Defines the formalized concept of a parser that config_set may use.
+ * Defines the formalized concept of a parser that config_set may use, and its refinements that let
+ * config_set load configurations without allocations, or lazily.
  */
 
 #ifndef CONFY_PARSER_HPP
@@ -59,6 +60,17 @@
 #include <istream>
 #include <string>
 #include <type_traits>
+#include <utility>
+
+/**
+ * \brief Tag selecting the config_set constructor deferring the parsing of values
+ */
+struct lazy_values_t {
+    explicit lazy_values_t() = default;
+};
+
+/// The tag selecting the config_set constructor deferring the parsing of values
+constexpr lazy_values_t lazy_values{};
 
 #ifndef USE_CXX17
 
@@ -76,6 +88,97 @@ concept parser = requires(T t) {
                      { t.parse_line(std::declval<std::string_view>()) } -> std::same_as<std::pair<std::string, std::string>>;
                  };
 
+/**
+ * \brief The view parser concept
+ *
+ * This concept is used to check whether a given parser type can also parse a buffer owned by the
+ * caller, returning views into the buffer instead of newly allocated strings.
+ * config_set prefers such parsers, as they allow loading a configuration without any per-line
+ * allocations.
+ *
+ * \tparam T The type to check.
+ */
+template<class T>
+concept view_parser = parser<T>
+                      && requires(const T t, std::string_view& buf) {
+                             { t.next_line_view(buf) } -> std::same_as<std::optional<std::string_view>>;
+                             { t.parse_line_view(std::string_view(buf)) } -> std::same_as<std::pair<std::string_view, std::string_view>>;
+                         };
+
+/**
+ * \brief Checks whether a type is a view parser
+ *
+ * Type trait counterpart of the view_parser concept, to allow tag-dispatching on it.
+ *
+ * \tparam T The type to check.
+ */
+template<class T>
+struct is_view_parser : std::bool_constant<view_parser<T>> { };
+
+/**
+ * \brief The lazy parser concept
+ *
+ * This concept is used to check whether a given view parser can also parse the key of a line alone.
+ * config_set may load a configuration through such parsers lazily, only indexing the keys, and
+ * parsing each value when it is first accessed.
+ *
+ * \tparam T The type to check.
+ */
+template<class T>
+concept lazy_parser = view_parser<T>
+                      && requires(const T t, std::string_view ln) {
+                             { t.parse_key_view(ln) } -> std::same_as<std::string_view>;
+                         };
+
+/**
+ * \brief Checks whether a type is a lazy parser
+ *
+ * Type trait counterpart of the lazy_parser concept, to allow tag-dispatching on it.
+ *
+ * \tparam T The type to check.
+ */
+template<class T>
+struct is_lazy_parser : std::bool_constant<lazy_parser<T>> { };
+
+#else
+
+/**
+ * \brief Checks whether a type is a view parser
+ *
+ * Substitutes the view_parser concept, where concepts are not available.
+ * Checks that the type provides the next_line_view and parse_line_view member functions with the
+ * right return types.
+ *
+ * \tparam T The type to check.
+ */
+template<class T, class = void>
+struct is_view_parser : std::false_type { };
+
+template<class T>
+struct is_view_parser<T, std::enable_if_t<std::is_same<decltype(std::declval<const T&>().next_line_view(std::declval<std::string_view&>())),
+                                                        std::optional<std::string_view>>::value
+                                           && std::is_same<decltype(std::declval<const T&>().parse_line_view(std::declval<std::string_view>())),
+                                                           std::pair<std::string_view, std::string_view>>::value>>
+     : std::true_type { };
+
+/**
+ * \brief Checks whether a type is a lazy parser
+ *
+ * Substitutes the lazy_parser concept, where concepts are not available.
+ * Checks that the type is a view parser, and provides the parse_key_view member function with the
+ * right return type.
+ *
+ * \tparam T The type to check.
+ */
+template<class T, class = void>
+struct is_lazy_parser : std::false_type { };
+
+template<class T>
+struct is_lazy_parser<T, std::enable_if_t<is_view_parser<T>::value
+                                           && std::is_same<decltype(std::declval<const T&>().parse_key_view(std::declval<std::string_view>())),
+                                                           std::string_view>::value>>
+     : std::true_type { };
+
 #endif
 
 #endif
@@ -0,0 +1,177 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file perfect_hash_index.cpp
+ * \brief Implements the perfect_hash_index type
+ *
+ * Contains the construction and lookup of the minimal perfect hash function.
+ */
+
+#include "perfect_hash_index.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "key_hash.hpp"
+#include "prefetch.hpp"
+
+#include "memtrace.h"
+
+namespace {
+    constexpr std::size_t max_levels = 32;
+    constexpr std::size_t gamma = 2;
+
+    /// The position of a hash on a level of the given size, which may be at most 2^32 bits
+    std::size_t
+    position(std::uint64_t h, std::size_t lvl, std::size_t size) noexcept {
+        auto x = rehash_key(h, lvl) >> 32;
+        return static_cast<std::size_t>((x * static_cast<std::uint64_t>(size)) >> 32);
+    }
+
+    bool
+    test_bit(const std::vector<std::uint64_t>& bits, std::size_t idx) noexcept {
+        return (bits[idx / 64] >> (idx % 64)) & 1;
+    }
+
+    void
+    set_bit(std::vector<std::uint64_t>& bits, std::size_t idx) noexcept {
+        bits[idx / 64] |= std::uint64_t{1} << (idx % 64);
+    }
+
+    unsigned
+    popcount(std::uint64_t word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_popcountll(word));
+#else
+        unsigned cnt = 0;
+        for (; word; word &= word - 1) ++cnt;
+        return cnt;
+#endif
+    }
+}
+
+std::size_t
+perfect_hash_index::memory_usage() const noexcept {
+    return _levels.size() * sizeof(level)
+           + _bits.size() * sizeof(std::uint64_t)
+           + _ranks.size() * sizeof(std::uint32_t)
+           + _fallback.size() * sizeof(std::uint64_t);
+}
+
+std::vector<std::size_t>
+perfect_hash_index::build_hashes(const std::vector<std::uint64_t>& hashes) {
+    if (hashes.size() > (std::size_t{1} << 31))
+        throw std::length_error("too many keys for perfect_hash_index");
+
+    *this = perfect_hash_index();
+    std::vector<std::size_t> level_of(hashes.size(), max_levels);
+    std::vector<std::size_t> remaining(hashes.size());
+    for (std::size_t i = 0; i < remaining.size(); ++i) remaining[i] = i;
+
+    for (std::size_t lvl = 0; lvl < max_levels && !remaining.empty(); ++lvl) {
+        auto size = (gamma * remaining.size() + 63) / 64 * 64;
+        std::vector<std::uint64_t> seen(size / 64), collided(size / 64);
+        for (auto i : remaining) {
+            auto pos = position(hashes[i], lvl, size);
+            if (test_bit(seen, pos)) {
+                set_bit(collided, pos);
+            } else {
+                set_bit(seen, pos);
+            }
+        }
+
+        _levels.push_back({_bits.size(), size});
+        std::size_t kept = 0;
+        for (auto i : remaining) {
+            auto pos = position(hashes[i], lvl, size);
+            if (test_bit(collided, pos)) {
+                remaining[kept++] = i;
+            } else {
+                level_of[i] = lvl;
+            }
+        }
+        remaining.resize(kept);
+        for (std::size_t w = 0; w < seen.size(); ++w) _bits.push_back(seen[w] & ~collided[w]);
+    }
+
+    _ranks.reserve(_bits.size());
+    std::uint32_t rank = 0;
+    for (auto word : _bits) {
+        _ranks.push_back(rank);
+        rank += popcount(word);
+    }
+    _placed = rank;
+
+    std::sort(remaining.begin(), remaining.end(), [&hashes](std::size_t lhs, std::size_t rhs) {
+        return hashes[lhs] < hashes[rhs] || (hashes[lhs] == hashes[rhs] && lhs < rhs);
+    });
+
+    std::vector<std::size_t> order(hashes.size());
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        if (level_of[i] == max_levels) continue;
+        const auto& lvl = _levels[level_of[i]];
+        auto bit = lvl.offset * 64 + position(hashes[i], level_of[i], lvl.size);
+        auto word = bit / 64;
+        auto below = _bits[word] & ((std::uint64_t{1} << (bit % 64)) - 1);
+        order[_ranks[word] + popcount(below)] = i;
+    }
+    _fallback.reserve(remaining.size());
+    for (auto i : remaining) {
+        order[_placed + _fallback.size()] = i;
+        _fallback.push_back(hashes[i]);
+    }
+    return order;
+}
+
+std::pair<std::size_t, std::size_t>
+perfect_hash_index::lookup(std::uint64_t h) const noexcept {
+    for (std::size_t lvl = 0; lvl < _levels.size(); ++lvl) {
+        auto bit = _levels[lvl].offset * 64 + position(h, lvl, _levels[lvl].size);
+        auto word = bit / 64;
+        if ((_bits[word] >> (bit % 64)) & 1) {
+            auto below = _bits[word] & ((std::uint64_t{1} << (bit % 64)) - 1);
+            auto pos = _ranks[word] + popcount(below);
+            return {pos, pos + 1};
+        }
+    }
+    auto range = std::equal_range(_fallback.begin(), _fallback.end(), h);
+    return {_placed + static_cast<std::size_t>(range.first - _fallback.begin()),
+            _placed + static_cast<std::size_t>(range.second - _fallback.begin())};
+}
+
+void
+perfect_hash_index::prefetch_hash(std::uint64_t h) const noexcept {
+    if (_levels.empty()) return;
+    auto word = _levels.front().offset + position(h, 0, _levels.front().size) / 64;
+    prefetch(&_bits[word]);
+    prefetch(&_ranks[word]);
+}
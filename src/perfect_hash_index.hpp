@@ -0,0 +1,219 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file perfect_hash_index.hpp
+ * \brief Defines the perfect_hash_index type
+ *
+ * This file defines the perfect_hash_index class, a key index of config_set, which looks up keys
+ * through a minimal perfect hash function built when loading the configuration.
+ */
+
+#ifndef CONFY_PERFECT_HASH_INDEX_HPP
+#define CONFY_PERFECT_HASH_INDEX_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <string_view>
+#endif
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "key_hash.hpp"
+#include "prefetch.hpp"
+
+/**
+ * \brief Key index using a minimal perfect hash function
+ *
+ * Builds a BBHash-style minimal perfect hash function over the keys, which maps each of the n keys
+ * to a distinct position in [0, n), and stores the entries in that order.
+ * A lookup costs one hash of the looked up key, a bit test on, on average, less than two levels, and
+ * a single key comparison, which verifies that the key found is the one looked up.
+ *
+ * The function takes around 5 bits per key: each level is a bit array twice the size of the keys
+ * still unplaced, and each 64-bit word of it has a 32-bit rank counter.
+ * Keys still colliding after the last level are stored in a small sorted array of hashes.
+ *
+ * Batches of keys are looked up in passes over the whole batch, so the cache misses of the bit
+ * array and of the key comparisons of the different keys overlap.
+ */
+struct perfect_hash_index {
+    /// The position returned for keys not in the index
+    constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+    /// The number of keys find_many looks up in one pass
+    constexpr static std::size_t batch_lanes = 32;
+
+    /**
+     * \brief Builds the index
+     *
+     * Hashes all keys, and builds the perfect hash function over the hashes.
+     * If there are more than 2^31 keys, an `std::length_error` exception is thrown.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param n The number of entries
+     * \param key_at The function returning the key of the sorted entry at a given position
+     * \return The order to store the entries in
+     */
+    template<class KeyAt>
+    std::vector<std::size_t>
+    build(std::size_t n, KeyAt&& key_at) {
+        std::vector<std::uint64_t> hashes(n);
+        for (std::size_t i = 0; i < n; ++i) hashes[i] = hash_key(key_at(i));
+        return build_hashes(hashes);
+    }
+
+    /**
+     * \brief Finds a key
+     *
+     * Finds the only position the key may be stored at, and checks whether it is actually there.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param key The key to look for
+     * \param key_at The function returning the key of the stored entry at a given position
+     * \return The position of the entry with the given key, or npos, if there is none.
+     */
+    template<class KeyAt>
+    std::size_t
+    find(std::string_view key, KeyAt&& key_at) const {
+        auto candidates = lookup(hash_key(key));
+        for (auto pos = candidates.first; pos != candidates.second; ++pos) {
+            if (key_at(pos) == key) return pos;
+        }
+        return npos;
+    }
+
+    /**
+     * \brief Finds a batch of keys
+     *
+     * Looks up batch_lanes keys at a time in three passes: the first pass hashes the keys and
+     * prefetches their words of the first level, the second finds their candidate positions and
+     * prefetches the keys stored there, and the last compares the keys.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param keys The keys to look for
+     * \param count The number of keys
+     * \param out The array receiving the position of each key, or npos, if it is not in the index
+     * \param key_at The function returning the key of the stored entry at a given position
+     */
+    template<class KeyAt>
+    void
+    find_many(const std::string_view* keys, std::size_t count, std::size_t* out, KeyAt&& key_at) const {
+        for (std::size_t first = 0; first < count; first += batch_lanes) {
+            auto width = std::min(batch_lanes, count - first);
+            std::uint64_t hashes[batch_lanes];
+            std::pair<std::size_t, std::size_t> candidates[batch_lanes];
+            for (std::size_t l = 0; l < width; ++l) {
+                hashes[l] = hash_key(keys[first + l]);
+                prefetch_hash(hashes[l]);
+            }
+            for (std::size_t l = 0; l < width; ++l) {
+                candidates[l] = lookup(hashes[l]);
+                if (candidates[l].first != candidates[l].second) prefetch(key_at(candidates[l].first).data());
+            }
+            for (std::size_t l = 0; l < width; ++l) {
+                out[first + l] = npos;
+                for (auto pos = candidates[l].first; pos != candidates[l].second; ++pos) {
+                    if (key_at(pos) == keys[first + l]) {
+                        out[first + l] = pos;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Getter for the size of the function
+     *
+     * \return The number of bytes used by the bit arrays, rank counters and the fallback array.
+     */
+    std::size_t
+    memory_usage() const noexcept;
+
+private:
+    /**
+     * \brief A level of the function
+     *
+     * A bit array in _bits, which has a bit set for every key that landed alone on its position in
+     * this level.
+     */
+    struct level {
+        std::size_t offset; ///< The first word of the level in _bits
+        std::size_t size;   ///< The number of bits in the level
+    };
+
+    /**
+     * \brief Builds the function from the hashes of the keys
+     *
+     * \param hashes The hashes of the sorted keys
+     * \return The order to store the entries in
+     */
+    std::vector<std::size_t>
+    build_hashes(const std::vector<std::uint64_t>& hashes);
+
+    /**
+     * \brief Finds the positions a hash may be stored at
+     *
+     * \param h The hash to look for
+     * \return The range of candidate positions. Empty if the hash is certainly not stored, and
+     *         longer than one only for fully colliding hashes.
+     */
+    std::pair<std::size_t, std::size_t>
+    lookup(std::uint64_t h) const noexcept;
+
+    /**
+     * \brief Prefetches the first level word and rank counter of a hash
+     *
+     * \param h The hash to be looked up soon
+     */
+    void
+    prefetch_hash(std::uint64_t h) const noexcept;
+
+    std::vector<level> _levels;           ///< The levels of the function
+    std::vector<std::uint64_t> _bits;     ///< The bit arrays of all levels
+    std::vector<std::uint32_t> _ranks;    ///< The number of set bits before each word of _bits
+    std::vector<std::uint64_t> _fallback; ///< The sorted hashes of the keys not placed on any level
+    std::size_t _placed = 0;              ///< The number of keys placed on the levels
+};
+
+#endif
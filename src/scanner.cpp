@@ -0,0 +1,204 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file scanner.cpp
+ * \brief Implements the vectorized byte scanning functions
+ *
+ * Contains a portable scalar, an SSE2, and an AVX2 implementation of each scanning function.
+ * The AVX2 versions are compiled for that instruction set only, and are selected at runtime when
+ * the processor supports them; SSE2 is part of the x86-64 baseline, so it is always usable there.
+ */
+
+#include "scanner.hpp"
+
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#  define CONFY_SCAN_X86
+#  include <immintrin.h>
+#endif
+
+#include "memtrace.h"
+
+namespace {
+    bool
+    is_alnum(char c) noexcept {
+        auto u = static_cast<unsigned char>(c);
+        return static_cast<unsigned char>(u - '0') < 10
+               || static_cast<unsigned char>((u | 0x20) - 'a') < 26;
+    }
+
+    const char*
+    scalar_newline(const char* first, const char* last) noexcept {
+        while (first != last && *first != '\n') ++first;
+        return first;
+    }
+
+    const char*
+    scalar_non_alnum(const char* first, const char* last) noexcept {
+        while (first != last && is_alnum(*first)) ++first;
+        return first;
+    }
+
+    std::size_t
+    scalar_count_newlines(const char* first, const char* last) noexcept {
+        std::size_t cnt = 0;
+        for (; first != last; ++first) cnt += *first == '\n';
+        return cnt;
+    }
+
+#ifdef CONFY_SCAN_X86
+    // A byte b is in [lo, lo + n) iff (b - lo) ^ 0x80, as a signed byte, is less than n - 128.
+    // SSE2 only has signed byte comparisons, hence the bias.
+
+    __m128i
+    sse2_in_range(__m128i v, char lo, int n) noexcept {
+        auto shifted = _mm_sub_epi8(v, _mm_set1_epi8(static_cast<char>(lo ^ 0x80)));
+        return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(n - 128)));
+    }
+
+    const char*
+    sse2_newline(const char* first, const char* last) noexcept {
+        auto nl = _mm_set1_epi8('\n');
+        for (; last - first >= 16; first += 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+            if (mask != 0) return first + __builtin_ctz(mask);
+        }
+        return scalar_newline(first, last);
+    }
+
+    const char*
+    sse2_non_alnum(const char* first, const char* last) noexcept {
+        auto lower = _mm_set1_epi8(0x20);
+        for (; last - first >= 16; first += 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            auto digit = sse2_in_range(v, '0', 10);
+            auto alpha = sse2_in_range(_mm_or_si128(v, lower), 'a', 26);
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(digit, alpha)));
+            if (mask != 0xFFFFu) return first + __builtin_ctz(~mask);
+        }
+        return scalar_non_alnum(first, last);
+    }
+
+    std::size_t
+    sse2_count_newlines(const char* first, const char* last) noexcept {
+        auto nl = _mm_set1_epi8('\n');
+        std::size_t cnt = 0;
+        for (; last - first >= 16; first += 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            cnt += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))));
+        }
+        return cnt + scalar_count_newlines(first, last);
+    }
+
+    __attribute__((target("avx2"))) __m256i
+    avx2_in_range(__m256i v, char lo, int n) noexcept {
+        auto shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(static_cast<char>(lo ^ 0x80)));
+        return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(n - 128)), shifted);
+    }
+
+    __attribute__((target("avx2"))) const char*
+    avx2_newline(const char* first, const char* last) noexcept {
+        auto nl = _mm256_set1_epi8('\n');
+        for (; last - first >= 32; first += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+            auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)));
+            if (mask != 0) return first + __builtin_ctz(mask);
+        }
+        return sse2_newline(first, last);
+    }
+
+    __attribute__((target("avx2"))) const char*
+    avx2_non_alnum(const char* first, const char* last) noexcept {
+        auto lower = _mm256_set1_epi8(0x20);
+        for (; last - first >= 32; first += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+            auto digit = avx2_in_range(v, '0', 10);
+            auto alpha = avx2_in_range(_mm256_or_si256(v, lower), 'a', 26);
+            auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)));
+            if (mask != 0xFFFFFFFFu) return first + __builtin_ctz(~mask);
+        }
+        return sse2_non_alnum(first, last);
+    }
+
+    __attribute__((target("avx2,popcnt"))) std::size_t
+    avx2_count_newlines(const char* first, const char* last) noexcept {
+        auto nl = _mm256_set1_epi8('\n');
+        std::size_t cnt = 0;
+        for (; last - first >= 32; first += 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+            cnt += static_cast<std::size_t>(__builtin_popcount(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)))));
+        }
+        return cnt + sse2_count_newlines(first, last);
+    }
+
+    bool
+    has_avx2() noexcept {
+        static const bool avx2 = [] {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+        }();
+        return avx2;
+    }
+#endif
+}
+
+const char*
+scan_newline(const char* first, const char* last) noexcept {
+#ifdef CONFY_SCAN_X86
+    if (has_avx2()) return avx2_newline(first, last);
+    return sse2_newline(first, last);
+#else
+    return scalar_newline(first, last);
+#endif
+}
+
+const char*
+scan_non_alnum(const char* first, const char* last) noexcept {
+#ifdef CONFY_SCAN_X86
+    if (has_avx2()) return avx2_non_alnum(first, last);
+    return sse2_non_alnum(first, last);
+#else
+    return scalar_non_alnum(first, last);
+#endif
+}
+
+std::size_t
+count_newlines(const char* first, const char* last) noexcept {
+#ifdef CONFY_SCAN_X86
+    if (has_avx2()) return avx2_count_newlines(first, last);
+    return sse2_count_newlines(first, last);
+#else
+    return scalar_count_newlines(first, last);
+#endif
+}
@@ -0,0 +1,87 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file scanner.hpp
+ * \brief Declares the vectorized byte scanning functions
+ *
+ * This file declares the functions the parser uses to find delimiters in a buffer many bytes at a
+ * time.
+ */
+
+#ifndef CONFY_SCANNER_HPP
+#define CONFY_SCANNER_HPP
+
+#include <cstddef>
+
+/**
+ * \brief Finds the next line feed
+ *
+ * Searches the range [first, last) for the first `\n` byte.
+ * On x86 processors the search is performed 16 bytes at a time using SSE2, or 32 bytes at a time
+ * using AVX2, if the processor supports it.
+ *
+ * \param first The beginning of the range to search
+ * \param last The end of the range to search
+ * \return Pointer to the first line feed, or last if there is none.
+ */
+const char*
+scan_newline(const char* first, const char* last) noexcept;
+
+/**
+ * \brief Finds the next non-alphanumeric byte
+ *
+ * Searches the range [first, last) for the first byte that is not an ASCII letter or digit.
+ * This is the same set of bytes `std::isalnum` accepts in the "C" locale.
+ * On x86 processors the search is performed 16 bytes at a time using SSE2, or 32 bytes at a time
+ * using AVX2, if the processor supports it.
+ *
+ * \param first The beginning of the range to search
+ * \param last The end of the range to search
+ * \return Pointer to the first non-alphanumeric byte, or last if there is none.
+ */
+const char*
+scan_non_alnum(const char* first, const char* last) noexcept;
+
+/**
+ * \brief Counts the line feeds in a range
+ *
+ * Counts the `\n` bytes in the range [first, last).
+ * Vectorized the same way as scan_newline.
+ *
+ * \param first The beginning of the range to search
+ * \param last The end of the range to search
+ * \return The number of line feeds in the range.
+ */
+std::size_t
+count_newlines(const char* first, const char* last) noexcept;
+
+#endif
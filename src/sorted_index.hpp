@@ -0,0 +1,230 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file sorted_index.hpp
+ * \brief Defines the sorted_index type
+ *
+ * This file defines the sorted_index class, the default key index of config_set, which looks up
+ * keys by binary searching the sorted entries.
+ */
+
+#ifndef CONFY_SORTED_INDEX_HPP
+#define CONFY_SORTED_INDEX_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <numeric>
+#  include <string_view>
+#endif
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "prefetch.hpp"
+
+/**
+ * \brief Key index binary searching the sorted entries
+ *
+ * Keeps the entries sorted, and looks up keys with a binary search over them.
+ * Needs no memory on its own, and building it is free, but every lookup costs O(log n) key
+ * comparisons.
+ *
+ * Batches of keys are searched in lockstep: every key of the batch descends one level before any
+ * descends the next, so the cache misses of the different searches overlap.
+ */
+struct sorted_index {
+    /// The position returned for keys not in the index
+    constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+    /// The number of keys find_many searches in lockstep
+    constexpr static std::size_t batch_lanes = 32;
+
+    /**
+     * \brief Builds the index
+     *
+     * Remembers the number of entries, and keeps them in sorted order.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param n The number of entries
+     * \return An empty order, to keep the entries sorted
+     */
+    template<class KeyAt>
+    std::vector<std::size_t>
+    build(std::size_t n, KeyAt&&) {
+        _size = n;
+        return {};
+    }
+
+    /**
+     * \brief Finds a key
+     *
+     * Binary searches the entries for the given key.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param key The key to look for
+     * \param key_at The function returning the key of the entry at a given position
+     * \return The position of the entry with the given key, or npos, if there is none.
+     */
+    template<class KeyAt>
+    std::size_t
+    find(std::string_view key, KeyAt&& key_at) const {
+        return callback_binary_search(
+               _size,
+               [&key, &key_at](std::size_t idx) {
+                   return key_at(idx).compare(key);
+               },
+               [](std::size_t, std::size_t middle, std::size_t) {
+                   return middle;
+               },
+               [](auto&&...) {
+                   return npos;
+               });
+    }
+
+    /**
+     * \brief Finds a batch of keys
+     *
+     * Runs branchless lower bound searches for up to batch_lanes keys at a time, all halving the
+     * same range in lockstep.
+     * In each step the keys probed by all searches are loaded and prefetched first, then compared,
+     * so the searches wait for their misses together, instead of one after the other.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param keys The keys to look for
+     * \param count The number of keys
+     * \param out The array receiving the position of each key, or npos, if it is not in the index
+     * \param key_at The function returning the key of the entry at a given position
+     */
+    template<class KeyAt>
+    void
+    find_many(const std::string_view* keys, std::size_t count, std::size_t* out, KeyAt&& key_at) const {
+        for (std::size_t first = 0; first < count; first += batch_lanes) {
+            auto width = std::min(batch_lanes, count - first);
+            if (_size == 0) {
+                std::fill(out + first, out + first + width, npos);
+                continue;
+            }
+
+            std::size_t base[batch_lanes] = {};
+            std::string_view probed[batch_lanes];
+            for (auto len = _size; len > 1; len -= len / 2) {
+                auto half = len / 2;
+                for (std::size_t l = 0; l < width; ++l) {
+                    probed[l] = key_at(base[l] + half);
+                    prefetch(probed[l].data());
+                }
+                for (std::size_t l = 0; l < width; ++l) {
+                    base[l] += probed[l] < keys[first + l] ? half : 0;
+                }
+            }
+
+            for (std::size_t l = 0; l < width; ++l) {
+                const auto& key = keys[first + l];
+                auto dir = key_at(base[l]).compare(key);
+                if (dir == 0) {
+                    out[first + l] = base[l];
+                } else if (dir < 0 && base[l] + 1 < _size && key_at(base[l] + 1) == key) {
+                    out[first + l] = base[l] + 1;
+                } else {
+                    out[first + l] = npos;
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Getter for the size of the index
+     *
+     * \return The number of bytes used by the index besides the entries, which is none.
+     */
+    std::size_t
+    memory_usage() const noexcept { return 0; }
+
+private:
+    /**
+     * \brief Universal callback-based binary search
+     *
+     * A callback oriented binary search. Searches the positions [0, size) and calls succ if it
+     * successfully finds an equal value, according to the given unary predicate cmpr.
+     * If it doesn't find anything searched, it calls fail.
+     * In all cases returns the return values of the callbacks, so they must have an equal return
+     * type.
+     *
+     * \tparam CmprFn The type of the comparison unary predicate.
+     * \tparam SuccFn The type of the success function.
+     * \tparam FailFn The type of the failure function.
+     * \param size The number of positions to search in.
+     * \param cmpr The unary predicate, that provides three way comparison of the value at a position.
+     * \param succ The function called if the search succeeds.
+     * \param fail The function called if the search fails.
+     * \return The return value of the called completion function.
+     */
+    template<class CmprFn, class SuccFn, class FailFn>
+    static auto
+    callback_binary_search(std::size_t size,
+                           CmprFn&& cmpr,
+                           SuccFn&& succ,
+                           FailFn&& fail) {
+        std::size_t begin = 0;
+        std::size_t middle = 0;
+        std::size_t end = size;
+        while (begin != end) {
+#ifndef USE_CXX17
+            middle = std::midpoint(begin, end);
+#else
+            middle = (end + begin) / 2;
+#endif
+            auto dir = std::forward<CmprFn>(cmpr)(middle);
+            if (dir == 0) {
+                return std::forward<SuccFn>(succ)(begin, middle, end);
+            } else if (dir < 0) {
+                begin = middle + 1;
+            } else if (dir > 0) {
+                end = middle;
+            }
+        }
+        return std::forward<FailFn>(fail)(begin, middle, end);
+    }
+
+    std::size_t _size = 0; ///< The number of entries
+};
+
+#endif
@@ -0,0 +1,193 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file source_buffer.cpp
+ * \brief Implements the source_buffer class
+ *
+ * Contains the platform dependent loading code of source_buffer.
+ * On POSIX systems files are mapped using mmap(2), everywhere else they are read using the standard
+ * library.
+ */
+
+#include "source_buffer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  define CONFY_HAS_MMAP
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include "memtrace.h"
+
+namespace {
+    [[noreturn]] void
+    invalid_file(const std::filesystem::path& file) {
+        throw std::invalid_argument("invalid_file " + file.string());
+    }
+
+    std::unique_ptr<char[]>
+    read_stream(std::istream& strm, std::size_t& size) {
+        std::string contents(std::istreambuf_iterator<char>(strm), {});
+        size = contents.size();
+        auto buf = std::make_unique<char[]>(size + 1);
+        contents.copy(buf.get(), size);
+        buf[size] = '\0';
+        return buf;
+    }
+
+    std::unique_ptr<char[]>
+    read_file(const std::filesystem::path& file, std::size_t& size) {
+        std::ifstream ifs(file, std::ios::binary);
+        if (!ifs.is_open()) invalid_file(file);
+        return read_stream(ifs, size);
+    }
+}
+
+source_buffer::source_buffer()
+     : _data(nullptr),
+       _size(0),
+       _mapped(false),
+       _buf(std::make_unique<char[]>(1)) {
+    _data = _buf.get();
+}
+
+source_buffer::source_buffer(const std::filesystem::path& file)
+     : _data(nullptr),
+       _size(0),
+       _mapped(false),
+       _buf() {
+#ifdef CONFY_HAS_MMAP
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) invalid_file(file);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || S_ISDIR(st.st_mode)) {
+        ::close(fd);
+        invalid_file(file);
+    }
+
+    auto size = static_cast<std::size_t>(st.st_size);
+    auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    // the zero-filled tail of the last page provides the past-the-end byte; if there is no such tail
+    // (or nothing to map) the file is read instead
+    if (S_ISREG(st.st_mode) && size != 0 && size % page != 0) {
+        void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            ::close(fd);
+#  ifdef MADV_SEQUENTIAL
+            ::madvise(map, size, MADV_SEQUENTIAL);
+#  endif
+            _data = static_cast<char*>(map);
+            _size = size;
+            _mapped = true;
+            return;
+        }
+    }
+    ::close(fd);
+#endif
+    _buf = read_file(file, _size);
+    _data = _buf.get();
+}
+
+source_buffer::source_buffer(std::istream& strm)
+     : _data(nullptr),
+       _size(0),
+       _mapped(false),
+       _buf(read_stream(strm, _size)) {
+    _data = _buf.get();
+}
+
+source_buffer
+source_buffer::copy_of(std::string_view contents) {
+    source_buffer copy;
+    copy._buf = std::make_unique<char[]>(contents.size() + 1);
+    std::copy(contents.begin(), contents.end(), copy._buf.get());
+    copy._buf[contents.size()] = '\0';
+    copy._data = copy._buf.get();
+    copy._size = contents.size();
+    return copy;
+}
+
+source_buffer
+source_buffer::read(const std::filesystem::path& file) {
+    source_buffer contents;
+    contents._buf = read_file(file, contents._size);
+    contents._data = contents._buf.get();
+    return contents;
+}
+
+source_buffer::source_buffer(source_buffer&& other) noexcept
+     : _data(other._data),
+       _size(other._size),
+       _mapped(other._mapped),
+       _buf(std::move(other._buf)) {
+    other._data = nullptr;
+    other._size = 0;
+    other._mapped = false;
+}
+
+source_buffer&
+source_buffer::operator=(source_buffer&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+    _data = other._data;
+    _size = other._size;
+    _mapped = other._mapped;
+    _buf = std::move(other._buf);
+    other._data = nullptr;
+    other._size = 0;
+    other._mapped = false;
+    return *this;
+}
+
+source_buffer::~source_buffer() noexcept {
+    release();
+}
+
+void
+source_buffer::release() noexcept {
+#ifdef CONFY_HAS_MMAP
+    if (_mapped) ::munmap(_data, _size);
+#endif
+    _buf.reset();
+    _data = nullptr;
+    _size = 0;
+    _mapped = false;
+}
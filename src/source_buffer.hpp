@@ -0,0 +1,215 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file source_buffer.hpp
+ * \brief Defines the source_buffer type
+ *
+ * This file defines the source_buffer class, which holds the raw bytes of a configuration file for
+ * the whole lifetime of a config_set.
+ */
+
+#ifndef CONFY_SOURCE_BUFFER_HPP
+#define CONFY_SOURCE_BUFFER_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/filesystem>
+#  include <experimental/string_view>
+#  define filesystem experimental::filesystem
+#  define string_view experimental::string_view
+#else
+#  include <filesystem>
+#  include <string_view>
+#endif
+#include <cstddef>
+#include <istream>
+#include <memory>
+
+/**
+ * \brief Owner of a configuration file's bytes
+ *
+ * Provides the contents of a file as one contiguous, writable block of memory.
+ * Where the platform allows it, the file is memory-mapped privately, so loading it only costs page
+ * faults, and writes never reach the file on disk.
+ * Otherwise, the file is read into a single heap buffer.
+ *
+ * In both cases the byte just past the end of the contents, `data()[size()]`, is valid, writable,
+ * and initially zero.
+ * This allows the users of the buffer to NUL-terminate any substring of the contents in place.
+ */
+struct source_buffer {
+    /**
+     * \brief Constructs an empty buffer
+     *
+     * The constructed buffer has no contents, but the past-the-end byte is still available.
+     */
+    source_buffer();
+
+    /**
+     * \brief Loads a file into the buffer
+     *
+     * Maps or reads the given file.
+     * If the file cannot be opened, an `std::invalid_argument` exception is thrown.
+     *
+     * \param file The file to load
+     */
+    explicit source_buffer(const std::filesystem::path& file);
+
+    /**
+     * \brief Reads a stream into the buffer
+     *
+     * Reads everything left in the stream into a heap buffer.
+     *
+     * \param strm The stream to read
+     */
+    explicit source_buffer(std::istream& strm);
+
+    /**
+     * \brief Creates a buffer holding a copy of a string
+     *
+     * Copies the given bytes into a heap buffer.
+     *
+     * \param contents The bytes to copy
+     * \return The buffer holding the copy
+     */
+    static source_buffer
+    copy_of(std::string_view contents);
+
+    /**
+     * \brief Reads a file into a heap buffer
+     *
+     * Like the file constructor, but never maps the file, so the contents are not affected by later
+     * writes to the file, or by its truncation.
+     * If the file cannot be opened, an `std::invalid_argument` exception is thrown.
+     *
+     * \param file The file to read
+     * \return The buffer holding the contents of the file
+     */
+    static source_buffer
+    read(const std::filesystem::path& file);
+
+    /**
+     * \brief Move constructor
+     *
+     * Takes over the contents of the other buffer.
+     * Pointers into the contents stay valid.
+     * The other buffer may only be destroyed or assigned to afterwards.
+     *
+     * \param other The buffer to move from
+     */
+    source_buffer(source_buffer&& other) noexcept;
+
+    /**
+     * \brief Move assignment
+     *
+     * Releases our contents and takes over the other buffer's.
+     * Pointers into the other buffer's contents stay valid.
+     *
+     * \param other The buffer to move from
+     * \return The buffer assigned to
+     */
+    source_buffer&
+    operator=(source_buffer&& other) noexcept;
+
+    source_buffer(const source_buffer&) = delete;
+    source_buffer&
+    operator=(const source_buffer&) = delete;
+
+    /**
+     * \brief Releases the buffer
+     *
+     * Unmaps, or frees, the stored contents.
+     */
+    ~source_buffer() noexcept;
+
+    /**
+     * \brief Getter for the contents
+     *
+     * \return Pointer to the first byte of the contents.
+     */
+    char*
+    data() noexcept { return _data; }
+
+    /**
+     * \brief Getter for the contents
+     *
+     * \return Pointer to the first byte of the contents.
+     */
+    const char*
+    data() const noexcept { return _data; }
+
+    /**
+     * \brief Getter for the size of the contents
+     *
+     * \return The number of bytes in the buffer, not counting the past-the-end byte.
+     */
+    std::size_t
+    size() const noexcept { return _size; }
+
+    /**
+     * \brief Returns the contents as a string_view
+     *
+     * \return A view over the whole buffer.
+     */
+    std::string_view
+    view() const noexcept { return {_data, _size}; }
+
+    /**
+     * \brief Checks whether the contents are memory-mapped
+     *
+     * \return True, if the buffer is a file mapping, false if it is a heap buffer.
+     */
+    bool
+    mapped() const noexcept { return _mapped; }
+
+private:
+    /**
+     * \brief Releases the currently held contents
+     *
+     * Unmaps the contents if they are mapped, and frees the heap buffer if not.
+     * Leaves the object empty.
+     */
+    void
+    release() noexcept;
+
+    char* _data;                  ///< The first byte of the contents
+    std::size_t _size;            ///< The size of the contents
+    bool _mapped;                 ///< Whether _data points into a file mapping
+    std::unique_ptr<char[]> _buf; ///< The heap buffer used when not mapping
+};
+
+#endif
@@ -0,0 +1,92 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file swiss_index.cpp
+ * \brief Implements the swiss_index type
+ *
+ * Contains the table management and the group matching of swiss_index.
+ * On x86 the control bytes of a group are matched with SSE2, everywhere else one by one.
+ */
+
+#include "swiss_index.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define CONFY_SWISS_SSE2
+#  include <emmintrin.h>
+#endif
+
+#include "memtrace.h"
+
+namespace {
+    constexpr std::int8_t empty = -128;
+}
+
+swiss_index::group_masks
+swiss_index::match_group(const std::int8_t* ctrl, std::int8_t fragment) noexcept {
+#ifdef CONFY_SWISS_SSE2
+    auto grp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    auto matches = _mm_movemask_epi8(_mm_cmpeq_epi8(grp, _mm_set1_epi8(static_cast<char>(fragment))));
+    return {static_cast<std::uint32_t>(matches), static_cast<std::uint32_t>(_mm_movemask_epi8(grp))};
+#else
+    group_masks masks{0, 0};
+    for (std::size_t i = 0; i < group_size; ++i) {
+        masks.matches |= static_cast<std::uint32_t>(ctrl[i] == fragment) << i;
+        masks.empties |= static_cast<std::uint32_t>(ctrl[i] < 0) << i;
+    }
+    return masks;
+#endif
+}
+
+void
+swiss_index::reset(std::size_t n) {
+    std::size_t groups = 1;
+    while (groups * group_size * 7 < n * 8) groups *= 2;
+    _ctrl.assign(groups * group_size, empty);
+    _slots.assign(groups * group_size, 0);
+}
+
+void
+swiss_index::place(std::uint64_t h, std::size_t pos) noexcept {
+    auto mask = _ctrl.size() / group_size - 1;
+    auto group = static_cast<std::size_t>(h >> 7) & mask;
+    for (std::size_t step = 1;; ++step) {
+        auto first = group * group_size;
+        auto empties = match_group(&_ctrl[first], 0).empties;
+        if (empties != 0) {
+            auto slot = first + lowest_bit(empties);
+            _ctrl[slot] = static_cast<std::int8_t>(h & 0x7f);
+            _slots[slot] = static_cast<std::uint32_t>(pos);
+            return;
+        }
+        group = (group + step) & mask;
+    }
+}
@@ -0,0 +1,304 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file swiss_index.hpp
+ * \brief Defines the swiss_index type
+ *
+ * This file defines the swiss_index class, a key index of config_set, which looks up keys in an
+ * open-addressing hash table probed a group of slots at a time.
+ */
+
+#ifndef CONFY_SWISS_INDEX_HPP
+#define CONFY_SWISS_INDEX_HPP
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#ifdef USE_CXX17
+#  include <experimental/string_view>
+#  define string_view experimental::string_view
+#else
+#  include <string_view>
+#endif
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "key_hash.hpp"
+#include "prefetch.hpp"
+
+/**
+ * \brief Key index using a Swiss table
+ *
+ * A flat open-addressing hash table of entry positions, with one control byte per slot.
+ * The control byte of a used slot holds 7 bits of the hash of its key, and has its top bit clear;
+ * empty slots have the top bit set.
+ * The slots are probed in groups of 16: the control bytes of a whole group are compared to the
+ * looked up hash fragment at once (with SSE2, where available), and only the slots with matching
+ * fragments have their keys compared.
+ *
+ * Batches of keys are looked up in passes over the whole batch: hashing the keys and prefetching
+ * their first groups, then prefetching the key of the first candidate slot of each, then probing.
+ *
+ * The table keeps the entries in sorted order, and supports inserting new positions one by one;
+ * it grows by doubling when it is 7/8 full.
+ * Memory use is 5 bytes per slot.
+ */
+struct swiss_index {
+    /// The position returned for keys not in the index
+    constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+    /// The number of slots probed at once
+    constexpr static std::size_t group_size = 16;
+
+    /// The number of keys find_many looks up in one pass
+    constexpr static std::size_t batch_lanes = 32;
+
+    /**
+     * \brief Builds the index
+     *
+     * Inserts all entries into a table large enough for them.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param n The number of entries
+     * \param key_at The function returning the key of the entry at a given position
+     * \return An empty order, to keep the entries sorted
+     */
+    template<class KeyAt>
+    std::vector<std::size_t>
+    build(std::size_t n, KeyAt&& key_at) {
+        reset(n);
+        for (std::size_t i = 0; i < n; ++i) place(hash_key(key_at(i)), i);
+        _size = n;
+        return {};
+    }
+
+    /**
+     * \brief Inserts an entry position
+     *
+     * Adds the entry at the given position to the index.
+     * The key of the entry must not be in the index yet.
+     * If the table is too full, it is grown first, rehashing the keys of the entries already in it.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param pos The position of the new entry
+     * \param key_at The function returning the key of the entry at a given position
+     */
+    template<class KeyAt>
+    void
+    insert(std::size_t pos, KeyAt&& key_at) {
+        if ((_size + 1) * 8 > _ctrl.size() * 7) {
+            auto old = std::move(_slots);
+            auto old_ctrl = std::move(_ctrl);
+            reset(_size + 1);
+            for (std::size_t i = 0; i < old.size(); ++i) {
+                if (old_ctrl[i] >= 0) place(hash_key(key_at(old[i])), old[i]);
+            }
+        }
+        place(hash_key(key_at(pos)), pos);
+        ++_size;
+    }
+
+    /**
+     * \brief Finds a key
+     *
+     * Probes the groups of the table until the key is found, or a group with an empty slot is
+     * reached.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param key The key to look for
+     * \param key_at The function returning the key of the entry at a given position
+     * \return The position of the entry with the given key, or npos, if there is none.
+     */
+    template<class KeyAt>
+    std::size_t
+    find(std::string_view key, KeyAt&& key_at) const {
+        if (_ctrl.empty()) return npos;
+        return find_hashed(key, hash_key(key), key_at);
+    }
+
+    /**
+     * \brief Finds a batch of keys
+     *
+     * Looks up batch_lanes keys at a time in three passes, so the cache misses of the different
+     * keys overlap: the first pass hashes the keys and prefetches their first groups, the second
+     * prefetches the key of the first slot matching each hash, and the last probes the table.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param keys The keys to look for
+     * \param count The number of keys
+     * \param out The array receiving the position of each key, or npos, if it is not in the index
+     * \param key_at The function returning the key of the entry at a given position
+     */
+    template<class KeyAt>
+    void
+    find_many(const std::string_view* keys, std::size_t count, std::size_t* out, KeyAt&& key_at) const {
+        if (_ctrl.empty()) {
+            std::fill(out, out + count, npos);
+            return;
+        }
+        auto mask = _ctrl.size() / group_size - 1;
+        for (std::size_t first = 0; first < count; first += batch_lanes) {
+            auto width = std::min(batch_lanes, count - first);
+            std::uint64_t hashes[batch_lanes];
+            for (std::size_t l = 0; l < width; ++l) {
+                hashes[l] = hash_key(keys[first + l]);
+                auto slot = (static_cast<std::size_t>(hashes[l] >> 7) & mask) * group_size;
+                prefetch(&_ctrl[slot]);
+                prefetch(&_slots[slot]);
+            }
+            for (std::size_t l = 0; l < width; ++l) {
+                auto slot = (static_cast<std::size_t>(hashes[l] >> 7) & mask) * group_size;
+                auto matches = match_group(&_ctrl[slot], static_cast<std::int8_t>(hashes[l] & 0x7f)).matches;
+                if (matches != 0) prefetch(key_at(_slots[slot + lowest_bit(matches)]).data());
+            }
+            for (std::size_t l = 0; l < width; ++l) {
+                out[first + l] = find_hashed(keys[first + l], hashes[l], key_at);
+            }
+        }
+    }
+
+    /**
+     * \brief Getter for the number of entries
+     *
+     * \return The number of entries in the index.
+     */
+    std::size_t
+    size() const noexcept { return _size; }
+
+    /**
+     * \brief Getter for the size of the table
+     *
+     * \return The number of bytes used by the control bytes and the slots.
+     */
+    std::size_t
+    memory_usage() const noexcept {
+        return _ctrl.size() * (sizeof(std::int8_t) + sizeof(std::uint32_t));
+    }
+
+private:
+    /**
+     * \brief The result of matching a group of control bytes
+     */
+    struct group_masks {
+        std::uint32_t matches; ///< Bit i is set if the ith slot has the looked up fragment
+        std::uint32_t empties; ///< Bit i is set if the ith slot is empty
+    };
+
+    /**
+     * \brief Matches a group of control bytes against a hash fragment
+     *
+     * \param ctrl The first control byte of the group
+     * \param fragment The fragment to look for
+     * \return The masks of the matching and the empty slots
+     */
+    static group_masks
+    match_group(const std::int8_t* ctrl, std::int8_t fragment) noexcept;
+
+    /**
+     * \brief Finds a key with a known hash
+     *
+     * Probes the groups of the table until the key is found, or a group with an empty slot is
+     * reached.
+     * The table must not be empty.
+     *
+     * \tparam KeyAt The type of the key accessor function.
+     * \param key The key to look for
+     * \param h The hash of the key
+     * \param key_at The function returning the key of the entry at a given position
+     * \return The position of the entry with the given key, or npos, if there is none.
+     */
+    template<class KeyAt>
+    std::size_t
+    find_hashed(std::string_view key, std::uint64_t h, KeyAt&& key_at) const {
+        auto fragment = static_cast<std::int8_t>(h & 0x7f);
+        auto mask = _ctrl.size() / group_size - 1;
+        auto group = static_cast<std::size_t>(h >> 7) & mask;
+        for (std::size_t step = 1;; ++step) {
+            auto first = group * group_size;
+            auto masks = match_group(&_ctrl[first], fragment);
+            for (auto hits = masks.matches; hits != 0; hits &= hits - 1) {
+                auto slot = first + lowest_bit(hits);
+                if (key_at(_slots[slot]) == key) return _slots[slot];
+            }
+            if (masks.empties != 0) return npos;
+            group = (group + step) & mask;
+        }
+    }
+
+    /**
+     * \brief Returns the index of the lowest set bit
+     *
+     * \param bits The bits to search, which must not be zero
+     * \return The index of the lowest set bit
+     */
+    static std::size_t
+    lowest_bit(std::uint32_t bits) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<std::size_t>(__builtin_ctz(bits));
+#else
+        std::size_t idx = 0;
+        for (; !(bits & 1); bits >>= 1) ++idx;
+        return idx;
+#endif
+    }
+
+    /**
+     * \brief Clears the table, and resizes it for the given number of entries
+     *
+     * \param n The number of entries the table needs to hold
+     */
+    void
+    reset(std::size_t n);
+
+    /**
+     * \brief Stores a position in the first empty slot of its probe sequence
+     *
+     * Does not check the load of the table, which must have an empty slot.
+     *
+     * \param h The hash of the key of the entry
+     * \param pos The position of the entry
+     */
+    void
+    place(std::uint64_t h, std::size_t pos) noexcept;
+
+    std::vector<std::int8_t> _ctrl;     ///< The control bytes of the slots
+    std::vector<std::uint32_t> _slots;  ///< The entry positions stored in the slots
+    std::size_t _size = 0;              ///< The number of entries
+};
+
+#endif
@@ -33,12 +33,10 @@
  * \file type_id.cpp
  * \brief The source file companion of type_id.hpp
  *
- * The source part of the type_id.hpp file. Contains the non-template implementations of the type_id
- * class.
+ * The source part of the type_id.hpp file. The type_id class needs no non-template
+ * implementations, as the identifiers are link-time constants; used as compilation check.
  */
 
 #include "type_id.hpp"
 
 #include "memtrace.h"
-
-std::uint_fast32_t type_id::type_cntr = 1;
@@ -40,13 +40,31 @@
 #ifndef CONFY_TYPE_ID_HPP
 #define CONFY_TYPE_ID_HPP
 
-#include <cstdint>
+/**
+ * \brief The anchor of the type_id of a type
+ *
+ * Every type has its own anchor object, whose address identifies the type.
+ * The anchor is an inline variable, so it has a single address in the whole program, which is known
+ * at link time.
+ * It is not const, so the linker may not fold the anchors of different types together.
+ *
+ * \tparam T The type identified by the anchor.
+ */
+template<class T>
+struct type_id_anchor {
+    inline static char anchor = 0; ///< The object whose address identifies T
+};
 
 /**
  * \brief The type identifier type
  *
  * A class that is used to identify a given type in constant time. It forms a bijection between a
- * class and a numeric id, which can then be trivially checked for equivalence.
+ * class and the address of its type_id_anchor, which can then be trivially checked for
+ * equivalence.
+ *
+ * The identifiers are link-time constants: creating one needs no initialization at runtime, and so
+ * no locking, and comparing an object to the identifier of a known type is a comparison to a
+ * constant.
  */
 struct type_id {
     /**
@@ -56,16 +74,16 @@ struct type_id {
      * and will compare equal to all other objects created for the same T type and compare unequal
      * to all other types.
      *
-     * This is the only valid way to create a type_id class. If (somehow) a type_id object is not
-     * created this way, the behavior of the program is undefined.
+     * This is the only valid way to create a type_id class.
+     * May be called from any thread, and in constant expressions.
      *
      * \tparam T The type to create the object for.
      * \return The type_id object created for the type T.
      */
     template<class T>
-    static type_id
+    constexpr static type_id
     id_of() noexcept {
-        return type_id(make_type_id<T>(type_cntr));
+        return type_id(&type_id_anchor<T>::anchor);
     }
 
     /**
@@ -77,7 +95,7 @@ struct type_id {
      * \param other The other type_id object to check equality to
      * \return Whether the two type_id objects have been created for the same type.
      */
-    bool
+    constexpr bool
     operator==(const type_id& other) const noexcept { return _value == other._value; }
     /**
      * \brief The inequality operator for type_id objects
@@ -88,44 +106,14 @@ struct type_id {
      * \param other The other type_id object to check inequality to
      * \return Whether the two type_id object have been created for different types.
      */
-    bool
+    constexpr bool
     operator!=(const type_id& other) const noexcept { return _value != other._value; }
 
 private:
-    /**
-     * \brief Private constructor for type_id objects
-     *
-     * The actual constructor for the type_id type. It is hidden from the public eye as to not allow
-     * anybody to create objects that have not been created through the \refitem id_of<T>()
-     * function.
-     *
-     * \param val The integer id value to assign to this object. Refers to a singular
-     */
-    explicit type_id(std::uint_fast32_t val) noexcept
+    constexpr explicit type_id(const void* val) noexcept
          : _value(val) { }
 
-    std::uint_fast32_t _value;           ///< The value of the current type_id object
-    static std::uint_fast32_t type_cntr; ///< The next to be assigned value
-
-    /**
-     * \brief Generates the next type id
-     *
-     * Takes the static counter value as a reference, and checks if it was already instantiated for
-     * that T type.
-     * If it has, it returns the stored value, otherwise, it takes the value of the counter, and
-     * stores its value for later use, then increments the counter.
-     *
-     * \tparam T The type to get the id for
-     * \param cnt The static counter for type id assignments
-     * \return The unique numeric id for the type
-     */
-    template<class T>
-    static std::uint_fast32_t
-    make_type_id(std::uint_fast32_t& cnt) {
-        static std::uint_fast32_t value = 0;
-        if (value == 0) value = cnt++;
-        return value;
-    }
+    const void* _value; ///< The address of the anchor of the type
 };
 
 #endif
@@ -37,38 +37,106 @@
 #include "user_modes.hpp"
 
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <utility>
 
+#include "config_image.hpp"
 #include "config_set.hpp"
 #include "confy_parser.hpp"
+#include "image_cache.hpp"
+#include "source_buffer.hpp"
 
-int
-interactive_mode(const std::filesystem::path& cfg_file) {
-    config_set<confy_parser> conf(cfg_file);
-
-    for (;;) {
+namespace {
+    /**
+     * \brief Opens the cached image of a configuration file
+     *
+     * Rejects the image, if it fails to open.
+     *
+     * \param cache The cache of the file, found fresh
+     * \return The loaded set, or nothing, if the image is damaged.
+     */
+    std::optional<config_set<confy_parser>>
+    open_cached(image_cache& cache) {
         try {
-            std::string key;
-            if (!std::getline(std::cin, key)) return 0;
+            config_set<confy_parser> conf(compiled_image, cache.image());
+            cache.store(conf);
+            return conf;
+        } catch (const std::invalid_argument&) {
+            // a damaged image, or replaced by one since checked, parse the file instead
+            cache.reject();
+            return std::nullopt;
+        }
+    }
 
-            std::cout << conf.get<std::string_view>(key) << "\n";
-        } catch (const std::invalid_argument& ex) {
-            /* NOP, invalid keys are ignored here */
+    /**
+     * \brief Opens a configuration file
+     *
+     * Compiled images are opened as images.
+     * Other files are opened through their cached image, if it is fresh; otherwise they are parsed,
+     * and the image of the result is cached for the next time.
+     * The file is loaded once, both to compare its contents to the image, and to parse it.
+     *
+     * \param cfg_file The configuration file, or image
+     * \return The loaded set
+     */
+    config_set<confy_parser>
+    open_config(const std::filesystem::path& cfg_file) {
+        if (is_config_image(cfg_file)) return config_set<confy_parser>(compiled_image, cfg_file);
+
+        image_cache cache(cfg_file);
+        if (cache.fresh()) {
+            if (auto conf = open_cached(cache)) return std::move(*conf);
+        }
+        source_buffer src(cfg_file);
+        if (cache.fresh(src.view())) {
+            if (auto conf = open_cached(cache)) return std::move(*conf);
         }
+        config_set<confy_parser> conf(std::move(src), cfg_file);
+        cache.store(conf);
+        return conf;
     }
 }
 
+int
+interactive_mode(const std::filesystem::path& cfg_file) {
+    auto conf = open_config(cfg_file);
+
+    std::string key;
+    while (std::getline(std::cin, key)) {
+        auto value = conf.try_get<std::string_view>(key);
+        // an unknown key ends the session, with the same error get would report
+        if (!value) throw std::out_of_range("invalid key looked up: " + key);
+        std::cout << *value << "\n";
+    }
+    return 0;
+}
+
 
 int
 cli_mode(const std::filesystem::path& cfg_file, cli_keys_t keys) {
-    config_set<confy_parser> conf(cfg_file);
+    auto conf = open_config(cfg_file);
 
-    try {
-        for (const auto& key : keys) {
-            std::cout << conf.get<std::string_view>(key) << "\n";
-        }
-        return 0;
-    } catch (const std::out_of_range& ex) {
-        std::cerr << ex.what();
+    auto values = conf.get_many<std::string_view>(keys);
+    auto missing = values.first_missing();
+    auto printed = missing == values.npos ? values.size() : missing;
+    for (std::size_t i = 0; i < printed; ++i) {
+        std::cout << values[i] << "\n";
     }
+    if (missing == values.npos) return 0;
+
+    std::cerr << "invalid key looked up: " << keys[missing];
     return 2;
 }
+
+int
+compile_mode(const std::filesystem::path& cfg_file, const std::filesystem::path& image) {
+    config_set<confy_parser> conf(cfg_file);
+    conf.compile(image);
+    return 0;
+}
+
+bool
+is_compile_mode(int argc, const char* const* argv) {
+    return argc == 4 && std::string_view(argv[1]) == "--compile";
+}
@@ -34,7 +34,7 @@
 
 /**
  * \file user_modes.hpp
- * \brief Declares the two functions handling user interaction
+ * \brief Declares the functions handling user interaction
  */
 
 #ifndef CONFY_USER_MODES_HPP
@@ -87,4 +87,32 @@ using cli_keys_t = std::span<std::string_view>;
 int
 cli_mode(const std::filesystem::path& cfg_file, cli_keys_t keys);
 
+/**
+ * \brief The compiling user mode function
+ *
+ * This function implements the mode, where the user compiles a configuration file into an image,
+ * which the other modes then open without parsing.
+ *
+ * \param cfg_file The configuration file to compile
+ * \param image The image file to write
+ * \return Exit code
+ */
+int
+compile_mode(const std::filesystem::path& cfg_file, const std::filesystem::path& image);
+
+/**
+ * \brief Checks whether the command line selects the compiling user mode
+ *
+ * `confy --compile in.confy out.confyb` selects the compiling mode.
+ * The option is spelled as a flag, so no configuration file name selects it, and `confy compile k1
+ * k2` still reads the keys `k1` and `k2` from the file named `compile`, whatever the working
+ * directory holds.
+ *
+ * \param argc The number of command line arguments, including the program name
+ * \param argv The command line arguments
+ * \return Whether compile_mode should handle the command line
+ */
+bool
+is_compile_mode(int argc, const char* const* argv);
+
 #endif
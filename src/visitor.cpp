@@ -33,12 +33,20 @@
  * \file visitor.cpp
  * \brief The implementation source file for the visitor.hpp header file.
  *
- * This file provides the non-template functions' implementation from the visitor.hpp file. Since
- * most functions are templates, this file's most important purpose is to make sure the visitor.hpp
- * file doesn't accidentally rely on other headers being included before it--otherwise this file
- * which only includes it would fail to compile.
+ * This file provides the non-template functions' implementation from the visitor.hpp file: the
+ * counter of the visit indices. Since most functions are templates, this file's other important
+ * purpose is to make sure the visitor.hpp file doesn't accidentally rely on other headers being
+ * included before it--otherwise this file which only includes it would fail to compile.
  */
 
 #include "visitor.hpp"
 
+#include <atomic>
+
 #include "memtrace.h"
+
+std::size_t
+next_visit_index() noexcept {
+    static std::atomic<std::size_t> indices{1};
+    return indices.fetch_add(1, std::memory_order_relaxed);
+}
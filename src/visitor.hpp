@@ -48,8 +48,36 @@
 #  endif
 #endif
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+
 #include "type_id.hpp"
 
+/**
+ * \brief Returns the next unused visit index
+ *
+ * Hands out the dense numbers used to index visitors' dispatch tables, starting from one.
+ * Thread-safe.
+ *
+ * \return A number never returned before.
+ */
+std::size_t
+next_visit_index() noexcept;
+
+/**
+ * \brief The dense visit index of a type
+ *
+ * Each type visited or visitable gets a small, dense, non-zero number during the dynamic
+ * initialization of the program, which the dispatch tables of the visitors are indexed with.
+ * Reading it is a single load, but during the dynamic initialization it may still be zero, which
+ * the dispatch treats as not yet being in any table.
+ *
+ * \tparam T The type whose index is requested.
+ */
+template<class T>
+inline const std::size_t visit_index = next_visit_index();
+
 /**
  * \brief The dynamic visitor pattern's base class.
  *
@@ -57,10 +85,35 @@
  * able to accept this type of object (polymorphically) to be visited.
  * This is implemented in the cache class, for example.
  *
- * This class just passes down the implementation requirements into the class hierarchy through an
- * internal type-erased interface.
+ * Visitation is dispatched through a table, provided by the concrete visitor, indexed by the dense
+ * visit index of the visited type.
+ * Types with no entry in the table yet, and types with indices past the table's end, are passed
+ * down the hierarchy through an internal type-erased interface.
  */
 struct visitor_base {
+    /**
+     * \brief The type of the entries of the dispatch table
+     *
+     * A function that visits the type erased object with the visitor it is given.
+     */
+    using dispatch_fn = void (*)(visitor_base&, void*);
+
+    /**
+     * \brief The number of types the dispatch tables can hold
+     *
+     * Types whose visit index is not below this are dispatched by linear search, as are the ones
+     * with no entry in the table of the visitor.
+     */
+    static constexpr std::size_t dispatch_size = 64;
+
+    /**
+     * \brief The type of the dispatch table of a visitor
+     *
+     * The entries are filled while visiting, possibly by several threads at once, so they are
+     * atomic; loading one is an ordinary load on the common platforms.
+     */
+    using dispatch_table = std::array<std::atomic<dispatch_fn>, dispatch_size>;
+
     /**
      * \brief The function called to visit an object.
      *
@@ -68,7 +121,8 @@ struct visitor_base {
      * implemented in the hierarchy below.
      * Takes a T*, usually a `this` pointer, and performs the visitation on it.
      *
-     * Internally calculates the `type_id` value for the objects type, and casts the pointer down to
+     * Looks up the entry of T in the visitor's dispatch table, and calls it, if there is one.
+     * Otherwise, calculates the `type_id` value for the objects type, and casts the pointer down to
      * `void*`.
      * Passes these two values to the implementation functions, which will call the appropriate
      * `do_visit` functions in the hierarchy.
@@ -79,6 +133,10 @@ struct visitor_base {
     template<class T>
     void
     visit(T* visited) {
+        auto idx = visit_index<T>;
+        if (idx < dispatch_size) {
+            if (auto fn = (*_table)[idx].load(std::memory_order_relaxed)) return fn(*this, visited);
+        }
         visit_typeless(visited, type_id::id_of<T>());
     }
 
@@ -90,10 +148,18 @@ struct visitor_base {
     virtual ~visitor_base() noexcept = default;
 
 protected:
+    /**
+     * \brief Constructs the base with the dispatch table of the concrete visitor
+     *
+     * \param table The dispatch table. Must outlive the object.
+     */
+    explicit visitor_base(const dispatch_table& table) noexcept : _table(&table) { }
+
     /**
      * \brief Internal type-erased interface using runtime-type information.
      *
-     * This function is internal to the hierarchy and is used to implement the actual visitation.
+     * This function is internal to the hierarchy and is used to implement the actual visitation,
+     * for types that have no entry in the dispatch table.
      * The type erased object to be visited is passed through with a void-pointer and a `type_id`
      * object for providing runtime type information to figure out which type the type erased object
      * is.
@@ -104,19 +170,24 @@ protected:
      */
     virtual void
     visit_typeless(void* erased_visited, type_id tid) = 0;
+
+private:
+    const dispatch_table* _table; ///< The dispatch table of the concrete visitor
 };
 
 /**
  * \brief A visitor for a concrete T type
  *
  * A type in the dynamic visitor hierarchy.
- * Directly descending from the root, it provides the implementation for a singular object to be
- * visited using the `do_visit` pure virtual function.
+ * It provides the implementation for a singular object to be visited using the `do_visit` pure
+ * virtual function.
+ * It does not derive from visitor_base, only visitor<class... Ts> does, so that the dispatch
+ * functions may reach it with static casts only.
  *
  * \tparam T The type to provide visitation for.
  */
 template<class T>
-struct typed_visitor : virtual visitor_base {
+struct typed_visitor {
     /**
      * \brief Visitation callback for type T.
      *
@@ -135,7 +206,7 @@ struct typed_visitor : virtual visitor_base {
      * The defaulted constructor that does nothing.
      * May not throw.
      */
-    ~typed_visitor() noexcept override = default;
+    virtual ~typed_visitor() noexcept = default;
 };
 
 /**
@@ -143,12 +214,23 @@ struct typed_visitor : virtual visitor_base {
  *
  * This class combines multiple type_visitor objects, providing the ability to visit multiple types
  * of objects.
- * It inherits from `typed_visitor` classes for all types in the input Ts template parameter pack.
+ * It inherits from `typed_visitor` classes for all types in the input Ts template parameter pack,
+ * and from visitor_base, which it provides with a dispatch table shared by all objects of the type.
+ * The table starts out empty, and the entry of each type is filled by its first visit, which goes
+ * through the type-erased interface; it is never frozen, so types visited before their visit index
+ * was assigned, during the dynamic initialization, get their entry later.
  *
  * \tparam Ts Parameter pack holding all types the concrete visitor will be able to handle.
  */
 template<class... Ts>
-struct visitor : typed_visitor<Ts>... {
+struct visitor : visitor_base, typed_visitor<Ts>... {
+    /**
+     * \brief Default constructor
+     *
+     * Sets the dispatch table of the type up in the base.
+     */
+    visitor() noexcept : visitor_base(_dispatch) { }
+
     /**
      * \brief Defaulted destructor.
      *
@@ -158,6 +240,30 @@ struct visitor : typed_visitor<Ts>... {
     ~visitor() noexcept override = default;
 
 protected:
+    /**
+     * \brief The dispatch table of the visitor type
+     *
+     * Constant-initialized empty, so it needs no guard, and is valid before any dynamic
+     * initialization; try_visit fills the entries of the visited types.
+     */
+    inline static dispatch_table _dispatch{};
+
+    /**
+     * \brief Dispatch function of T
+     *
+     * Casts the visitor and the visited object back to their actual types, and visits.
+     *
+     * \tparam T The type to visit the object as.
+     * \param self The visitor, which is of this type.
+     * \param typeless_visited The type erased object to visit.
+     */
+    template<class T>
+    static void
+    dispatch(visitor_base& self, void* typeless_visited) {
+        static_cast<typed_visitor<T>&>(static_cast<visitor&>(self))
+               .do_visit(*static_cast<T*>(typeless_visited));
+    }
+
     /**
      * \brief Tries visiting for T
      *
@@ -166,6 +272,9 @@ protected:
      * returning true.
      * Otherwise it returns false.
      *
+     * On a match, the dispatch function of T is also put in the dispatch table, if the visit index
+     * of T is assigned by then, so the following visits of T are dispatched through the table.
+     *
      * This function is usually chained using parameter unpacking using logical OR.
      *
      * \tparam T The type to visit the object as.
@@ -177,6 +286,8 @@ protected:
     bool
     try_visit(void* typeless_visited, const type_id& tid) {
         if (type_id::id_of<T>() != tid) return false;
+        auto idx = visit_index<T>;
+        if (idx != 0 && idx < dispatch_size) _dispatch[idx].store(&dispatch<T>, std::memory_order_relaxed);
         static_cast<typed_visitor<T>*>(this)->do_visit(*static_cast<T*>(typeless_visited));
         return true;
     }
@@ -186,7 +297,7 @@ protected:
      * \brief Implemented typeless visitor internal.
      *
      * This class is the one in the hierarchy that implements the type erased visitor internal
-     * function.
+     * function, used for types that have no entry in the dispatch table.
      * Iteratively checks with each type it is supposed to be able to handle and if it finds a
      * matching T in Ts that has the same `type_id` as provided, it casts the type erased value
      * to that pointer, then calls the `do_visit` function with the proper parameters.
@@ -222,7 +333,7 @@ protected:
      * \brief Implemented typeless visitor internal.
      *
      * This class is the one in the hierarchy that implements the type erased visitor internal
-     * function.
+     * function, used for types that have no entry in the dispatch table.
      * Iteratively checks with each type it is supposed to be able to handle and if it finds a
      * matching T in Ts that has the same `type_id` as provided, it casts the type erased value
      * to that pointer, then calls the `do_visit` function with the proper parameters.
@@ -0,0 +1,121 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file scoped_env.hpp
+ * \brief This file defines a function template that may be used to change environment variables.
+ *
+ * This file defines the scoped_env class and the with_env function template, which change an
+ * environment variable for the lifetime of an object, or the duration of a single function call.
+ * These are used for automated testing of functions reading the environment.
+ */
+
+#ifndef CONFY_SCOPED_ENV_HPP
+#define CONFY_SCOPED_ENV_HPP
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+namespace {
+    void
+    set_env(const char* name, const char* value) {
+#ifdef _WIN32
+        _putenv_s(name, value ? value : "");
+#else
+        if (value) {
+            setenv(name, value, 1);
+        } else {
+            unsetenv(name);
+        }
+#endif
+    }
+
+}
+
+/**
+ * \brief Changes an environment variable for the lifetime of the object.
+ *
+ * Sets the environment variable to the given value, or removes it, if the value is nullptr, and
+ * restores the previous value of the variable when destroyed.
+ *
+ * The class is *not* thread safe.
+ */
+struct scoped_env {
+    /**
+     * \brief Changes the environment variable
+     *
+     * \param name The name of the environment variable
+     * \param value The value to set, or nullptr, to remove the variable
+     */
+    scoped_env(const char* name, const char* value)
+         : _name(name) {
+        auto old = std::getenv(name);
+        _had_value = old != nullptr;
+        if (old) _old = old;
+        set_env(name, value);
+    }
+
+    scoped_env(const scoped_env&) = delete;
+    scoped_env&
+    operator=(const scoped_env&) = delete;
+
+    /**
+     * \brief Restores the environment variable
+     */
+    ~scoped_env() { set_env(_name, _had_value ? _old.c_str() : nullptr); }
+
+private:
+    const char* _name; ///< The name of the variable
+    bool _had_value;   ///< Whether the variable was set
+    std::string _old;  ///< The previous value of the variable
+};
+
+/**
+ * \brief A function to run code with an environment variable changed.
+ *
+ * Changes the environment variable like scoped_env, for the duration of the function call.
+ *
+ * The function is *not* thread safe.
+ *
+ * \tparam Fn The type of the function to execute while the variable is changed. Perfect forwarded.
+ * \param name The name of the environment variable
+ * \param value The value to set, or nullptr, to remove the variable
+ * \param fn The function to execute during the changed environment.
+ */
+template<class Fn>
+void
+with_env(const char* name, const char* value, Fn&& fn) {
+    scoped_env env(name, value);
+    std::forward<Fn>(fn)();
+}
+
+#endif
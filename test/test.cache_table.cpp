@@ -0,0 +1,324 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.cache_table.cpp
+ * \brief Test functions for the cache_table class, and caching user-defined types in config
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "cache_factory.hpp"
+#include "cache_table.hpp"
+#include "caches.hpp"
+
+namespace {
+    /// A user-defined type parsed from "x,y"
+    struct point {
+        long x; ///< The first coordinate
+        long y; ///< The second coordinate
+    };
+
+    /// A second user-defined type, the sum of the coordinates of a point
+    struct manhattan {
+        long length; ///< The distance from the origin
+    };
+
+    /// A third user-defined type, the larger coordinate of a point
+    struct chebyshev {
+        long length; ///< The distance from the origin
+    };
+
+    struct point_cache : visitable_cache<point_cache> {
+        explicit point_cache(point&& data) noexcept : _data(std::move(data)) { }
+
+        const point*
+        get_value_ptr() const { return &_data; }
+
+    private:
+        point _data;
+    };
+
+    struct manhattan_cache : visitable_cache<manhattan_cache> {
+        explicit manhattan_cache(manhattan&& data) noexcept : _data(std::move(data)) { }
+
+        const manhattan*
+        get_value_ptr() const { return &_data; }
+
+    private:
+        manhattan _data;
+    };
+
+    struct chebyshev_cache : visitable_cache<chebyshev_cache> {
+        explicit chebyshev_cache(chebyshev&& data) noexcept : _data(std::move(data)) { }
+
+        const chebyshev*
+        get_value_ptr() const { return &_data; }
+
+    private:
+        chebyshev _data;
+    };
+
+    /// One of many user-defined types, to take more visit indices than the position table has
+    template<int N>
+    struct numbered {
+        long value; ///< The parsed value
+    };
+
+    template<int N>
+    struct numbered_cache : visitable_cache<numbered_cache<N>> {
+        explicit numbered_cache(numbered<N>&& data) noexcept : _data(std::move(data)) { }
+
+        const numbered<N>*
+        get_value_ptr() const { return &_data; }
+
+    private:
+        numbered<N> _data;
+    };
+
+    /// The number of points parsed, to see the cache hits
+    int points_parsed = 0;
+
+    bool
+    parse_point(std::string_view data, point& out) {
+        ++points_parsed;
+        char* end;
+        out.x = std::strtol(data.data(), &end, 10);
+        if (end == data.data() || *end != ',') return false;
+        auto rest = end + 1;
+        out.y = std::strtol(rest, &end, 10);
+        return end != rest;
+    }
+}
+
+template<>
+struct cache_factory<point> {
+    using cache_type = point_cache;
+
+    std::unique_ptr<cache>
+    construct(std::string_view data) {
+        point value;
+        if (!parse_point(data, value)) return nullptr;
+        return std::make_unique<cache_type>(std::move(value));
+    }
+};
+
+template<>
+struct cache_factory<manhattan> {
+    using cache_type = manhattan_cache;
+
+    std::unique_ptr<cache>
+    construct(std::string_view data) {
+        point value;
+        if (!parse_point(data, value)) return nullptr;
+        return std::make_unique<cache_type>(manhattan{std::labs(value.x) + std::labs(value.y)});
+    }
+};
+
+template<>
+struct cache_factory<chebyshev> {
+    using cache_type = chebyshev_cache;
+
+    std::unique_ptr<cache>
+    construct(std::string_view data) {
+        point value;
+        if (!parse_point(data, value)) return nullptr;
+        return std::make_unique<cache_type>(chebyshev{std::max(std::labs(value.x), std::labs(value.y))});
+    }
+};
+
+template<int N>
+struct cache_factory<numbered<N>> {
+    using cache_type = numbered_cache<N>;
+
+    std::unique_ptr<cache>
+    construct(std::string_view data) {
+        return std::make_unique<cache_type>(numbered<N>{std::strtol(data.data(), nullptr, 10)});
+    }
+};
+
+#include "config_set.hpp"
+#include "confy_parser.hpp"
+
+namespace {
+    /**
+     * \brief Stores numbered types in a table, and checks which of them are found
+     *
+     * \tparam Ns The numbers of the types to store, in order
+     * \param sut The table to store into
+     * \return The number of types found after storing all of them
+     */
+    template<int... Ns>
+    std::size_t
+    store_numbered(cache_table& sut, std::integer_sequence<int, Ns...>) {
+        int stored[] = {(sut.store<numbered<Ns>>(cache_factory<numbered<Ns>>().construct(std::to_string(Ns))), Ns)...};
+        static_cast<void>(stored);
+
+        std::size_t found = 0;
+        int matching[] = {(found += sut.find<numbered<Ns>>() && sut.find<numbered<Ns>>()->value == Ns, Ns)...};
+        static_cast<void>(matching);
+        return found;
+    }
+}
+
+#include "gtest_lite.h"
+
+void
+test_cache_table() {
+    TEST(cache_table, empty) {
+        cache_table sut;
+        EXPECT_TRUE(sut.find<point>() == nullptr);
+    }
+    END
+
+    TEST(cache_table, store) {
+        cache_table sut;
+        const auto& stored = sut.store<point>(cache_factory<point>().construct("3,-4"));
+        EXPECT_EQ(stored.x, 3);
+        EXPECT_EQ(stored.y, -4);
+        EXPECT_TRUE(sut.find<point>() == &stored);
+        EXPECT_TRUE(sut.find<manhattan>() == nullptr);
+
+        sut.store<manhattan>(cache_factory<manhattan>().construct("3,-4"));
+        EXPECT_TRUE(sut.find<manhattan>() != nullptr);
+        EXPECT_EQ(sut.find<manhattan>()->length, 7);
+        EXPECT_EQ(sut.find<point>() != nullptr, cache_table::max_types > 1);
+    }
+    END
+
+    TEST(cache_table, replaces_oldest) {
+        cache_table sut;
+        sut.store<point>(cache_factory<point>().construct("3,-4"));
+        sut.store<manhattan>(cache_factory<manhattan>().construct("3,-4"));
+        sut.store<chebyshev>(cache_factory<chebyshev>().construct("3,-4"));
+        // only the oldest cache gives way to the new type
+        EXPECT_EQ(sut.find<chebyshev>()->length, 4);
+        EXPECT_EQ(sut.find<manhattan>() != nullptr, cache_table::max_types > 1);
+        EXPECT_EQ(sut.find<point>() != nullptr, cache_table::max_types > 2);
+
+        // storing a cached type again replaces its cache in place
+        sut.store<chebyshev>(cache_factory<chebyshev>().construct("1,1"));
+        EXPECT_EQ(sut.find<chebyshev>()->length, 1);
+        EXPECT_EQ(sut.find<manhattan>() != nullptr, cache_table::max_types > 1);
+    }
+    END
+
+    TEST(cache_table, builtin_values) {
+        cache_table sut;
+        int value = 0;
+        EXPECT_FALSE(sut.get(value));
+
+        sut.store(42);
+        sut.store(true);
+        bool other = false;
+        EXPECT_EQ(sut.get(value), cache_table::max_types > 1);
+        EXPECT_TRUE(sut.get(other));
+        EXPECT_TRUE(other);
+        if (cache_table::max_types > 1) EXPECT_EQ(value, 42);
+
+        // only the stored types hit
+        unsigned same_bits = 0;
+        EXPECT_FALSE(sut.get(same_bits));
+        EXPECT_TRUE(sut.find<point>() == nullptr);
+
+        // the built-in values and the user-defined caches share the slots
+        sut.store<point>(cache_factory<point>().construct("3,-4"));
+        EXPECT_EQ(sut.find<point>()->x, 3);
+        EXPECT_EQ(sut.get(other), cache_table::max_types > 1);
+    }
+    END
+
+    TEST(cache_table, many_types) {
+        // more types than the position table has room for are still found, once each is stored
+        cache_table sut;
+        auto found = store_numbered(sut, std::make_integer_sequence<int, 80>{});
+        EXPECT_EQ(found, std::min<std::size_t>(cache_table::max_types, 80));
+        EXPECT_TRUE(visit_index<numbered<79>> != visit_index<numbered<0>>);
+    }
+    END
+
+    TEST(cache_table, config_spills_inline_value) {
+        config sut(string_ref{0, 2});
+        EXPECT_EQ(sut.get_as<int>("42"), 42);
+        EXPECT_EQ(sut.get_as<long>("42"), 42l);
+        // the inline value moved into the table, so the entry is not read again while both fit
+        EXPECT_EQ(sut.get_as<long>("17"), 42l);
+        EXPECT_EQ(sut.get_as<int>("17"), cache_table::max_types > 1 ? 42 : 17);
+    }
+    END
+
+    TEST(cache_table, config_size) {
+        // entries hold their value and a single small buffer, the table is only allocated on need
+        EXPECT_LE(sizeof(config), sizeof(string_ref) + sizeof(inline_cache) + alignof(string_ref));
+
+        std::stringstream ss("n=42\n");
+        config_set<confy_parser> sut(ss);
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_EQ(sut.get<int>("n"), 42);
+            EXPECT_EQ(sut.get<long>("n"), 42l);
+            EXPECT_DOUBLE_EQ(sut.get<double>("n"), 42.);
+        }
+    }
+    END
+
+    TEST(cache_table, wrong_cache_type) {
+        cache_table sut;
+        EXPECT_THROW(sut.store<point>(cache_factory<manhattan>().construct("1,1")), const std::runtime_error&);
+        EXPECT_TRUE(sut.find<point>() == nullptr);
+    }
+    END
+
+    TEST(cache_table, config_alternating_types) {
+        std::stringstream ss("p='3,-4'\n");
+        config_set<confy_parser> sut(ss);
+        points_parsed = 0;
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_EQ(sut.get<point>("p").y, -4);
+            EXPECT_EQ(sut.get<manhattan>("p").length, 7);
+        }
+        // each type is parsed once, if both fit the cache
+        EXPECT_EQ(points_parsed, cache_table::max_types > 1 ? 2 : 20);
+
+        EXPECT_FALSE(static_cast<bool>(sut.try_get<point>("no such key")));
+    }
+    END
+}
@@ -46,6 +46,9 @@
 #else
 #  include <string_view>
 #endif
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
 #include <string>
 #include <type_traits>
 
@@ -81,6 +84,47 @@ namespace {
     template<>
     constexpr const auto valid_value<bool> = true;
 
+    // the conversion cache_factory used before parse_number
+    template<class T>
+    T
+    strto_parse(const char* str) {
+        char* end;
+        if (std::is_same<T, float>::value) return static_cast<T>(std::strtof(str, &end));
+        if (std::is_same<T, double>::value) return static_cast<T>(std::strtod(str, &end));
+        if (std::is_same<T, long double>::value) return static_cast<T>(std::strtold(str, &end));
+        if (std::is_same<T, long long>::value) return static_cast<T>(std::strtoll(str, &end, 10));
+        if (std::is_same<T, unsigned long long>::value) return static_cast<T>(std::strtoull(str, &end, 10));
+        if (std::is_unsigned<T>::value) return static_cast<T>(std::strtoul(str, &end, 10));
+        return static_cast<T>(std::strtol(str, &end, 10));
+    }
+
+    template<class T>
+    void
+    time_conversion(int id) {
+        constexpr int rounds = 1 << 16;
+        cache_factory<T> sut;
+        std::string_view input = valid_input<T>;
+        volatile T sink{};
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) {
+            T parsed{};
+            sut.parse(input, parsed);
+            sink = static_cast<T>(sink + parsed);
+        }
+        auto mid = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) {
+            sink = static_cast<T>(sink + strto_parse<T>(valid_input<T>));
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        auto per_parse = [](std::chrono::steady_clock::duration d) {
+            return std::chrono::duration<double, std::nano>(d).count() / rounds;
+        };
+        std::cout << "conversion #" << id << ": " << per_parse(mid - start) << " ns/parse, strto*: "
+                  << per_parse(end - mid) << " ns/parse\n";
+    }
+
     template<class T, class I>
     struct do_test {
         explicit do_test(tlist<T, I>) { }
@@ -97,6 +141,21 @@ namespace {
             EXPECT_TRUE(sut.construct(valid_input<T>) != nullptr);
             gtest_lite::test.end();
 
+            gtest_lite::test.begin(("cached_cachefactory.parse#" + std::to_string(I::value)).c_str());
+            T parsed{};
+            EXPECT_FALSE(sut.parse(invalid_input, parsed));
+            EXPECT_TRUE(sut.parse(valid_input<T>, parsed));
+            if (std::is_integral<T>::value) {
+                EXPECT_EQ(parsed, valid_value<T>);
+            } else {
+                EXPECT_DOUBLE_EQ(parsed, valid_value<T>);
+            }
+            gtest_lite::test.end();
+
+            gtest_lite::test.begin(("cached_cachefactory.conversion_timing#" + std::to_string(I::value)).c_str());
+            EXPECT_NO_THROW(time_conversion<T>(I::value));
+            gtest_lite::test.end();
+
             gtest_lite::test.begin(("cache_vtor_for.T_validity#" + std::to_string(I::value)).c_str());
             cache_visitor_for<T> vtor;
             EXPECT_FALSE(vtor.valid());
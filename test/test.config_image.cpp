@@ -0,0 +1,296 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.config_image.cpp
+ * \brief Test functions for the compiled configuration images
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config_image.hpp"
+#include "source_buffer.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+namespace {
+    /**
+     * \brief Reads a whole file
+     *
+     * \param file The file to read
+     * \return The bytes of the file
+     */
+    std::string
+    read_bytes(const std::filesystem::path& file) {
+        std::ifstream ifs(file, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(ifs), {});
+    }
+
+    /**
+     * \brief Overwrites a file
+     *
+     * \param file The file to write
+     * \param bytes The new bytes of the file
+     */
+    void
+    write_bytes(const std::filesystem::path& file, const std::string& bytes) {
+        std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+        ofs.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    /**
+     * \brief Writes the image of a few entries
+     *
+     * \param file The file to write
+     * \return The file path
+     */
+    std::filesystem::path
+    write_sample(const std::filesystem::path& file) {
+        std::vector<std::string> strs{"alpha", "1", "beta", "some value", "gamma", ""};
+        std::vector<std::pair<std::string_view, std::string_view>> entries;
+        for (std::size_t i = 0; i < strs.size(); i += 2) entries.emplace_back(strs[i], strs[i + 1]);
+        write_config_image(file, entries);
+        return file;
+    }
+}
+
+void
+test_config_image() {
+    TEST(config_image, round_trip) {
+        auto file = write_sample("sample.confyb");
+        for (const auto& ent : std::filesystem::directory_iterator(".")) {
+            EXPECT_EQ(ent.path().string().find(".partial"), std::string::npos);
+        }
+        EXPECT_TRUE(is_config_image(file));
+
+        source_buffer buf(file);
+        auto image = open_config_image(buf, file, true);
+        EXPECT_EQ(image.entries, std::size_t{3});
+        EXPECT_EQ(std::string(image.key(0).in(buf.data())), "alpha"s);
+        EXPECT_EQ(std::string(image.key(2).in(buf.data())), "gamma"s);
+        EXPECT_EQ(std::string(image.value(1).in(buf.data())), "some value"s);
+        EXPECT_EQ(std::string(image.value(2).in(buf.data())), ""s);
+
+        // the strings of the arena are NUL-terminated
+        auto value = image.value(0);
+        EXPECT_EQ(buf.data()[value.offset + value.length], '\0');
+        EXPECT_EQ(image.source.hash, std::uint64_t{});
+        std::filesystem::remove(file);
+    }
+    END
+
+    TEST(config_image, empty) {
+        write_config_image("empty.confyb", {});
+        source_buffer buf("empty.confyb");
+        EXPECT_EQ(open_config_image(buf, "empty.confyb", true).entries, std::size_t{});
+        std::filesystem::remove("empty.confyb");
+    }
+    END
+
+    TEST(config_image, padding) {
+        // 104 bytes of header, 16 bytes of references, and the 8070 bytes of the strings with their
+        // NUL bytes fill two 4 KiB pages exactly
+        std::string value(8067, 'x');
+        write_config_image("padding.confyb", {{"key"sv, value}});
+        EXPECT_EQ(std::filesystem::file_size("padding.confyb"), std::uintmax_t{8193});
+
+        source_buffer buf("padding.confyb");
+#if defined(__unix__) || defined(__APPLE__)
+        EXPECT_TRUE(buf.mapped());
+#endif
+        auto image = open_config_image(buf, "padding.confyb", true);
+        EXPECT_EQ(image.value(0).in(buf.data()).size(), value.size());
+        EXPECT_EQ(buf.data()[8192], '\0');
+        std::filesystem::remove("padding.confyb");
+    }
+    END
+
+    TEST(config_image, source) {
+        image_source source;
+        source.path = 1;
+        source.size = 2;
+        source.mtime = -3;
+        source.hash = 4;
+        source.checked = 5;
+        write_config_image("source.confyb", {}, source);
+
+        image_source read;
+        EXPECT_TRUE(read_image_source("source.confyb", read));
+        EXPECT_EQ(read.path, std::uint64_t{1});
+        EXPECT_EQ(read.size, std::uint64_t{2});
+        EXPECT_EQ(read.mtime, std::int64_t{-3});
+        EXPECT_EQ(read.hash, std::uint64_t{4});
+        EXPECT_EQ(read.checked, std::int64_t{5});
+
+        source_buffer buf("source.confyb");
+        EXPECT_EQ(open_config_image(buf, "source.confyb", true).source.hash, std::uint64_t{4});
+        std::filesystem::remove("source.confyb");
+
+        EXPECT_FALSE(read_image_source("ints.confy", read));
+        EXPECT_FALSE(read_image_source("empty1.confy", read));
+        EXPECT_FALSE(read_image_source("-invalid-", read));
+    }
+    END
+
+    TEST(config_image, is_config_image) {
+        EXPECT_FALSE(is_config_image("ints.confy"));
+        EXPECT_FALSE(is_config_image("empty1.confy"));
+        EXPECT_FALSE(is_config_image("-invalid-"));
+    }
+    END
+
+    TEST(config_image, rejects_damaged) {
+        auto file = write_sample("damaged.confyb");
+        auto bytes = read_bytes(file);
+
+        // every byte of the header is checked in constant time
+        for (std::size_t i = 0; i < 104; ++i) {
+            auto damaged = bytes;
+            damaged[i] ^= 0x20;
+            write_bytes(file, damaged);
+            source_buffer buf(file);
+            EXPECT_THROW(open_config_image(buf, file, false), const std::invalid_argument&);
+        }
+
+        write_bytes(file, bytes.substr(0, bytes.size() - 1));
+        {
+            source_buffer buf(file);
+            EXPECT_THROW(open_config_image(buf, file, false), const std::invalid_argument&);
+        }
+
+        // the body is only checked when verifying
+        auto damaged = bytes;
+        damaged[bytes.size() - 3] ^= 0x20;
+        write_bytes(file, damaged);
+        {
+            source_buffer buf(file);
+            EXPECT_NO_THROW(open_config_image(buf, file, false));
+            EXPECT_THROW(open_config_image(buf, file, true), const std::invalid_argument&);
+        }
+
+        write_bytes(file, "key=value\n");
+        {
+            source_buffer buf(file);
+            EXPECT_THROW(open_config_image(buf, file, false), const std::invalid_argument&);
+        }
+        std::filesystem::remove(file);
+    }
+    END
+
+    TEST(config_image, rejects_bad_tables) {
+        auto file = write_sample("tables.confyb");
+        auto bytes = read_bytes(file);
+        const std::size_t keys = 104, values = keys + 3 * 8;
+        auto ref_at = [&bytes](std::size_t at) {
+            std::uint32_t ref[2];
+            std::memcpy(ref, &bytes[at], sizeof(ref));
+            return std::make_pair(ref[0], ref[1]);
+        };
+        // opening only checks the header, the references are checked as they are read
+        auto rejects = [&file](const std::string& damaged) {
+            write_bytes(file, damaged);
+            source_buffer buf(file);
+            auto image = open_config_image(buf, file, false);
+            auto read_all = [&image] {
+                for (std::size_t i = 0; i < image.entries; ++i) {
+                    image.key(i);
+                    image.value(i);
+                }
+            };
+            EXPECT_THROW(read_all(), const std::invalid_argument&);
+            EXPECT_THROW(open_config_image(buf, file, true), const std::invalid_argument&);
+        };
+        // the order of the keys is only checked when verifying
+        auto unordered = [&file](const std::string& damaged) {
+            write_bytes(file, damaged);
+            source_buffer buf(file);
+            EXPECT_NO_THROW(open_config_image(buf, file, false));
+            EXPECT_THROW(open_config_image(buf, file, true), const std::invalid_argument&);
+        };
+        auto with_ref = [&bytes](std::size_t at, std::uint32_t offset, std::uint32_t length) {
+            auto damaged = bytes;
+            std::uint32_t ref[2] = {offset, length};
+            std::memcpy(&damaged[at], ref, sizeof(ref));
+            return damaged;
+        };
+
+        // the header stays valid, only the unverified body is damaged
+        auto key = ref_at(keys);
+        auto value = ref_at(values + 8);
+        rejects(with_ref(keys, key.first, 0xffffff00u));
+        rejects(with_ref(values + 8, 0xfffffff0u, value.second));
+        rejects(with_ref(values + 8, value.first, value.second + 1));
+        rejects(with_ref(keys, 0, key.second));
+
+        // keys out of order, and duplicate keys
+        auto swapped = bytes;
+        std::memcpy(&swapped[keys], &bytes[keys + 8], 8);
+        std::memcpy(&swapped[keys + 8], &bytes[keys], 8);
+        unordered(swapped);
+        unordered(with_ref(keys + 8, key.first, key.second));
+
+        write_bytes(file, bytes);
+        {
+            source_buffer buf(file);
+            EXPECT_NO_THROW(open_config_image(buf, file, true));
+        }
+        std::filesystem::remove(file);
+    }
+    END
+
+    TEST(config_image, unwritable) {
+        EXPECT_THROW(write_config_image("no-such-directory/image.confyb", {}), const std::invalid_argument&);
+
+        // a directory in place of the image cannot be replaced, and the written file is removed
+        auto dir = std::filesystem::path("unwritable-image");
+        std::filesystem::create_directories(dir / "image.confyb");
+        EXPECT_THROW(write_config_image(dir / "image.confyb", {}), const std::invalid_argument&);
+        EXPECT_EQ(std::distance(std::filesystem::directory_iterator(dir), {}), std::ptrdiff_t{1});
+        std::filesystem::remove_all(dir);
+    }
+    END
+}
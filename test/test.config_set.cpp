@@ -41,23 +41,275 @@
 #endif
 
 #ifdef USE_CXX17
+#  include <experimental/optional>
 #  include <experimental/string_view>
+#  define optional experimental::optional
 #  define string_view experimental::string_view
 #else
+#  include <optional>
 #  include <string_view>
 #endif
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <istream>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 #include "bad_key.hpp"
 #include "bad_syntax.hpp"
+#include "bare_hex.hpp"
+#include "config_diff.hpp"
 #include "config_set.hpp"
 #include "confy_parser.hpp"
+#include "eytzinger_index.hpp"
+#include "parser.hpp"
+#include "perfect_hash_index.hpp"
+#include "swiss_index.hpp"
 
 using namespace std::literals;
 
 #include "gtest_lite.h"
 
+namespace {
+#ifdef MEMTRACE
+    /**
+     * \brief Returns the number of allocations made by the program so far
+     *
+     * Unlike memtrace::allocated_blocks, which counts the blocks alive, this number never decreases.
+     *
+     * \return The number of allocations made
+     */
+    std::size_t
+    allocation_count() {
+        return memtrace::allocations_made();
+    }
+#endif
+
+    /**
+     * \brief Generates a large configuration file
+     *
+     * Writes the given number of key-value lines, with the keys in a scrambled order, mixed with comments and empty lines.
+     * The line with the given index may be replaced by a given line, to inject errors.
+     *
+     * \param file The file to write
+     * \param lines The number of key-value lines
+     * \param special_at The lines to replace
+     * \return The file path
+     */
+    std::filesystem::path
+    generate_config(const std::filesystem::path& file,
+                    int lines,
+                    std::initializer_list<std::pair<int, std::string>> special_at = {}) {
+        std::ofstream ofs(file, std::ios::binary);
+        for (int i = 0; i < lines; ++i) {
+            auto special = std::find_if(special_at.begin(), special_at.end(), [i](const auto& sp) {
+                return sp.first == i;
+            });
+            if (special != special_at.end()) {
+                ofs << special->second << "\n";
+                continue;
+            }
+            auto k = (i * 7919) % lines;
+            if (i % 97 == 0) ofs << "# comment " << i << "\n\n";
+            if (i % 2) {
+                ofs << "key" << k << "=value" << k << "\n";
+            } else {
+                ofs << "key" << k << "='quoted value " << k << "'\n";
+            }
+        }
+        return file;
+    }
+
+    /**
+     * \brief A parser only providing the copying interface
+     *
+     * Hides the view based interface of confy_parser, to test the stream based loading of
+     * config_set.
+     */
+    struct copying_parser {
+        copying_parser(const std::filesystem::path& file) noexcept : _parser(file) { }
+
+        std::optional<std::string>
+        next_line(std::istream& strm) const { return _parser.next_line(strm); }
+
+        std::pair<std::string, std::string>
+        parse_line(std::string_view ln) const { return _parser.parse_line(ln); }
+
+    private:
+        confy_parser _parser;
+    };
+
+#ifdef MEMTRACE
+    /**
+     * \brief Counts the allocations made while loading a configuration set
+     *
+     * \tparam P The parser to load the set with.
+     * \param file The file to load
+     * \return The number of allocations made by the constructor of the set
+     */
+    template<class P>
+    std::size_t
+    allocations_of(const std::filesystem::path& file) {
+        auto before = allocation_count();
+        config_set<P> cs(file);
+        return allocation_count() - before;
+    }
+
+    /**
+     * \brief Counts the allocations made while loading a configuration set from a stream
+     *
+     * \tparam P The parser to load the set with.
+     * \param file The file to read through a stream
+     * \return The number of allocations made by the constructor of the set
+     */
+    template<class P>
+    std::size_t
+    stream_allocations_of(const std::filesystem::path& file) {
+        std::ifstream ifs(file);
+        auto before = allocation_count();
+        config_set<P> cs(ifs);
+        return allocation_count() - before;
+    }
+#endif
+
+    /**
+     * \brief Compares a batched lookup to looking up the keys one by one
+     *
+     * Looks up the keys key0 to key{n + n / 2}, in a scrambled order, with get_many on a set using
+     * the given index, and with get on the reference set.
+     *
+     * \tparam I The key index to load the set with.
+     * \param file The file to load
+     * \param n The number of keys in the file
+     * \return The number of keys whose results differ
+     */
+    template<class I>
+    int
+    get_many_mismatches(const std::filesystem::path& file, int n) {
+        config_set<confy_parser> ref(file);
+        config_set<confy_parser, I> sut(file);
+
+        std::vector<std::string> names;
+        for (int i = 0; i < n + n / 2; ++i) names.push_back("key" + std::to_string(i * 7919 % (n + n / 2)));
+        names.push_back("");
+        std::vector<std::string_view> keys(names.begin(), names.end());
+
+        auto res = sut.template get_many<std::string>(keys);
+        int mismatches = res.size() != keys.size();
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            try {
+                auto expected = ref.get<std::string>(keys[i]);
+                mismatches += !res.found(i) || res[i] != expected;
+            } catch (const std::out_of_range&) {
+                mismatches += res.found(i);
+            }
+        }
+        return mismatches;
+    }
+
+    /**
+     * \brief Compares a column conversion to converting the entries one by one
+     *
+     * Converts every entry of the file to int with get_all_as on a set using the given index, and
+     * compares the results to try_get on the keys of the entries.
+     *
+     * \tparam I The key index to load the set with.
+     * \param file The file to load
+     * \param threads The number of threads to convert with
+     * \return The number of entries whose results differ
+     */
+    template<class I>
+    int
+    get_all_as_mismatches(const std::filesystem::path& file, unsigned threads) {
+        config_set<confy_parser> ref(file);
+        config_set<confy_parser, I> sut(file);
+
+        auto res = sut.template get_all_as<int>(threads);
+        int mismatches = res.size() != sut.size();
+        for (std::size_t i = 0; i < res.size(); ++i) {
+            auto expected = ref.try_get<int>(sut.key_at(i));
+            mismatches += res.found(i) != static_cast<bool>(expected) || (expected && res[i] != *expected);
+        }
+        return mismatches;
+    }
+
+    /**
+     * \brief Compares a set opened from a compiled image to the parsed set
+     *
+     * Compiles the file, opens the image with a set using the given index, and looks up every key of
+     * the parsed set, and a few missing ones, in both.
+     *
+     * \tparam I The key index to open the image with.
+     * \param file The file to compile
+     * \return The number of keys whose results differ
+     */
+    template<class I>
+    int
+    compiled_mismatches(const std::filesystem::path& file) {
+        config_set<confy_parser> ref(file);
+        auto image = std::filesystem::path(file) += "b";
+        ref.compile(image);
+        config_set<confy_parser, I> sut(compiled_image, image, true);
+
+        int mismatches = sut.size() != ref.size();
+        for (std::size_t i = 0; i < ref.size(); ++i) {
+            auto key = ref.key_at(i);
+            auto value = sut.template try_get<std::string>(key);
+            mismatches += !value || *value != ref.get<std::string>(key);
+        }
+        for (auto missing : {"", "key", "zzz"}) mismatches += static_cast<bool>(sut.template try_get<std::string>(missing));
+        std::filesystem::remove(image);
+        return mismatches;
+    }
+
+    std::string
+    error_of(const std::filesystem::path& file, unsigned threads) {
+        try {
+            config_set<confy_parser> cs(file, threads);
+        } catch (const std::exception& ex) {
+            return ex.what();
+        }
+        return "";
+    }
+
+    /**
+     * \brief Carries the caches of one load of a configuration over to another
+     *
+     * \tparam I The key index to load the configurations with.
+     * \param before The contents of the earlier load
+     * \param after The contents of the later load
+     * \return The differences of the loads
+     */
+    template<class I>
+    config_diff
+    diff_of(std::string_view before, std::string_view after) {
+        config_set<confy_parser, I> previous(source_buffer::copy_of(before), "before.confy");
+        config_set<confy_parser, I> next(source_buffer::copy_of(after), "after.confy");
+        return next.carry_over(previous);
+    }
+
+    /**
+     * \brief Returns the message of the exception thrown by a function
+     *
+     * \param fn The function to call
+     * \return The message of the exception, or an empty string, if nothing was thrown.
+     */
+    template<class Fn>
+    std::string
+    message_of(Fn&& fn) {
+        try {
+            fn();
+        } catch (const std::exception& ex) {
+            return ex.what();
+        }
+        return "";
+    }
+}
+
 void
 test_config_set() {
     using confy_set = config_set<confy_parser>; // testing our implementation
@@ -432,4 +684,503 @@ test_config_set() {
         EXPECT_THROW(std::ignore = cs.get<std::string_view>("no such key"), const std::out_of_range&);
     }
     END
+
+    TEST(config_set, xcolors_bare_hex) {
+        std::filesystem::path file = "xcolors.confy"s;
+        confy_set cs(file);
+
+        // every key of the theme, decoded in one batch
+        std::vector<std::string> names;
+        std::ifstream ifs(file);
+        for (std::string line; std::getline(ifs, line);) {
+            auto eq = line.find('=');
+            if (line.empty() || line[0] == '#' || eq == std::string::npos) continue;
+            names.push_back(line.substr(0, eq));
+        }
+        std::vector<std::string_view> keys(names.begin(), names.end());
+        EXPECT_EQ(keys.size(), cs.size());
+
+        auto colors = cs.get_many<bare_hex<std::uint32_t>>(keys);
+        EXPECT_TRUE(colors.all_found());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(colors[i].value, std::uint32_t(std::stoul(cs.get<std::string>(keys[i]), nullptr, 16)));
+        }
+        EXPECT_EQ(cs.get<bare_hex<std::uint32_t>>("foreground").value, std::uint32_t(0xA9B2D6));
+        EXPECT_EQ(cs.get<bare_hex<std::uint32_t>>("background").value, std::uint32_t(0x20212E));
+        std::uint32_t cursor = cs.get<bare_hex<std::uint32_t>>("cursorColor");
+        EXPECT_EQ(cursor, std::uint32_t(0xFAFAFA));
+    }
+    END
+
+    TEST(config_set, crlf_file) {
+        std::filesystem::path file = "crlf.confy"s;
+        EXPECT_NO_THROW(confy_set cs(file));
+
+        confy_set cs(file);
+        EXPECT_EQ(cs.size(), std::size_t{4});
+
+        for (auto&& data : {
+                    std::make_pair("key"s, "bare"s),
+                    std::make_pair("quoted"s, "some value"s),
+                    std::make_pair("empty"s, ""s),
+                    std::make_pair("last"s, "end"s),
+             }) {
+            auto&& key = data.first;
+            auto&& value = data.second;
+            EXPECT_EQ(cs.get<std::string>(key), value);
+            EXPECT_STREQ(cs.get<const char*>(key), value.c_str());
+        }
+    }
+    END
+
+    TEST(config_set, crlf_stream) {
+        std::filesystem::path file = "crlf.confy"s;
+        std::ifstream ifs(file);
+        confy_set cs(ifs);
+        EXPECT_EQ(cs.size(), std::size_t{4});
+
+        for (auto&& data : {
+                    std::make_pair("key"s, "bare"s),
+                    std::make_pair("quoted"s, "some value"s),
+                    std::make_pair("empty"s, ""s),
+                    std::make_pair("last"s, "end"s),
+             }) {
+            auto&& key = data.first;
+            auto&& value = data.second;
+            EXPECT_EQ(cs.get<std::string>(key), value);
+            EXPECT_STREQ(cs.get<const char*>(key), value.c_str());
+        }
+    }
+    END
+
+    TEST(config_set, parallel_file) {
+        auto file = generate_config("generated.confy", 12000);
+        confy_set seq(file);
+        confy_set par(file, 8);
+        EXPECT_EQ(seq.size(), std::size_t{12000});
+        EXPECT_EQ(par.size(), seq.size());
+
+        for (int i = 0; i < 12000; i += 7) {
+            auto key = "key" + std::to_string(i);
+            EXPECT_EQ(par.get<std::string>(key), seq.get<std::string>(key));
+            EXPECT_STREQ(par.get<const char*>(key), seq.get<const char*>(key));
+        }
+        EXPECT_THROW(std::ignore = par.get<std::string_view>("no such key"), const std::out_of_range&);
+        std::filesystem::remove(file);
+    }
+    END
+
+    TEST(config_set, parallel_errors) {
+        for (auto&& special : {
+                    std::make_pair(std::make_pair(1500, "bad line"s), std::make_pair(9000, "key1=dup"s)),
+                    std::make_pair(std::make_pair(9000, "bad line"s), std::make_pair(1500, "key1=dup"s)),
+                    std::make_pair(std::make_pair(11999, "key1=dup"s), std::make_pair(11998, "key2=dup"s)),
+                    std::make_pair(std::make_pair(6000, "x='unclosed"s), std::make_pair(6001, "y=bad-value"s)),
+             }) {
+            auto file = generate_config("generated.confy", 12000, {special.first, special.second});
+            auto seq_err = error_of(file, 1);
+            EXPECT_FALSE(seq_err.empty());
+            EXPECT_EQ(error_of(file, 8), seq_err);
+            std::filesystem::remove(file);
+        }
+    }
+    END
+
+    TEST(config_set, lazy_values) {
+        EXPECT_TRUE(is_lazy_parser<confy_parser>::value);
+        EXPECT_FALSE(is_lazy_parser<copying_parser>::value);
+
+        auto file = generate_config("generated.confy", 12000);
+        confy_set ref(file);
+        for (unsigned threads : {1u, 8u}) {
+            confy_set sut(lazy_values, file, threads);
+            EXPECT_EQ(sut.size(), ref.size());
+            for (int i = 0; i < 12000; i += 7) {
+                auto key = "key" + std::to_string(i);
+                EXPECT_EQ(sut.get<std::string>(key), ref.get<std::string>(key));
+                EXPECT_STREQ(sut.get<const char*>(key), ref.get<const char*>(key));
+            }
+            EXPECT_NO_THROW(sut.validate_all());
+            for (std::size_t i = 0; i < sut.size(); i += 13) {
+                EXPECT_EQ(sut.key_at(i), ref.key_at(i));
+                EXPECT_STREQ(sut.get<const char*>(sut.key_at(i)), ref.get<const char*>(ref.key_at(i)));
+            }
+        }
+        std::filesystem::remove(file);
+
+        // keys are still checked while loading
+        EXPECT_THROW((confy_set(lazy_values, "key_clash.confy")), const bad_key&);
+        file = generate_config("generated.confy", 12000, {{3000, "bad line"}});
+        EXPECT_THROW((confy_set(lazy_values, file)), const bad_syntax&);
+        std::filesystem::remove(file);
+
+        // parsers that cannot parse keys alone load eagerly
+        config_set<copying_parser> copying(lazy_values, "mixed.confy");
+        EXPECT_EQ(copying.get<std::string>("key"), confy_set("mixed.confy").get<std::string>("key"));
+    }
+    END
+
+    TEST(config_set, lazy_errors) {
+        auto file = generate_config("generated.confy", 12000, {{9000, "y=bad-value"}, {6000, "x='unclosed"}});
+        auto eager_err = error_of(file, 1);
+        EXPECT_FALSE(eager_err.empty());
+
+        confy_set sut(lazy_values, file, 8);
+        // values before and after the malformed ones are available
+        EXPECT_EQ(sut.get<std::string>("key1"), "value1");
+        EXPECT_EQ(sut.get<std::string>("key11990"), "quoted value 11990");
+
+        // malformed values are reported with the same error as by an eager load, on every access
+        EXPECT_EQ(message_of([&sut] { std::ignore = sut.get<std::string>("x"); }), eager_err);
+        EXPECT_EQ(message_of([&sut] { std::ignore = sut.try_get<int>("x"); }), eager_err);
+        EXPECT_FALSE(message_of([&sut] { std::ignore = sut.get<std::string>("y"); }).empty());
+
+        // bulk conversions skip them
+        auto all = sut.get_all_as<std::string>();
+        EXPECT_EQ(all.size(), sut.size());
+        EXPECT_FALSE(all.all_found());
+        EXPECT_FALSE(all.found(all.first_missing()));
+
+        // validation reports the first error of the file
+        EXPECT_EQ(message_of([&sut] { sut.validate_all(); }), eager_err);
+        confy_set fresh(lazy_values, file);
+        EXPECT_EQ(message_of([&fresh] { fresh.validate_all(); }), eager_err);
+        EXPECT_THROW(fresh.compile("generated.confyb"), const bad_syntax&);
+        EXPECT_FALSE(std::filesystem::exists("generated.confyb"));
+        std::filesystem::remove(file);
+    }
+    END
+
+    TEST(config_set, copying_parser) {
+        EXPECT_FALSE(is_view_parser<copying_parser>::value);
+
+        config_set<copying_parser> cs("mixed.confy");
+        confy_set ref("mixed.confy");
+        EXPECT_EQ(cs.size(), ref.size());
+        EXPECT_EQ(cs.get<std::string>("key"), ref.get<std::string>("key"));
+        EXPECT_THROW(config_set<copying_parser>("key_clash.confy"), const bad_key&);
+        EXPECT_THROW(config_set<copying_parser>("broken1.confy"), const bad_syntax&);
+    }
+    END
+
+    TEST(config_set, no_per_line_allocations) {
+#ifdef MEMTRACE
+        // allocations are only counted by memtrace, without it there is nothing to check
+        auto small = generate_config("generated-small.confy", 1000);
+        auto large = generate_config("generated-large.confy", 4000);
+
+        // loading a file makes the same allocations regardless of the line count
+        EXPECT_EQ(allocations_of<confy_parser>(large), allocations_of<confy_parser>(small));
+        // a stream is read into a buffer growing geometrically, which is not per line either
+        EXPECT_LE(stream_allocations_of<confy_parser>(large), stream_allocations_of<confy_parser>(small) + 4);
+        // a parser copying every line allocates for each of the 3000 additional lines
+        EXPECT_GE(allocations_of<copying_parser>(large), allocations_of<copying_parser>(small) + 3000);
+        EXPECT_GE(stream_allocations_of<copying_parser>(large), stream_allocations_of<copying_parser>(small) + 3000);
+
+        std::filesystem::remove(small);
+        std::filesystem::remove(large);
+#endif
+    }
+    END
+
+    TEST(config_set, perfect_hash_index) {
+        auto file = generate_config("generated.confy", 3000);
+        confy_set ref(file);
+        config_set<confy_parser, perfect_hash_index> sut(file);
+        EXPECT_EQ(sut.size(), ref.size());
+        for (int i = 0; i < 3000; ++i) {
+            auto key = "key" + std::to_string(i);
+            EXPECT_EQ(sut.get<std::string>(key), ref.get<std::string>(key));
+        }
+        EXPECT_THROW(std::ignore = sut.get<std::string>("key3000"), const std::out_of_range&);
+        EXPECT_THROW(std::ignore = sut.get<std::string>(""), const std::out_of_range&);
+        EXPECT_THROW((config_set<confy_parser, perfect_hash_index>("key_clash.confy")), const bad_key&);
+        std::filesystem::remove(file);
+    }
+    END
+
+    TEST(config_set, swiss_index) {
+        auto file = generate_config("generated.confy", 3000);
+        confy_set ref(file);
+        config_set<confy_parser, swiss_index> sut(file);
+        EXPECT_EQ(sut.size(), ref.size());
+        for (int i = 0; i < 3000; ++i) {
+            auto key = "key" + std::to_string(i);
+            EXPECT_EQ(sut.get<std::string>(key), ref.get<std::string>(key));
+        }
+        EXPECT_THROW(std::ignore = sut.get<std::string>("key3000"), const std::out_of_range&);
+        EXPECT_THROW((config_set<confy_parser, swiss_index>("key_clash.confy")), const bad_key&);
+        std::filesystem::remove(file);
+    }
+    END
+
+    TEST(config_set, eytzinger_index) {
+        auto file = generate_config("generated.confy", 3000);
+        confy_set ref(file);
+        config_set<confy_parser, eytzinger_index> sut(file);
+        EXPECT_EQ(sut.size(), ref.size());
+        for (int i = 0; i < 3000; ++i) {
+            auto key = "key" + std::to_string(i);
+            EXPECT_EQ(sut.get<std::string>(key), ref.get<std::string>(key));
+        }
+        EXPECT_THROW(std::ignore = sut.get<std::string>("key3000"), const std::out_of_range&);
+        std::filesystem::remove(file);
+    }
+    END
+
+    TEST(config_set, get_many) {
+        auto file = generate_config("generated.confy", 3000);
+        EXPECT_EQ(get_many_mismatches<sorted_index>(file, 3000), 0);
+        EXPECT_EQ(get_many_mismatches<perfect_hash_index>(file, 3000), 0);
+        EXPECT_EQ(get_many_mismatches<swiss_index>(file, 3000), 0);
+        EXPECT_EQ(get_many_mismatches<eytzinger_index>(file, 3000), 0);
+
+        std::filesystem::remove(file);
+
+        confy_set sut("ints.confy"s);
+        std::vector<std::string> names{"key", "key3", "key2"};
+        std::vector<std::string_view> keys(names.begin(), names.end());
+        auto res = sut.get_many<long long>(keys);
+        EXPECT_EQ(res.size(), 3u);
+        EXPECT_FALSE(res.all_found());
+        EXPECT_EQ(res.first_missing(), 1u);
+        EXPECT_TRUE(res.found(0));
+        EXPECT_FALSE(res.found(1));
+        EXPECT_TRUE(res.found(2));
+        EXPECT_EQ(res[0], 1LL);
+        EXPECT_EQ(res[2], 2LL);
+        EXPECT_EQ(res.data()[2], res[2]);
+
+        std::vector<std::string_view> none;
+        EXPECT_TRUE(sut.get_many<long long>(none).all_found());
+    }
+    END
+
+    TEST(config_set, get_all_as) {
+        std::filesystem::path file = "numbers.confy"s;
+        {
+            std::ofstream ofs(file, std::ios::binary);
+            for (int i = 0; i < 40000; ++i) {
+                ofs << "num" << (i * 7919) % 40000 << '=';
+                if (i % 5 == 0) {
+                    ofs << "word" << i << '\n';
+                } else {
+                    ofs << i << '\n';
+                }
+            }
+        }
+        EXPECT_EQ(get_all_as_mismatches<sorted_index>(file, 1), 0);
+        EXPECT_EQ(get_all_as_mismatches<sorted_index>(file, 3), 0);
+        EXPECT_EQ(get_all_as_mismatches<perfect_hash_index>(file, 2), 0);
+        EXPECT_EQ(get_all_as_mismatches<swiss_index>(file, 2), 0);
+        EXPECT_EQ(get_all_as_mismatches<eytzinger_index>(file, 2), 0);
+        std::filesystem::remove(file);
+
+        confy_set sut("ints.confy"s);
+        auto all = sut.get_all_as<long long>();
+        EXPECT_EQ(all.size(), sut.size());
+        EXPECT_TRUE(all.all_found());
+        EXPECT_EQ(std::string(sut.key_at(2)), "keybig"s);
+        EXPECT_EQ(all[0], 1LL);
+        EXPECT_EQ(all[1], 2LL);
+        EXPECT_EQ(all[2], 8589934592LL);
+        EXPECT_EQ(all.found_mask().front(), std::uint64_t{7});
+
+        auto selected = sut.get_all_as<long long>([](std::string_view key) { return key.size() > 3; });
+        EXPECT_EQ(selected.first_missing(), 0u);
+        EXPECT_TRUE(selected.found(1));
+        EXPECT_TRUE(selected.found(2));
+        EXPECT_EQ(selected[2], 8589934592LL);
+    }
+    END
+
+    TEST(config_set, compiled_image) {
+        auto file = generate_config("generated.confy", 3000);
+        EXPECT_EQ(compiled_mismatches<sorted_index>(file), 0);
+        EXPECT_EQ(compiled_mismatches<perfect_hash_index>(file), 0);
+        EXPECT_EQ(compiled_mismatches<swiss_index>(file), 0);
+        EXPECT_EQ(compiled_mismatches<eytzinger_index>(file), 0);
+        std::filesystem::remove(file);
+        EXPECT_EQ(compiled_mismatches<sorted_index>("empty1.confy"s), 0);
+
+        confy_set ints("ints.confy"s);
+        ints.compile("ints.confyb"s);
+        confy_set sut(compiled_image, "ints.confyb"s);
+        EXPECT_EQ(sut.get<long long>("keybig"), 8589934592LL);
+        EXPECT_EQ(std::string(sut.get<const char*>("key2")), "2"s);
+        EXPECT_EQ(sut.get_all_as<int>().first_missing(), sut.get_all_as<int>().npos);
+        EXPECT_THROW(std::ignore = sut.get<int>("key3"), const std::out_of_range&);
+
+        // compiling the image of an image round-trips too
+        sut.compile("ints2.confyb"s);
+        confy_set again(compiled_image, "ints2.confyb"s, true);
+        EXPECT_EQ(again.get<int>("key"), 1);
+
+        EXPECT_THROW(confy_set(compiled_image, "ints.confy"s), const std::invalid_argument&);
+        EXPECT_THROW(confy_set(compiled_image, "-invalid-"s), const std::invalid_argument&);
+        std::filesystem::remove("ints.confyb"s);
+        std::filesystem::remove("ints2.confyb"s);
+    }
+    END
+
+    TEST(config_set, carry_over) {
+        auto before = "a=1\nb=two\nc=3\ne=5\n"s;
+        auto after = "a=1\nb=2\nd=4\ne=5\nf=6\n"s;
+        for (auto diff : {diff_of<sorted_index>(before, after), diff_of<swiss_index>(before, after),
+                          diff_of<perfect_hash_index>(before, after), diff_of<eytzinger_index>(before, after)}) {
+            EXPECT_EQ(diff.unchanged, std::size_t{2});
+            EXPECT_EQ(diff.changed, std::size_t{1});
+            EXPECT_EQ(diff.added, std::size_t{2});
+            EXPECT_EQ(diff.removed, std::size_t{1});
+            EXPECT_FALSE(diff.empty());
+        }
+        EXPECT_TRUE(diff_of<sorted_index>(before, before).empty());
+        EXPECT_EQ(diff_of<sorted_index>("", after).added, std::size_t{5});
+        EXPECT_EQ(diff_of<sorted_index>(before, "").removed, std::size_t{4});
+
+        confy_set previous(source_buffer::copy_of(before), "before.confy");
+        EXPECT_EQ(previous.get<std::string>("a"), "1");
+        EXPECT_EQ(previous.get<std::string>("b"), "two");
+        EXPECT_EQ(previous.get<int>("e"), 5);
+        confy_set next(source_buffer::copy_of(after), "after.confy");
+        next.carry_over(previous);
+#ifdef MEMTRACE
+        // the conversions of the unchanged entries are not repeated
+        auto blocks = memtrace::allocated_blocks();
+        EXPECT_EQ(next.get<std::string>("a"), "1");
+        EXPECT_EQ(memtrace::allocated_blocks(), blocks);
+#endif
+        EXPECT_EQ(next.get<std::string>("a"), "1");
+        EXPECT_EQ(next.get<std::string>("b"), "2");
+        EXPECT_EQ(next.get<int>("e"), 5);
+        EXPECT_EQ(next.get<int>("d"), 4);
+
+        // lazily loaded values are compared once parsed, malformed ones count as changed
+        {
+            std::ofstream ofs("lazy-broken.confy");
+            ofs << "key=1\nkey2=b-a-d\n";
+        }
+        confy_set broken(lazy_values, "lazy-broken.confy");
+        confy_set ints("ints.confy");
+        auto diff = ints.carry_over(broken);
+        EXPECT_EQ(diff.unchanged, std::size_t{1});
+        EXPECT_EQ(diff.changed, std::size_t{1});
+        EXPECT_EQ(diff.added, std::size_t{1});
+        confy_set lazy(lazy_values, "ints.confy");
+        EXPECT_EQ(lazy.carry_over(ints).unchanged, std::size_t{3});
+        std::filesystem::remove("lazy-broken.confy");
+
+        // parsers without the view interface parse the buffer through a stream
+        config_set<copying_parser> copying(source_buffer::copy_of(after), "after.confy");
+        EXPECT_EQ(copying.get<int>("f"), 6);
+        EXPECT_THROW((config_set<copying_parser>(source_buffer::copy_of("a=1\na=2\n"), "clash.confy")), const bad_key&);
+    }
+    END
+
+    TEST(config_set, resolve) {
+        confy_set sut("ints.confy"s);
+        auto key = sut.resolve<int>("key");
+        auto big = sut.resolve<long long>("keybig");
+        auto text = sut.resolve<std::string>("key2");
+        EXPECT_EQ(*key, 1);
+        EXPECT_EQ(*big, 8589934592LL);
+        EXPECT_EQ(*text, "2");
+        EXPECT_EQ(sut.get(key), 1);
+        EXPECT_TRUE(sut.is_current(big));
+        EXPECT_EQ(key.generation(), sut.generation());
+
+        // converting the entry to other types does not invalidate the handle
+        EXPECT_EQ(sut.get<double>("key"), 1.0);
+        EXPECT_EQ(sut.get<std::string>("key"), "1");
+        EXPECT_EQ(*key, 1);
+        EXPECT_EQ(sut.get<int>("key"), 1);
+
+        EXPECT_THROW(std::ignore = sut.resolve<int>("no such key"), const std::out_of_range&);
+        EXPECT_THROW(std::ignore = sut.get(config_handle<int>()), const std::out_of_range&);
+
+        // reloading the set makes the handles stale
+        sut = confy_set("ints.confy"s);
+        EXPECT_FALSE(sut.is_current(key));
+        EXPECT_THROW(std::ignore = sut.get(key), const std::out_of_range&);
+        EXPECT_EQ(sut.get(sut.resolve<int>("key")), 1);
+    }
+    END
+
+    TEST(config_set, resolve_pins_once) {
+        confy_set sut("ints.confy"s);
+        auto key = sut.resolve<int>("key");
+        EXPECT_TRUE(&*sut.resolve<int>("key") == &*key);
+        EXPECT_TRUE(&*sut.resolve<std::string>("key") == &*sut.resolve<std::string>("key"));
+#ifdef MEMTRACE
+        auto blocks = memtrace::allocated_blocks();
+        for (int i = 0; i < 100; ++i) {
+            std::ignore = sut.resolve<int>("key");
+            std::ignore = sut.resolve<std::string>("key");
+        }
+        EXPECT_EQ(memtrace::allocated_blocks(), blocks);
+#endif
+    }
+    END
+
+    TEST(config_set, try_get) {
+        confy_set sut("mixed.confy"s);
+        EXPECT_FALSE(static_cast<bool>(sut.try_get<int>("no such key")));
+        EXPECT_FALSE(static_cast<bool>(sut.try_get<std::string>("no such key")));
+        EXPECT_TRUE(static_cast<bool>(sut.try_get<std::string>("key")));
+        EXPECT_EQ(*sut.try_get<std::string>("key"), sut.get<std::string>("key"));
+
+        confy_set ints("ints.confy"s);
+        EXPECT_EQ(*ints.try_get<int>("key2"), 2);
+        EXPECT_EQ(ints.get_or<int>("key2", 42), 2);
+        EXPECT_EQ(ints.get_or<int>("no such key", 42), 42);
+        EXPECT_EQ(ints.get_or<std::string>("no such key", "fallback"), "fallback");
+
+        // values that cannot be converted are misses as well
+        EXPECT_EQ(*sut.try_get<std::string>("key"), sut.get<std::string>("key"));
+        EXPECT_FALSE(static_cast<bool>(sut.try_get<int>("key")));
+        EXPECT_EQ(sut.get_or<double>("key", 0.5), 0.5);
+        EXPECT_THROW(std::ignore = sut.get<int>("key"), const std::invalid_argument&);
+
+#ifdef MEMTRACE
+        // misses do not allocate
+        auto before = memtrace::allocated_blocks();
+        EXPECT_EQ(ints.get_or<int>("no such key", 42), 42);
+        EXPECT_EQ(memtrace::allocated_blocks(), before);
+#endif
+    }
+    END
+
+    TEST(config_set, inline_cache) {
+        confy_set sut("ints.confy"s);
+#ifdef MEMTRACE
+        // the first conversion of an entry to a built-in type does not allocate
+        auto before = memtrace::allocated_blocks();
+#endif
+        EXPECT_EQ(sut.get<int>("key"), 1);
+        EXPECT_EQ(sut.get<int>("key"), 1);
+        EXPECT_EQ(sut.get<long long>("keybig"), 8589934592LL);
+        EXPECT_EQ(sut.get<bool>("key2"), true);
+#ifdef MEMTRACE
+        EXPECT_EQ(memtrace::allocated_blocks(), before);
+#endif
+        // further types move the conversions of the entry into a single table
+        EXPECT_DOUBLE_EQ(sut.get<double>("key"), 1.0);
+        EXPECT_EQ(sut.get<int>("key"), 1);
+        EXPECT_EQ(sut.get<unsigned char>("key2"), 2);
+        EXPECT_EQ(sut.get<long>("keybig"), 8589934592L);
+#ifdef MEMTRACE
+        auto spilled = memtrace::allocated_blocks();
+        EXPECT_EQ(spilled, before + 3);
+#endif
+
+        // alternating between types is served from the cache
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_EQ(sut.get<long>("keybig"), 8589934592L);
+            EXPECT_DOUBLE_EQ(sut.get<double>("keybig"), 8589934592.0);
+        }
+#ifdef MEMTRACE
+        EXPECT_EQ(memtrace::allocated_blocks(), spilled);
+#endif
+    }
+    END
 }
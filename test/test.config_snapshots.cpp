@@ -0,0 +1,207 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.config_snapshots.cpp
+ * \brief Test functions for the config_snapshots class
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bad_syntax.hpp"
+#include "config_snapshots.hpp"
+#include "confy_parser.hpp"
+#include "source_buffer.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+namespace {
+    using confy_set = config_set<confy_parser>;
+
+    /**
+     * \brief Loads a version of a configuration from a string
+     *
+     * \param contents The contents of the configuration
+     * \return The loaded set
+     */
+    std::unique_ptr<confy_set>
+    version_of(const std::string& contents) {
+        return std::make_unique<confy_set>(source_buffer::copy_of(contents), "snapshot.confy");
+    }
+
+    /**
+     * \brief Loads a version where two keys hold the same number
+     *
+     * \param n The number of the version
+     * \return The loaded set
+     */
+    std::unique_ptr<confy_set>
+    numbered(int n) {
+        return version_of("first=" + std::to_string(n) + "\nlast=" + std::to_string(n) + "\n");
+    }
+
+    /**
+     * \brief Checks whether a type provides the caching get accessor
+     *
+     * \tparam S The type to check
+     */
+    template<class S, class = void>
+    struct has_get : std::false_type { };
+
+    template<class S>
+    struct has_get<S, decltype(void(std::declval<const S&>().template get<int>("key")))> : std::true_type { };
+}
+
+void
+test_config_snapshots() {
+    using confy_snapshots = config_snapshots<confy_parser>;
+
+    TEST(config_set, read) {
+        confy_set sut("ints.confy"s);
+        EXPECT_EQ(*sut.read<int>("key"), 1);
+        EXPECT_EQ(*sut.read<std::string>("key2"), "2");
+        EXPECT_FALSE(static_cast<bool>(sut.read<int>("no such key")));
+        EXPECT_FALSE(static_cast<bool>(confy_set("mixed.confy"s).read<int>("key")));
+#ifdef MEMTRACE
+        // reading does not cache, the conversions are repeated
+        auto blocks = memtrace::allocated_blocks();
+        EXPECT_EQ(*sut.read<std::string>("key2"), "2");
+        EXPECT_EQ(memtrace::allocated_blocks(), blocks);
+#endif
+        // but the conversions cached before are used
+        EXPECT_EQ(sut.get<std::string>("key2"), "2");
+        EXPECT_EQ(*sut.read<std::string>("key2"), "2");
+
+        confy_set lazy(lazy_values, "ints.confy"s);
+        EXPECT_THROW(std::ignore = lazy.read<int>("key"), const std::logic_error&);
+        lazy.validate_all();
+        EXPECT_EQ(*lazy.read<int>("key"), 1);
+    }
+    END
+
+    TEST(config_snapshots, publish) {
+        confy_snapshots sut(numbered(0));
+        EXPECT_EQ(sut.version(), std::uint64_t{0});
+        auto first = sut.current();
+        EXPECT_EQ(*first.read<int>("first"), 0);
+
+        sut.publish(numbered(1));
+        EXPECT_EQ(sut.version(), std::uint64_t{1});
+        EXPECT_EQ(*sut.current().read<int>("first"), 1);
+        // the replaced version lives as long as it is referred to
+        EXPECT_EQ(*first.read<int>("last"), 0);
+    }
+    END
+
+    TEST(config_snapshots, lazy) {
+        std::ofstream("snapshot-lazy.confy"s) << "key=1\nbad='unclosed\n";
+        confy_snapshots sut(numbered(0));
+        EXPECT_THROW(sut.publish(std::make_unique<confy_set>(lazy_values, "snapshot-lazy.confy"s)), const bad_syntax&);
+        EXPECT_EQ(sut.version(), std::uint64_t{0});
+        EXPECT_EQ(*sut.current().read<int>("first"), 0);
+
+        std::ofstream("snapshot-lazy.confy"s) << "key=1\n";
+        sut.publish(std::make_unique<confy_set>(lazy_values, "snapshot-lazy.confy"s));
+        EXPECT_EQ(*sut.current().read<int>("key"), 1);
+        std::filesystem::remove("snapshot-lazy.confy"s);
+    }
+    END
+
+    TEST(config_snapshots, reader) {
+        confy_snapshots sut(numbered(0));
+        confy_snapshots::reader rd(sut);
+        auto first = rd.current().key_at(0).data();
+        EXPECT_EQ(*rd.current().read<int>("first"), 0);
+        EXPECT_TRUE(rd.current().key_at(0).data() == first);
+
+        sut.publish(numbered(1));
+        EXPECT_EQ(*rd.current().read<int>("first"), 1);
+        EXPECT_FALSE(rd.current().key_at(0).data() == first);
+    }
+    END
+
+    TEST(config_snapshots, read_only) {
+        // readers cannot reach the accessors filling the caches of the shared set
+        EXPECT_FALSE(has_get<confy_snapshots::snapshot>::value);
+        EXPECT_TRUE(has_get<confy_set>::value);
+
+        confy_snapshots sut(numbered(0));
+        auto snap = sut.current();
+        EXPECT_EQ(snap.size(), std::size_t{2});
+        EXPECT_TRUE(snap.key_at(0) == "first");
+        EXPECT_TRUE(snap.key_at(1) == "last");
+        EXPECT_FALSE(static_cast<bool>(snap.read<int>("no such key")));
+    }
+    END
+
+    TEST(config_snapshots, concurrent) {
+        confy_snapshots sut(numbered(0));
+        std::atomic<bool> done{false};
+        std::atomic<int> torn{0};
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; ++i) {
+            readers.emplace_back([&sut, &done, &torn] {
+                confy_snapshots::reader rd(sut);
+                int last = 0;
+                while (!done.load()) {
+                    auto&& cur = rd.current();
+                    auto first = *cur.read<int>("first");
+                    // every version is consistent, and versions never go back
+                    if (first != *cur.read<int>("last") || first < last) ++torn;
+                    last = first;
+                }
+            });
+        }
+        for (int n = 1; n <= 50; ++n) sut.publish(numbered(n));
+        done = true;
+        for (auto& rd : readers) rd.join();
+        EXPECT_EQ(torn.load(), 0);
+        EXPECT_EQ(*sut.current().read<int>("last"), 50);
+    }
+    END
+}
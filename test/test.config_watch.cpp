@@ -0,0 +1,216 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.config_watch.cpp
+ * \brief Test functions for the config_watch and file_watch classes
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "bad_syntax.hpp"
+#include "config_watch.hpp"
+#include "confy_parser.hpp"
+#include "file_watch.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+namespace {
+    /// The longest time a test waits for a change to be noticed
+    constexpr auto reload_timeout = std::chrono::milliseconds(5000);
+
+    /**
+     * \brief Overwrites a file in place
+     *
+     * \param file The file to write
+     * \param contents The new contents of the file
+     */
+    void
+    rewrite(const std::filesystem::path& file, const std::string& contents) {
+        std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+        ofs << contents;
+    }
+
+    /**
+     * \brief Replaces a file atomically, like deployment tools do
+     *
+     * Writes the new contents next to the file, then renames them over it.
+     *
+     * \param file The file to replace
+     * \param contents The new contents of the file
+     */
+    void
+    replace(const std::filesystem::path& file, const std::string& contents) {
+        auto next = file;
+        next += ".next";
+        rewrite(next, contents);
+        std::filesystem::rename(next, file);
+    }
+
+    /**
+     * \brief A watch that fails shortly after it starts waiting
+     */
+    struct failing_watch {
+        explicit failing_watch(const std::filesystem::path&) { }
+
+        bool
+        wait() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            throw std::system_error(std::make_error_code(std::errc::io_error), "cannot watch");
+        }
+
+        void
+        stop() noexcept { }
+    };
+}
+
+void
+test_config_watch() {
+    using confy_watch = config_watch<confy_parser>;
+
+    auto dir = std::filesystem::temp_directory_path() / "confy-test-watch";
+    std::filesystem::create_directories(dir);
+    auto file = dir / "watched.confy";
+
+    TEST(file_watch, stop) {
+        rewrite(file, "key=1\n");
+        file_watch sut(file);
+        std::thread stopper([&sut] { sut.stop(); });
+        EXPECT_FALSE(sut.wait());
+        stopper.join();
+        EXPECT_FALSE(sut.wait());
+
+        EXPECT_THROW(file_watch(dir / "no such directory" / "watched.confy"), const std::invalid_argument&);
+    }
+    END
+
+    TEST(file_watch, changes) {
+        rewrite(file, "key=1\n");
+        file_watch sut(file);
+        rewrite(file, "key=2\n");
+        EXPECT_TRUE(sut.wait());
+        replace(file, "key=3\n");
+        EXPECT_TRUE(sut.wait());
+
+        // other files of the directory are not reported
+        rewrite(dir / "other.confy", "key=1\n");
+        std::thread stopper([&sut] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            sut.stop();
+        });
+        EXPECT_FALSE(sut.wait());
+        stopper.join();
+    }
+    END
+
+    TEST(config_watch, replaced) {
+        rewrite(file, "a=1\nb=2\nc=3\n");
+        confy_watch sut(file);
+        EXPECT_EQ(sut.current().get<int>("b"), 2);
+        EXPECT_FALSE(static_cast<bool>(sut.refresh()));
+
+        replace(file, "a=1\nb=20\nd=4\n");
+        EXPECT_TRUE(sut.wait_for_reload(reload_timeout));
+        // the installed set is only replaced by refresh
+        EXPECT_EQ(sut.current().get<int>("b"), 2);
+
+        auto diff = sut.refresh();
+        EXPECT_TRUE(static_cast<bool>(diff));
+        EXPECT_EQ(diff->unchanged, std::size_t{1});
+        EXPECT_EQ(diff->changed, std::size_t{1});
+        EXPECT_EQ(diff->added, std::size_t{1});
+        EXPECT_EQ(diff->removed, std::size_t{1});
+        EXPECT_EQ(sut.current().get<int>("a"), 1);
+        EXPECT_EQ(sut.current().get<int>("b"), 20);
+        EXPECT_EQ(sut.current().get<int>("d"), 4);
+        EXPECT_THROW(std::ignore = sut.current().get<int>("c"), const std::out_of_range&);
+        EXPECT_FALSE(static_cast<bool>(sut.refresh()));
+    }
+    END
+
+    TEST(config_watch, rewritten) {
+        rewrite(file, "key='a long value, longer than what is written later'\n");
+        confy_watch sut(file);
+        rewrite(file, "key=1\n");
+        EXPECT_TRUE(sut.wait_for_reload(reload_timeout));
+        // the installed set was read, so truncating the file does not affect it
+        EXPECT_EQ(sut.current().get<std::string>("key"), "a long value, longer than what is written later");
+        EXPECT_TRUE(static_cast<bool>(sut.refresh()));
+        EXPECT_EQ(sut.current().get<int>("key"), 1);
+    }
+    END
+
+    TEST(config_watch, broken) {
+        rewrite(file, "key=1\n");
+        EXPECT_THROW(confy_watch(dir / "no such file.confy"), const std::invalid_argument&);
+
+        confy_watch sut(file);
+        replace(file, "key=1\nbroken line\n");
+        EXPECT_TRUE(sut.wait_for_reload(reload_timeout));
+        EXPECT_THROW(sut.refresh(), const bad_syntax&);
+        EXPECT_EQ(sut.current().get<int>("key"), 1);
+        EXPECT_FALSE(static_cast<bool>(sut.refresh()));
+
+        replace(file, "key=2\n");
+        EXPECT_TRUE(sut.wait_for_reload(reload_timeout));
+        EXPECT_TRUE(static_cast<bool>(sut.refresh()));
+        EXPECT_EQ(sut.current().get<int>("key"), 2);
+    }
+    END
+
+    TEST(config_watch, watch_failed) {
+        rewrite(file, "key=1\n");
+        config_watch<confy_parser, sorted_index, failing_watch> sut(file);
+        // the failure wakes the waiting thread, instead of leaving it to the timeout
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(sut.wait_for_reload(reload_timeout));
+        EXPECT_TRUE(std::chrono::steady_clock::now() - start < reload_timeout);
+        EXPECT_THROW(sut.refresh(), const std::system_error&);
+        EXPECT_EQ(sut.current().get<int>("key"), 1);
+        EXPECT_FALSE(static_cast<bool>(sut.refresh()));
+    }
+    END
+
+    std::filesystem::remove_all(dir);
+}
@@ -39,6 +39,7 @@
 #include <tuple>
 
 #include "confy_parser.hpp"
+#include "parser.hpp"
 
 using namespace std::literals;
 
@@ -53,6 +54,12 @@ test_confy_parser() {
     }
     END
 
+    TEST(confy_parser, view_parser) {
+        EXPECT_TRUE(is_view_parser<confy_parser>::value);
+        EXPECT_FALSE(is_view_parser<std::string>::value);
+    }
+    END
+
     TEST(confy_parser, null_lines) {
         confy_parser cf("test-file");
         for (auto&& inp : {""s, "\n\n\n"s, "#comment\n#comm"s}) {
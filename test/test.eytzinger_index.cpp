@@ -0,0 +1,116 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.eytzinger_index.cpp
+ * \brief Test functions for the eytzinger_index class
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "eytzinger_index.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+void
+test_eytzinger_index() {
+    TEST(eytzinger_index, prefix_of) {
+        EXPECT_EQ(eytzinger_index::prefix_of(""), std::uint64_t{0});
+        EXPECT_EQ(eytzinger_index::prefix_of("a"), std::uint64_t{0x61} << 56);
+        EXPECT_EQ(eytzinger_index::prefix_of("abcdefgh"), eytzinger_index::prefix_of("abcdefghijk"));
+        EXPECT_TRUE(eytzinger_index::prefix_of("ab") < eytzinger_index::prefix_of("abc"));
+        EXPECT_TRUE(eytzinger_index::prefix_of("abz") < eytzinger_index::prefix_of("ac"));
+    }
+    END
+
+    TEST(eytzinger_index, empty) {
+        eytzinger_index sut;
+        auto key_at = [](std::size_t) { return std::string_view(); };
+        EXPECT_EQ(sut.find("key", key_at), eytzinger_index::npos);
+        EXPECT_TRUE(sut.build(0, key_at).empty());
+        EXPECT_EQ(sut.find("key", key_at), eytzinger_index::npos);
+        EXPECT_EQ(sut.find("", key_at), eytzinger_index::npos);
+    }
+    END
+
+    TEST(eytzinger_index, find) {
+        // many keys share their 8 byte prefixes, to exercise the full key comparisons
+        std::vector<std::string> keys;
+        for (int i = 0; i < 3000; ++i) {
+            keys.push_back("k" + std::to_string(i));
+            keys.push_back("long_key" + std::to_string(i));
+            keys.push_back("long_kez" + std::to_string(i));
+        }
+        std::sort(keys.begin(), keys.end());
+        auto key_at = [&keys](std::size_t idx) { return std::string_view(keys[idx]); };
+
+        eytzinger_index sut;
+        EXPECT_TRUE(sut.build(keys.size(), key_at).empty());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(sut.find(keys[i], key_at), i);
+        }
+        for (auto&& absent : {""s, "a"s, "k"s, "k3000"s, "long_key"s, "long_key3000"s, "long_kez"s, "long_kez00"s, "long_kf"s, "zzz"s}) {
+            EXPECT_EQ(sut.find(absent, key_at), eytzinger_index::npos);
+        }
+        EXPECT_EQ(sut.memory_usage(), (keys.size() + 1) * 12);
+    }
+    END
+
+    TEST(eytzinger_index, common_prefix) {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 1000; ++i) keys.push_back("application_setting_" + std::to_string(i));
+        keys.push_back("application_setting_");
+        std::sort(keys.begin(), keys.end());
+        auto key_at = [&keys](std::size_t idx) { return std::string_view(keys[idx]); };
+
+        eytzinger_index sut;
+        sut.build(keys.size(), key_at);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(sut.find(keys[i], key_at), i);
+        }
+        for (auto&& absent : {""s, "application"s, "application_settinf_1"s, "application_setting_1000"s, "b"s}) {
+            EXPECT_EQ(sut.find(absent, key_at), eytzinger_index::npos);
+        }
+    }
+    END
+}
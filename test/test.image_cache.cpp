@@ -0,0 +1,193 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.image_cache.cpp
+ * \brief Test functions for the image_cache class
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#include "config_set.hpp"
+#include "confy_parser.hpp"
+#include "image_cache.hpp"
+#include "source_buffer.hpp"
+
+using namespace std::literals;
+
+#include "scoped_env.hpp"
+#include "gtest_lite.h"
+
+namespace {
+    /**
+     * \brief Overwrites a configuration file
+     *
+     * \param file The file to write
+     * \param contents The new contents of the file
+     * \param age How long ago the file is to be modified, by its modification time
+     */
+    void
+    write_config(const std::filesystem::path& file, const std::string& contents, std::chrono::minutes age) {
+        {
+            std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+            ofs << contents;
+        }
+        std::filesystem::last_write_time(file, std::filesystem::file_time_type::clock::now() - age);
+    }
+
+    /**
+     * \brief Loads a file through its cache, like the user modes do
+     *
+     * \param file The configuration file
+     * \param hit Set to whether the cached image was fresh
+     * \return The value of the key "key"
+     */
+    std::string
+    load_cached(const std::filesystem::path& file, bool& hit) {
+        image_cache cache(file);
+        source_buffer src;
+        hit = cache.fresh() || cache.fresh((src = source_buffer(file)).view());
+        if (hit) {
+            config_set<confy_parser> conf(compiled_image, cache.image());
+            cache.store(conf);
+            return conf.get<std::string>("key");
+        }
+        config_set<confy_parser> conf(std::move(src), file);
+        cache.store(conf);
+        return conf.get<std::string>("key");
+    }
+}
+
+void
+test_image_cache() {
+    auto dir = std::filesystem::temp_directory_path() / "confy-test-cache";
+
+    TEST(image_cache, directory) {
+        with_env("CONFY_NO_CACHE", nullptr, [&dir] {
+            with_env("XDG_CACHE_HOME", dir.string().c_str(), [&dir] {
+                EXPECT_EQ(image_cache::directory().string(), (dir / "confy").string());
+                EXPECT_TRUE(image_cache("ints.confy").enabled());
+                EXPECT_EQ(image_cache("ints.confy").image().parent_path().string(), (dir / "confy").string());
+                EXPECT_EQ(image_cache("ints.confy").image().string(), image_cache("./ints.confy").image().string());
+                EXPECT_NE(image_cache("ints.confy").image().string(), image_cache("mixed.confy").image().string());
+            });
+            with_env("XDG_CACHE_HOME", "relative", [] {
+                with_env("HOME", "/home/someone", [] {
+                    EXPECT_EQ(image_cache::directory().string(), "/home/someone/.cache/confy"s);
+                });
+                with_env("HOME", nullptr, [] {
+                    EXPECT_TRUE(image_cache::directory().empty());
+                    EXPECT_FALSE(image_cache("ints.confy").enabled());
+                    EXPECT_FALSE(image_cache("ints.confy").fresh());
+                });
+            });
+        });
+        with_env("CONFY_NO_CACHE", "1", [&dir] {
+            with_env("XDG_CACHE_HOME", dir.string().c_str(), [] {
+                EXPECT_TRUE(image_cache::directory().empty());
+            });
+        });
+    }
+    END
+
+    TEST(image_cache, freshness) {
+        with_env("CONFY_NO_CACHE", nullptr, [&dir] {
+            with_env("XDG_CACHE_HOME", dir.string().c_str(), [] {
+                std::filesystem::path file = "cached.confy";
+                bool hit;
+                write_config(file, "key=1\n", 60min);
+                EXPECT_EQ(load_cached(file, hit), "1"s);
+                EXPECT_FALSE(hit);
+                EXPECT_TRUE(std::filesystem::exists(image_cache(file).image()));
+                EXPECT_EQ(load_cached(file, hit), "1"s);
+                EXPECT_TRUE(hit);
+
+                // an unchanged image is not rewritten
+                auto image = image_cache(file).image();
+                auto written = std::filesystem::last_write_time(image);
+                EXPECT_EQ(load_cached(file, hit), "1"s);
+                EXPECT_TRUE(written == std::filesystem::last_write_time(image));
+
+                // a touched file is hashed, and recorded again
+                write_config(file, "key=1\n", 30min);
+                {
+                    // the contents are compared from the buffer given, not read by the cache
+                    image_cache cache(file);
+                    EXPECT_FALSE(cache.fresh());
+                    EXPECT_FALSE(cache.fresh("key=2\n"));
+                    EXPECT_FALSE(cache.fresh());
+                    EXPECT_TRUE(cache.fresh("key=1\n"));
+                    cache.reject();
+                    EXPECT_FALSE(cache.fresh("key=1\n"));
+                }
+                EXPECT_EQ(load_cached(file, hit), "1"s);
+                EXPECT_TRUE(hit);
+                image_source source;
+                EXPECT_TRUE(read_image_source(image, source));
+                EXPECT_TRUE(source.mtime == std::filesystem::last_write_time(file).time_since_epoch().count());
+
+                write_config(file, "key=22\n", 30min);
+                EXPECT_EQ(load_cached(file, hit), "22"s);
+                EXPECT_FALSE(hit);
+
+                // a file changed right after it was cached may keep its modification time
+                write_config(file, "key=33\n", 0min);
+                EXPECT_EQ(load_cached(file, hit), "33"s);
+                EXPECT_FALSE(hit);
+                auto mtime = std::filesystem::last_write_time(file);
+                {
+                    std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+                    ofs << "key=44\n";
+                }
+                std::filesystem::last_write_time(file, mtime);
+                EXPECT_EQ(load_cached(file, hit), "44"s);
+                EXPECT_FALSE(hit);
+                EXPECT_EQ(load_cached(file, hit), "44"s);
+                EXPECT_TRUE(hit);
+
+                std::filesystem::remove(file);
+                EXPECT_FALSE(image_cache(file).fresh());
+                std::filesystem::remove(image);
+            });
+        });
+        std::filesystem::remove_all(dir);
+    }
+    END
+}
@@ -0,0 +1,140 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.inline_cache.cpp
+ * \brief Test functions for the inline_cache class
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <algorithm>
+#include <string>
+
+#include "inline_cache.hpp"
+
+#include "gtest_lite.h"
+
+void
+test_inline_cache() {
+    TEST(inline_cache, holds) {
+        EXPECT_TRUE(inline_cache::holds<int>());
+        EXPECT_TRUE(inline_cache::holds<bool>());
+        EXPECT_TRUE(inline_cache::holds<double>());
+        EXPECT_EQ(inline_cache::holds<long double>(), sizeof(long double) <= sizeof(long long));
+        EXPECT_TRUE(inline_cache::builtin<long double>());
+        EXPECT_FALSE(inline_cache::holds<std::string>());
+        EXPECT_FALSE(inline_cache::builtin<std::string>());
+        EXPECT_FALSE(inline_cache::holds<const char*>());
+    }
+    END
+
+    TEST(inline_cache, empty) {
+        inline_cache sut;
+        int value = 0;
+        EXPECT_TRUE(sut.empty());
+        EXPECT_FALSE(sut.get(value));
+    }
+    END
+
+    TEST(inline_cache, store) {
+        inline_cache sut;
+        sut.store(42);
+        EXPECT_FALSE(sut.empty());
+
+        int value = 0;
+        EXPECT_TRUE(sut.get(value));
+        EXPECT_EQ(value, 42);
+
+        // only the stored type hits
+        long same_size = 0;
+        unsigned same_bits = 0;
+        EXPECT_FALSE(sut.get(same_size));
+        EXPECT_FALSE(sut.get(same_bits));
+    }
+    END
+
+    TEST(inline_cache, replace) {
+        inline_cache sut;
+        sut.store(42);
+        sut.store(4.2);
+
+        int value = 0;
+        double replaced = 0;
+        EXPECT_FALSE(sut.get(value));
+        EXPECT_TRUE(sut.get(replaced));
+        EXPECT_DOUBLE_EQ(replaced, 4.2);
+    }
+    END
+
+    TEST(inline_cache, table) {
+        inline_cache sut;
+        EXPECT_TRUE(sut.table() == nullptr);
+        sut.store(42);
+        EXPECT_TRUE(sut.table() == nullptr);
+
+        // the table takes the place of the value
+        auto table = reinterpret_cast<cache_table*>(&sut);
+        sut.spill(table);
+        int value = 0;
+        EXPECT_TRUE(sut.table() == table);
+        EXPECT_FALSE(sut.empty());
+        EXPECT_FALSE(sut.get(value));
+    }
+    END
+
+    TEST(inline_cache, visit) {
+        inline_cache sut;
+        int visited = 0;
+        auto count = [&visited](const auto&) { ++visited; };
+        EXPECT_FALSE(sut.visit(count));
+
+        sut.store(4.2);
+        double value = 0;
+        EXPECT_TRUE(sut.visit([&value](const auto& stored) {
+            value = static_cast<double>(stored);
+        }));
+        EXPECT_DOUBLE_EQ(value, 4.2);
+        EXPECT_TRUE(sut.visit(count));
+        EXPECT_EQ(visited, 1);
+    }
+    END
+
+    TEST(inline_cache, size) {
+        // a single small value, so every config entry stays small
+        EXPECT_EQ(sizeof(inline_cache), std::max(sizeof(long long), sizeof(void*)) + 1);
+    }
+    END
+}
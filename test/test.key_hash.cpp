@@ -0,0 +1,70 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.key_hash.cpp
+ * \brief Test functions for the key hash functions
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <cstdint>
+#include <string>
+
+#include "key_hash.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+void
+test_key_hash() {
+    TEST(key_hash, hash_key) {
+        EXPECT_EQ(hash_key("some key"), hash_key("some key"s));
+        EXPECT_NE(hash_key("some key"), hash_key("some kez"));
+        EXPECT_NE(hash_key("a rather long key, read in words"), hash_key("a rather long key, read in wordz"));
+        EXPECT_NE(hash_key("key"), hash_key(std::string("key\0", 4)));
+        EXPECT_NE(hash_key(""), hash_key("a"));
+    }
+    END
+
+    TEST(key_hash, rehash_key) {
+        auto h = hash_key("key");
+        EXPECT_EQ(rehash_key(h, 1), rehash_key(h, 1));
+        EXPECT_NE(rehash_key(h, 0), rehash_key(h, 1));
+        EXPECT_NE(rehash_key(h, 0), h);
+    }
+    END
+}
@@ -0,0 +1,383 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.parse_number.cpp
+ * \brief Test functions for the number parsing functions
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "parse_number.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+namespace {
+    std::string
+    random_decimal(std::mt19937& rng) {
+        std::uniform_int_distribution<int> digit(0, 9);
+        std::uniform_int_distribution<int> length(1, 22);
+        std::uniform_int_distribution<int> exponent(-45, 45);
+        std::string ret;
+        auto len = length(rng);
+        auto point = std::uniform_int_distribution<int>(0, len)(rng);
+        for (int i = 0; i < len; ++i) {
+            if (i == point) ret += '.';
+            ret += static_cast<char>('0' + digit(rng));
+        }
+        if (rng() % 2) ret += 'e' + std::to_string(exponent(rng));
+        return ret;
+    }
+
+    std::string
+    random_printed(std::mt19937_64& rng) {
+        double value;
+        do {
+            auto bits = rng();
+            std::memcpy(&value, &bits, sizeof value);
+        } while (!std::isfinite(value));
+        char buf[64];
+        std::snprintf(buf, sizeof buf, "%.*g", static_cast<int>(rng() % 17 + 1), std::fabs(value));
+        return buf;
+    }
+
+    template<class T>
+    T
+    strto(const char* str) {
+        char* end;
+        if (std::is_same<T, float>::value) return static_cast<T>(std::strtof(str, &end));
+        if (std::is_same<T, double>::value) return static_cast<T>(std::strtod(str, &end));
+        return static_cast<T>(std::strtold(str, &end));
+    }
+
+    template<class T>
+    int
+    rounding_mismatches() {
+        std::mt19937 rng(42);
+        std::mt19937_64 rng64(42);
+        int mismatches = 0;
+        for (int i = 0; i < 40000; ++i) {
+            auto str = i % 2 ? random_decimal(rng) : random_printed(rng64);
+            T value{};
+            if (!parse_floating(str, value) || value != strto<T>(str.c_str())) ++mismatches;
+        }
+        return mismatches;
+    }
+}
+
+void
+test_parse_number() {
+    TEST(parse_number, integer) {
+        int value = 0;
+        EXPECT_TRUE(parse_integer(std::string("42"), value));
+        EXPECT_EQ(42, value);
+        EXPECT_TRUE(parse_integer(std::string(" \t+17"), value));
+        EXPECT_EQ(17, value);
+        EXPECT_TRUE(parse_integer(std::string("-8rest"), value));
+        EXPECT_EQ(-8, value);
+    }
+    END
+
+    TEST(parse_number, integer_prefixes) {
+        int value = 0;
+        EXPECT_TRUE(parse_integer(std::string("0x10"), value));
+        EXPECT_EQ(16, value);
+        EXPECT_TRUE(parse_integer(std::string("-0XfF"), value));
+        EXPECT_EQ(-255, value);
+        EXPECT_TRUE(parse_integer(std::string("0o17"), value));
+        EXPECT_EQ(15, value);
+        EXPECT_TRUE(parse_integer(std::string("+0b101"), value));
+        EXPECT_EQ(5, value);
+        EXPECT_TRUE(parse_integer(std::string("0b102"), value));
+        EXPECT_EQ(2, value);
+        EXPECT_TRUE(parse_integer(std::string("017"), value)); // no C-style octal
+        EXPECT_EQ(17, value);
+        EXPECT_TRUE(parse_integer(std::string("0xg"), value));
+        EXPECT_EQ(0, value);
+        EXPECT_TRUE(parse_integer(std::string("0b"), value));
+        EXPECT_EQ(0, value);
+
+        unsigned char uc = 0;
+        EXPECT_TRUE(parse_integer(std::string("0x1FF"), uc));
+        EXPECT_EQ(std::numeric_limits<unsigned char>::max(), uc);
+        unsigned long long ull = 0;
+        EXPECT_TRUE(parse_integer(std::string("0xFFFFFFFFFFFFFFFF"), ull));
+        EXPECT_EQ(std::numeric_limits<unsigned long long>::max(), ull);
+        EXPECT_TRUE(parse_integer(std::string("0x10000000000000000"), ull));
+        EXPECT_EQ(std::numeric_limits<unsigned long long>::max(), ull);
+    }
+    END
+
+    TEST(parse_number, integer_unsigned_negative) {
+        // unsigned short keeps clamping negatives to 0, like the strtol it used to be parsed with
+        unsigned short us = 1;
+        EXPECT_TRUE(parse_integer(std::string("-1"), us));
+        EXPECT_EQ(0, static_cast<int>(us));
+        us = 1;
+        EXPECT_TRUE(parse_integer(std::string("-70000"), us));
+        EXPECT_EQ(0, static_cast<int>(us));
+        EXPECT_TRUE(parse_integer(std::string("70000"), us));
+        EXPECT_EQ(static_cast<int>(std::numeric_limits<unsigned short>::max()), static_cast<int>(us));
+        EXPECT_TRUE(parse_integer(std::string("-99999999999999999999"), us));
+        EXPECT_EQ(0, static_cast<int>(us));
+
+        // the types parsed with the strtoul family keep wrapping
+        unsigned u = 0;
+        EXPECT_TRUE(parse_integer(std::string("-1"), u));
+        EXPECT_EQ(std::numeric_limits<unsigned>::max(), u);
+        unsigned char uc = 0;
+        EXPECT_TRUE(parse_integer(std::string("-1"), uc));
+        EXPECT_EQ(static_cast<int>(std::numeric_limits<unsigned char>::max()), static_cast<int>(uc));
+    }
+    END
+
+    TEST(parse_number, decode_hex_fixed) {
+        std::uint32_t value = 0;
+        EXPECT_TRUE(decode_hex_fixed("A9B2D6", 6, value));
+        EXPECT_EQ(std::uint32_t(0xA9B2D6), value);
+        EXPECT_TRUE(decode_hex_fixed("ff7a93c0", 8, value));
+        EXPECT_EQ(std::uint32_t(0xFF7A93C0), value);
+        EXPECT_TRUE(decode_hex_fixed("0123456789", 8, value));
+        EXPECT_EQ(std::uint32_t(0x01234567), value);
+        EXPECT_TRUE(decode_hex_fixed("f", 1, value));
+        EXPECT_EQ(std::uint32_t(0xF), value);
+
+        value = 42;
+        EXPECT_FALSE(decode_hex_fixed("A9B2DG", 6, value));
+        EXPECT_FALSE(decode_hex_fixed("A9B2D:", 6, value));
+        EXPECT_FALSE(decode_hex_fixed("@9B2D6", 6, value));
+        EXPECT_FALSE(decode_hex_fixed("`9B2D6", 6, value));
+        EXPECT_FALSE(decode_hex_fixed("\x10" "9B2D6", 6, value)); // a digit only with the case bit set
+        EXPECT_FALSE(decode_hex_fixed("\xC1" "9B2D6", 6, value));
+        EXPECT_FALSE(decode_hex_fixed(" 9B2D6", 6, value));
+        EXPECT_FALSE(decode_hex_fixed("", 0, value));
+        EXPECT_FALSE(decode_hex_fixed("123456789", 9, value));
+        EXPECT_EQ(std::uint32_t(42), value);
+
+        // all single digits, in every position
+        const std::string digits = "0123456789abcdefABCDEF";
+        int mismatches = 0;
+        for (std::size_t pos = 0; pos < 8; ++pos) {
+            for (auto c : digits) {
+                std::string str(8, '0');
+                str[pos] = c;
+                auto expected = std::uint32_t(std::stoul(str, nullptr, 16));
+                if (!decode_hex_fixed(str.data(), 8, value) || value != expected) ++mismatches;
+            }
+        }
+        EXPECT_EQ(0, mismatches);
+        // and every other byte rejected
+        for (int c = 0; c < 256; ++c) {
+            std::string str = "123456";
+            str[3] = static_cast<char>(c);
+            bool hex = digits.find(static_cast<char>(c)) != std::string::npos && c != 0;
+            if (decode_hex_fixed(str.data(), 6, value) != hex) ++mismatches;
+        }
+        EXPECT_EQ(0, mismatches);
+    }
+    END
+
+    TEST(parse_number, parse_hex) {
+        unsigned value = 0;
+        EXPECT_TRUE(parse_hex(std::string("20212E"), value));
+        EXPECT_EQ(0x20212Eu, value);
+        EXPECT_TRUE(parse_hex(std::string(" 20212E"), value));
+        EXPECT_EQ(0x20212Eu, value);
+        EXPECT_TRUE(parse_hex(std::string("20212E zz"), value));
+        EXPECT_EQ(0x20212Eu, value);
+        EXPECT_TRUE(parse_hex(std::string("123456789"), value));
+        EXPECT_EQ(std::numeric_limits<unsigned>::max(), value);
+        unsigned char uc = 0;
+        EXPECT_TRUE(parse_hex(std::string("FFF"), uc));
+        EXPECT_EQ(std::numeric_limits<unsigned char>::max(), uc);
+        EXPECT_FALSE(parse_hex(std::string("zz"), value));
+        EXPECT_FALSE(parse_hex(std::string("-1"), value));
+        EXPECT_FALSE(parse_hex(std::string(""), value));
+    }
+    END
+
+    TEST(parse_number, integer_invalid) {
+        int value = 3;
+        EXPECT_FALSE(parse_integer(std::string(""), value));
+        EXPECT_FALSE(parse_integer(std::string("#"), value));
+        EXPECT_FALSE(parse_integer(std::string("-"), value));
+        EXPECT_FALSE(parse_integer(std::string("- 1"), value));
+        EXPECT_FALSE(parse_integer(std::string("+-1"), value));
+        EXPECT_EQ(3, value);
+    }
+    END
+
+    TEST(parse_number, integer_saturates) {
+        signed char sc = 0;
+        EXPECT_TRUE(parse_integer(std::string("300"), sc));
+        EXPECT_EQ(std::numeric_limits<signed char>::max(), sc);
+        EXPECT_TRUE(parse_integer(std::string("-300"), sc));
+        EXPECT_EQ(std::numeric_limits<signed char>::min(), sc);
+        EXPECT_TRUE(parse_integer(std::string("-128"), sc));
+        EXPECT_EQ(-128, sc);
+
+        long long ll = 0;
+        EXPECT_TRUE(parse_integer(std::string("-9223372036854775808"), ll));
+        EXPECT_EQ(std::numeric_limits<long long>::min(), ll);
+        EXPECT_TRUE(parse_integer(std::string("99999999999999999999999"), ll));
+        EXPECT_EQ(std::numeric_limits<long long>::max(), ll);
+        EXPECT_TRUE(parse_integer(std::string("-99999999999999999999999"), ll));
+        EXPECT_EQ(std::numeric_limits<long long>::min(), ll);
+    }
+    END
+
+    TEST(parse_number, unsigned_like_strtoull) {
+        unsigned char uc = 0;
+        EXPECT_TRUE(parse_integer(std::string("-1"), uc));
+        EXPECT_EQ(std::numeric_limits<unsigned char>::max(), uc);
+        unsigned long long ull = 0;
+        EXPECT_TRUE(parse_integer(std::string("-2"), ull));
+        EXPECT_EQ(std::numeric_limits<unsigned long long>::max() - 1, ull);
+        EXPECT_TRUE(parse_integer(std::string("-0"), ull));
+        EXPECT_EQ(0ULL, ull);
+        EXPECT_TRUE(parse_integer(std::string("18446744073709551616"), ull));
+        EXPECT_EQ(std::numeric_limits<unsigned long long>::max(), ull);
+    }
+    END
+
+    TEST(parse_number, reads_only_the_view) {
+        std::string text = "123456";
+        int value = 0;
+        EXPECT_TRUE(parse_integer(std::string_view(text.data(), 3), value));
+        EXPECT_EQ(123, value);
+        double dbl = 0;
+        EXPECT_TRUE(parse_floating(std::string_view(text.data(), 2), dbl));
+        EXPECT_DOUBLE_EQ(12.0, dbl);
+        EXPECT_FALSE(parse_floating(std::string_view(text.data(), 0), dbl));
+    }
+    END
+
+    TEST(parse_number, floating) {
+        double value = 0;
+        EXPECT_TRUE(parse_floating(std::string("4.2"), value));
+        EXPECT_DOUBLE_EQ(4.2, value);
+        EXPECT_TRUE(parse_floating(std::string(" +1e3x"), value));
+        EXPECT_DOUBLE_EQ(1000.0, value);
+        EXPECT_TRUE(parse_floating(std::string("-.5"), value));
+        EXPECT_DOUBLE_EQ(-0.5, value);
+        EXPECT_TRUE(parse_floating(std::string("0x1p4"), value));
+        EXPECT_DOUBLE_EQ(16.0, value);
+        EXPECT_TRUE(parse_floating(std::string("0xg"), value));
+        EXPECT_DOUBLE_EQ(0.0, value);
+        EXPECT_TRUE(parse_floating(std::string("-inf"), value));
+        EXPECT_TRUE(std::isinf(value) && value < 0);
+        EXPECT_TRUE(parse_floating(std::string("nan"), value));
+        EXPECT_TRUE(std::isnan(value));
+        EXPECT_FALSE(parse_floating(std::string("#"), value));
+        EXPECT_FALSE(parse_floating(std::string("+-1"), value));
+        EXPECT_FALSE(parse_floating(std::string("- 1"), value));
+    }
+    END
+
+    TEST(parse_number, floating_rounds_like_strtod) {
+        EXPECT_EQ(0, rounding_mismatches<float>());
+        EXPECT_EQ(0, rounding_mismatches<double>());
+        EXPECT_EQ(0, rounding_mismatches<long double>());
+
+        double value = 0;
+        EXPECT_TRUE(parse_floating(std::string("9007199254740993"), value)); // 2^53 + 1, a tie
+        EXPECT_EQ(std::strtod("9007199254740993", nullptr), value);
+        EXPECT_TRUE(parse_floating(std::string("2.2250738585072011e-308"), value)); // subnormal
+        EXPECT_EQ(std::strtod("2.2250738585072011e-308", nullptr), value);
+        EXPECT_TRUE(parse_floating(std::string("1.7976931348623157e308"), value));
+        EXPECT_EQ(std::numeric_limits<double>::max(), value);
+        EXPECT_TRUE(parse_floating(std::string("123456789012345678901234567890e-10"), value)); // truncated
+        EXPECT_EQ(std::strtod("123456789012345678901234567890e-10", nullptr), value);
+        EXPECT_TRUE(parse_floating(std::string("1e+-5"), value));
+        EXPECT_DOUBLE_EQ(1.0, value);
+        EXPECT_TRUE(parse_floating(std::string("2.5e"), value));
+        EXPECT_DOUBLE_EQ(2.5, value);
+    }
+    END
+
+    TEST(parse_number, floating_saturates) {
+        float value = 0;
+        EXPECT_TRUE(parse_floating(std::string("1e40"), value));
+        EXPECT_TRUE(std::isinf(value) && value > 0);
+        EXPECT_TRUE(parse_floating(std::string("-123.5e60"), value));
+        EXPECT_TRUE(std::isinf(value) && value < 0);
+        EXPECT_TRUE(parse_floating(std::string("1e-60"), value));
+        EXPECT_EQ(0.0f, value);
+        EXPECT_TRUE(parse_floating(std::string("0.00001e-50"), value));
+        EXPECT_EQ(0.0f, value);
+    }
+    END
+
+    TEST(parse_number, floating_subnormal) {
+        long double ldbl = 0;
+        for (const char* str : {"3.6e-4951", "21705754.44592431370710752800e-4957", "-3.6e-4951"}) {
+            EXPECT_TRUE(parse_floating(std::string(str), ldbl));
+            EXPECT_TRUE(ldbl != 0);
+            EXPECT_EQ(ldbl, strto<long double>(str));
+        }
+        double dbl = 0;
+        EXPECT_TRUE(parse_floating(std::string("4.9406564584124654e-324"), dbl));
+        EXPECT_EQ(dbl, std::numeric_limits<double>::denorm_min());
+        float flt = 0;
+        EXPECT_TRUE(parse_floating(std::string("1.5e-45"), flt));
+        EXPECT_EQ(flt, std::numeric_limits<float>::denorm_min());
+        EXPECT_TRUE(parse_floating(std::string("1e-4000"), dbl));
+        EXPECT_EQ(0.0, dbl);
+    }
+    END
+
+    TEST(parse_number, floating_long_mantissa) {
+        auto str = "0." + std::string(200, '0') + "1e201";
+        double dbl = 0;
+        EXPECT_TRUE(parse_floating(str, dbl));
+        EXPECT_EQ(dbl, 1.0);
+        auto digits = "1." + std::string(300, '0') + "1e-4950";
+        long double ldbl = 0;
+        EXPECT_TRUE(parse_floating(digits, ldbl));
+        EXPECT_EQ(ldbl, strto<long double>(digits.c_str()));
+    }
+    END
+}
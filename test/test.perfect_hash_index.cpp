@@ -0,0 +1,94 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.perfect_hash_index.cpp
+ * \brief Test functions for the perfect_hash_index class
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "perfect_hash_index.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+void
+test_perfect_hash_index() {
+    TEST(perfect_hash_index, empty) {
+        perfect_hash_index sut;
+        auto key_at = [](std::size_t) { return std::string_view(); };
+        EXPECT_TRUE(sut.build(0, key_at).empty());
+        EXPECT_EQ(sut.find("key", key_at), perfect_hash_index::npos);
+        EXPECT_EQ(sut.find("", key_at), perfect_hash_index::npos);
+    }
+    END
+
+    TEST(perfect_hash_index, find) {
+        std::vector<std::string> sorted;
+        for (int i = 0; i < 5000; ++i) sorted.push_back("key" + std::to_string(i));
+        std::sort(sorted.begin(), sorted.end());
+
+        perfect_hash_index sut;
+        auto order = sut.build(sorted.size(), [&sorted](std::size_t idx) { return std::string_view(sorted[idx]); });
+        EXPECT_EQ(order.size(), sorted.size());
+
+        // the order is a permutation
+        auto check = order;
+        std::sort(check.begin(), check.end());
+        for (std::size_t i = 0; i < check.size(); ++i) EXPECT_EQ(check[i], i);
+
+        std::vector<std::string> stored;
+        for (auto idx : order) stored.push_back(sorted[idx]);
+        auto key_at = [&stored](std::size_t idx) { return std::string_view(stored[idx]); };
+        for (std::size_t i = 0; i < stored.size(); ++i) {
+            EXPECT_EQ(sut.find(stored[i], key_at), i);
+        }
+        for (int i = 5000; i < 10000; ++i) {
+            EXPECT_EQ(sut.find("key" + std::to_string(i), key_at), perfect_hash_index::npos);
+        }
+        EXPECT_EQ(sut.find("", key_at), perfect_hash_index::npos);
+
+        // a few bits per key
+        EXPECT_TRUE(sut.memory_usage() * 8 < sorted.size() * 8);
+    }
+    END
+}
@@ -0,0 +1,113 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.scanner.cpp
+ * \brief Test functions for the vectorized scanning functions
+ */
+
+#include <cctype>
+#include <string>
+
+#include "scanner.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+namespace {
+    const char*
+    reference_newline(const char* first, const char* last) {
+        while (first != last && *first != '\n') ++first;
+        return first;
+    }
+
+    const char*
+    reference_non_alnum(const char* first, const char* last) {
+        while (first != last && std::isalnum(static_cast<unsigned char>(*first))) ++first;
+        return first;
+    }
+}
+
+void
+test_scanner() {
+    TEST(scanner, empty) {
+        const char* buf = "";
+        EXPECT_TRUE(scan_newline(buf, buf) == buf);
+        EXPECT_TRUE(scan_non_alnum(buf, buf) == buf);
+    }
+    END
+
+    TEST(scanner, newline_positions) {
+        // covers the vector blocks, and the scalar tails of both vector widths
+        for (std::size_t len = 0; len < 100; ++len) {
+            for (std::size_t pos = 0; pos <= len; ++pos) {
+                std::string buf(len, 'a');
+                if (pos < len) buf[pos] = '\n';
+                auto first = buf.data();
+                auto last = buf.data() + buf.size();
+                EXPECT_TRUE(scan_newline(first, last) == reference_newline(first, last));
+            }
+        }
+    }
+    END
+
+    TEST(scanner, non_alnum_positions) {
+        for (std::size_t len = 0; len < 100; ++len) {
+            for (std::size_t pos = 0; pos <= len; ++pos) {
+                std::string buf;
+                for (std::size_t i = 0; i < len; ++i) {
+                    buf.push_back("aZ09xy"[i % 6]);
+                }
+                if (pos < len) buf[pos] = '=';
+                auto first = buf.data();
+                auto last = buf.data() + buf.size();
+                EXPECT_TRUE(scan_non_alnum(first, last) == reference_non_alnum(first, last));
+            }
+        }
+    }
+    END
+
+    TEST(scanner, alnum_classes) {
+        // every byte value at every lane of a 32 byte block
+        for (int c = 0; c < 256; ++c) {
+            for (std::size_t pos = 0; pos < 32; ++pos) {
+                std::string buf(48, 'k');
+                buf[pos] = static_cast<char>(c);
+                auto first = buf.data();
+                auto last = buf.data() + buf.size();
+                EXPECT_TRUE(scan_non_alnum(first, last) == reference_non_alnum(first, last));
+                EXPECT_TRUE(scan_newline(first, last) == reference_newline(first, last));
+            }
+        }
+    }
+    END
+}
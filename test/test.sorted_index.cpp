@@ -0,0 +1,98 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.sorted_index.cpp
+ * \brief Test functions for the sorted_index class
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "sorted_index.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+void
+test_sorted_index() {
+    TEST(sorted_index, empty) {
+        sorted_index sut;
+        auto key_at = [](std::size_t) { return std::string_view(); };
+        EXPECT_TRUE(sut.build(0, key_at).empty());
+        EXPECT_EQ(sut.find("key", key_at), sorted_index::npos);
+    }
+    END
+
+    TEST(sorted_index, find) {
+        std::vector<std::string> keys{"a", "b", "key", "key2", "other"};
+        auto key_at = [&keys](std::size_t idx) { return std::string_view(keys[idx]); };
+        sorted_index sut;
+        EXPECT_TRUE(sut.build(keys.size(), key_at).empty());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(sut.find(keys[i], key_at), i);
+        }
+        for (auto&& absent : {""s, "0"s, "c"s, "key1"s, "zzz"s}) {
+            EXPECT_EQ(sut.find(absent, key_at), sorted_index::npos);
+        }
+    }
+    END
+
+    TEST(sorted_index, find_many) {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 1000; ++i) keys.push_back("key" + std::to_string(i));
+        std::sort(keys.begin(), keys.end());
+        auto key_at = [&keys](std::size_t idx) { return std::string_view(keys[idx]); };
+        sorted_index sut;
+        sut.build(keys.size(), key_at);
+
+        std::vector<std::string> names;
+        for (int i = 0; i < 1500; ++i) names.push_back("key" + std::to_string(i * 7 % 1500));
+        names.push_back("");
+        names.push_back("zzz");
+        std::vector<std::string_view> probes(names.begin(), names.end());
+        std::vector<std::size_t> out(probes.size());
+        sut.find_many(probes.data(), probes.size(), out.data(), key_at);
+        for (std::size_t i = 0; i < probes.size(); ++i) {
+            EXPECT_EQ(out[i], sut.find(probes[i], key_at));
+        }
+    }
+    END
+}
@@ -0,0 +1,135 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.source_buffer.cpp
+ * \brief Test functions for the source_buffer class
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "source_buffer.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+void
+test_source_buffer() {
+    TEST(source_buffer, static_checks) {
+        EXPECT_TRUE((std::is_nothrow_move_constructible<source_buffer>::value) );
+        EXPECT_FALSE((std::is_copy_constructible<source_buffer>::value) );
+    }
+    END
+
+    TEST(source_buffer, no_file) {
+        EXPECT_THROW(source_buffer("-invalid-"), const std::invalid_argument&);
+        EXPECT_THROW(source_buffer("."), const std::invalid_argument&);
+    }
+    END
+
+    TEST(source_buffer, empty) {
+        source_buffer sut;
+        EXPECT_EQ(sut.size(), std::size_t{});
+        EXPECT_EQ(sut.data()[0], '\0');
+
+        source_buffer file("empty1.confy");
+        EXPECT_EQ(file.size(), std::size_t{});
+        EXPECT_EQ(file.data()[0], '\0');
+    }
+    END
+
+    TEST(source_buffer, contents) {
+        source_buffer sut("ints.confy");
+        EXPECT_EQ(sut.size(), std::size_t{31});
+        EXPECT_TRUE(sut.view().substr(0, 6) == "key=1\n");
+        EXPECT_EQ(sut.data()[sut.size()], '\0');
+        EXPECT_EQ(std::strlen(sut.data()), sut.size());
+    }
+    END
+
+    TEST(source_buffer, stream) {
+        std::istringstream ss("key=1\nother=2");
+        source_buffer sut(ss);
+        EXPECT_FALSE(sut.mapped());
+        EXPECT_EQ(sut.size(), std::size_t{13});
+        EXPECT_TRUE(sut.view() == "key=1\nother=2");
+        EXPECT_EQ(sut.data()[sut.size()], '\0');
+    }
+    END
+
+    TEST(source_buffer, read) {
+        auto sut = source_buffer::read("ints.confy");
+        EXPECT_FALSE(sut.mapped());
+        EXPECT_EQ(sut.size(), std::size_t{31});
+        EXPECT_TRUE(sut.view() == source_buffer("ints.confy").view());
+        EXPECT_EQ(sut.data()[sut.size()], '\0');
+        EXPECT_THROW(source_buffer::read("-invalid-"), const std::invalid_argument&);
+    }
+    END
+
+    TEST(source_buffer, private_writes) {
+        {
+            source_buffer sut("ints.confy");
+            sut.data()[0] = 'X';
+            sut.data()[sut.size()] = 'X';
+        }
+        source_buffer sut("ints.confy");
+        EXPECT_EQ(sut.data()[0], 'k');
+        EXPECT_EQ(sut.data()[sut.size()], '\0');
+    }
+    END
+
+    TEST(source_buffer, move) {
+        source_buffer sut("ints.confy");
+        auto data = sut.data();
+
+        source_buffer moved(std::move(sut));
+        EXPECT_TRUE(moved.data() == data);
+        EXPECT_EQ(moved.size(), std::size_t{31});
+
+        source_buffer assigned;
+        assigned = std::move(moved);
+        EXPECT_TRUE(assigned.data() == data);
+        EXPECT_EQ(assigned.size(), std::size_t{31});
+    }
+    END
+}
@@ -0,0 +1,100 @@
+/* -- confy project --
+ *
+ * Copyright (c) 2022 András Bodor <bodand@pm.me>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name of the copyright holder nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file test.swiss_index.cpp
+ * \brief Test functions for the swiss_index class
+ */
+
+#ifdef CPORTA
+#  ifndef USE_CXX17
+#    define USE_CXX17
+#  endif
+#endif
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "swiss_index.hpp"
+
+using namespace std::literals;
+
+#include "gtest_lite.h"
+
+void
+test_swiss_index() {
+    TEST(swiss_index, empty) {
+        swiss_index sut;
+        auto key_at = [](std::size_t) { return std::string_view(); };
+        EXPECT_EQ(sut.find("key", key_at), swiss_index::npos);
+        EXPECT_TRUE(sut.build(0, key_at).empty());
+        EXPECT_EQ(sut.find("key", key_at), swiss_index::npos);
+        EXPECT_EQ(sut.find("", key_at), swiss_index::npos);
+    }
+    END
+
+    TEST(swiss_index, build) {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 5000; ++i) keys.push_back("key" + std::to_string(i));
+        auto key_at = [&keys](std::size_t idx) { return std::string_view(keys[idx]); };
+
+        swiss_index sut;
+        EXPECT_TRUE(sut.build(keys.size(), key_at).empty());
+        EXPECT_EQ(sut.size(), keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(sut.find(keys[i], key_at), i);
+        }
+        for (int i = 5000; i < 10000; ++i) {
+            EXPECT_EQ(sut.find("key" + std::to_string(i), key_at), swiss_index::npos);
+        }
+        EXPECT_TRUE(sut.memory_usage() <= keys.size() * 2 * 5);
+    }
+    END
+
+    TEST(swiss_index, insert) {
+        std::vector<std::string> keys;
+        auto key_at = [&keys](std::size_t idx) { return std::string_view(keys[idx]); };
+
+        swiss_index sut;
+        for (int i = 0; i < 3000; ++i) {
+            keys.push_back("key" + std::to_string(i));
+            sut.insert(keys.size() - 1, key_at);
+            EXPECT_EQ(sut.find(keys.back(), key_at), keys.size() - 1);
+        }
+        EXPECT_EQ(sut.size(), keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(sut.find(keys[i], key_at), i);
+        }
+        EXPECT_EQ(sut.find("key3000", key_at), swiss_index::npos);
+    }
+    END
+}
@@ -34,7 +34,9 @@
  * \brief Test functions for the type_id classes
  */
 
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include "gtest_lite.h"
 #include "type_id.hpp"
@@ -71,6 +73,30 @@ test_type_id() {
     }
     END
 
+    TEST(type_id, compile_time) {
+        constexpr auto tid = type_id::id_of<T>();
+        constexpr bool same = tid == type_id::id_of<T>();
+        constexpr bool different = tid != type_id::id_of<U>();
+        EXPECT_TRUE(same);
+        EXPECT_TRUE(different);
+    }
+    END
+
+    TEST(type_id, threads) {
+        struct first_seen_in_thread { };
+        std::vector<int> matches(4, 0);
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < matches.size(); ++i) {
+            threads.emplace_back([&matches, i] {
+                matches[i] = type_id::id_of<first_seen_in_thread>() != type_id::id_of<T>();
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        for (std::size_t i = 0; i < matches.size(); ++i) EXPECT_EQ(matches[i], 1);
+        EXPECT_TRUE(type_id::id_of<first_seen_in_thread>() == type_id::id_of<first_seen_in_thread>());
+    }
+    END
+
     // static checks
     TEST(type_id, static_checks) {
 #ifndef USE_CXX17
@@ -49,20 +49,30 @@
 #  include <filesystem>
 #  include <string_view>
 #endif
+#include <fstream>
 #include <string>
 #include <type_traits>
 
 #include "bad_key.hpp"
 #include "bad_syntax.hpp"
+#include "config_image.hpp"
+#include "image_cache.hpp"
+#include "source_buffer.hpp"
 #include "user_modes.hpp"
 
 using namespace std::literals;
 
 #include "capture_stdio.hpp"
+#include "scoped_env.hpp"
 #include "gtest_lite.h"
 
 void
 test_user_modes() {
+    // the cached images of the test inputs are kept out of the cache of the user
+    auto cache_dir = std::filesystem::temp_directory_path() / "confy-test-modes-cache";
+    scoped_env cache_home("XDG_CACHE_HOME", cache_dir.string().c_str());
+    scoped_env cache_on("CONFY_NO_CACHE", nullptr);
+
     TEST(user_modes, inter_invalid_file) {
         EXPECT_THROW(interactive_mode("-invalid-"), const std::invalid_argument&);
     }
@@ -312,4 +322,111 @@ test_user_modes() {
         }
     }
     END
+
+    TEST(user_modes, compiled_image) {
+        for (auto&& data : {
+                    std::make_tuple("bare_words.confy"s, "bare"s, "word"s),
+                    std::make_tuple("double-strings.confy"s, "some"s, "have space"s),
+                    std::make_tuple("ints.confy"s, "1"s, "2"s),
+                    std::make_tuple("mixed.confy"s, "nothing"s, "tests"s),
+                    std::make_tuple("single-strings.confy"s, "some"s, "have space"s),
+             }) {
+            auto&& file = std::get<0>(data);
+            auto&& key1 = std::get<1>(data);
+            auto&& key2 = std::get<2>(data);
+            int r;
+            EXPECT_NO_THROW(r = compile_mode(file, "compiled.confyb"));
+            EXPECT_EQ(r, 0);
+
+            auto written = capture_stream<&std::cout>([] {
+                std::vector<std::string_view> keys{"key", "key2"};
+                EXPECT_EQ(cli_mode("compiled.confyb", keys), 0);
+            });
+            EXPECT_EQ(written, key1 + "\n" + key2 + "\n");
+
+            written = capture_stream<&std::cout>([] {
+                feed_stream<&std::cin>("key2\nkey\nerroneous\n", [] {
+                    EXPECT_THROW(interactive_mode("compiled.confyb"), const std::out_of_range&);
+                });
+            });
+            EXPECT_EQ(written, key2 + "\n" + key1 + "\n");
+        }
+        EXPECT_THROW(compile_mode("broken1.confy", "compiled.confyb"), const bad_syntax&);
+        std::filesystem::remove("compiled.confyb");
+    }
+    END
+
+    TEST(user_modes, compile_command) {
+        const char* compile_args[] = {"confy", "--compile", "ints.confy", "compiled.confyb"};
+        EXPECT_TRUE(is_compile_mode(4, compile_args));
+        EXPECT_FALSE(is_compile_mode(3, compile_args));
+        const char* cli_args[] = {"confy", "ints.confy", "key", "key2"};
+        EXPECT_FALSE(is_compile_mode(4, cli_args));
+
+        // a configuration file named compile is read as before, whether or not it exists
+        const char* file_args[] = {"confy", "compile", "k1", "k2"};
+        EXPECT_FALSE(is_compile_mode(4, file_args));
+        {
+            std::ofstream ofs("compile");
+            ofs << "k1=first\nk2=second\n";
+        }
+        EXPECT_FALSE(is_compile_mode(4, file_args));
+        auto written = capture_stream<&std::cout>([] {
+            std::vector<std::string_view> keys{"k1", "k2"};
+            EXPECT_EQ(cli_mode("compile", keys), 0);
+        });
+        EXPECT_EQ(written, "first\nsecond\n"s);
+        EXPECT_FALSE(std::filesystem::exists("k2"));
+        std::filesystem::remove("compile");
+    }
+    END
+
+    TEST(user_modes, cached_image) {
+        std::filesystem::remove_all(cache_dir);
+        for (int run = 0; run < 2; ++run) {
+            auto written = capture_stream<&std::cout>([] {
+                std::vector<std::string_view> keys{"key", "key2"};
+                EXPECT_EQ(cli_mode("mixed.confy", keys), 0);
+            });
+            EXPECT_EQ(written, "nothing\ntests\n");
+            EXPECT_TRUE(std::filesystem::exists(image_cache("mixed.confy").image()));
+
+            written = capture_stream<&std::cout>([] {
+                feed_stream<&std::cin>("key2\n", [] {
+                    EXPECT_EQ(interactive_mode("mixed.confy"), 0);
+                });
+            });
+            EXPECT_EQ(written, "tests\n");
+        }
+
+        // a damaged cache is replaced, not trusted
+        {
+            std::ofstream ofs(image_cache("mixed.confy").image(), std::ios::binary | std::ios::trunc);
+            ofs << "garbage";
+        }
+        auto written = capture_stream<&std::cout>([] {
+            std::vector<std::string_view> keys{"key"};
+            EXPECT_EQ(cli_mode("mixed.confy", keys), 0);
+        });
+        EXPECT_EQ(written, "nothing\n");
+        EXPECT_TRUE(is_config_image(image_cache("mixed.confy").image()));
+
+        // so is a cache with a valid header, but a reference out of the image
+        {
+            std::fstream fs(image_cache("mixed.confy").image(), std::ios::binary | std::ios::in | std::ios::out);
+            fs.seekp(104 + 4);
+            fs.write("\xff\xff\xff\x7f", 4);
+        }
+        written = capture_stream<&std::cout>([] {
+            std::vector<std::string_view> keys{"key"};
+            EXPECT_EQ(cli_mode("mixed.confy", keys), 0);
+        });
+        EXPECT_EQ(written, "nothing\n");
+        {
+            source_buffer buf(image_cache("mixed.confy").image());
+            EXPECT_NO_THROW(open_config_image(buf, image_cache("mixed.confy").image(), true));
+        }
+        std::filesystem::remove_all(cache_dir);
+    }
+    END
 }
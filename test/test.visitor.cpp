@@ -46,8 +46,11 @@
 #else
 #  include <filesystem>
 #endif
+#include <cstddef>
 #include <exception>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include "visitor.hpp"
 
@@ -97,6 +100,68 @@ namespace {
         int derived_2 = 0;
         int derived_3 = 0;
     };
+
+    struct table_visitor : visitor<derived1, derived2> {
+        void
+        do_visit(derived1&) final { }
+        void
+        do_visit(derived2&) final { }
+
+        template<class T>
+        static bool
+        dispatched() {
+            auto idx = visit_index<T>;
+            return idx < dispatch_size && _dispatch[idx].load() != nullptr;
+        }
+
+        template<class T>
+        static bool
+        fits() { return visit_index<T> < dispatch_size; }
+    };
+
+    template<template<class...> class V, class... Ts>
+    struct counting_base : V<Ts...> {
+        std::size_t hits = 0;
+    };
+
+    template<class Base, class... Ts>
+    struct counting_layers;
+
+    template<class Base>
+    struct counting_layers<Base> : Base { };
+
+    template<class Base, class T, class... Rem>
+    struct counting_layers<Base, T, Rem...> : counting_layers<Base, Rem...> {
+        void
+        do_visit(T&) final { ++this->hits; }
+    };
+
+    template<class... Ts>
+    using counting_visitor = counting_layers<counting_base<visitor, Ts...>, Ts...>;
+
+    template<std::size_t I>
+    struct numbered : base_type {
+        void
+        accept(visitor_base& v) override { v.visit(this); }
+    };
+
+    template<class Seq>
+    struct numbered_types;
+
+    template<std::size_t... Is>
+    struct numbered_types<std::index_sequence<Is...>> {
+        using visitor_type = counting_visitor<numbered<Is>...>;
+
+        static std::size_t
+        visit_all(base_type& other) {
+            std::tuple<numbered<Is>...> objs;
+            visitor_type vtor;
+            int expand[] = {0, (std::get<numbered<Is>>(objs).accept(vtor), 0)...};
+            (void) expand;
+            other.accept(vtor);
+            return vtor.hits;
+        }
+    };
 }
 
 void
@@ -150,4 +215,27 @@ test_visitors() {
         vtor.reset();
     }
     END
+
+    TEST(visitor, table_fills_on_visit) {
+        // the table is not built up front, but filled by the visits, whenever the indices are assigned
+        table_visitor vtor;
+        EXPECT_FALSE(table_visitor::dispatched<derived1>());
+        derived1 der1;
+        der1.accept(vtor);
+        EXPECT_EQ(table_visitor::dispatched<derived1>(), table_visitor::fits<derived1>());
+        EXPECT_FALSE(table_visitor::dispatched<derived2>());
+        der1.accept(vtor);
+        derived2 der2;
+        der2.accept(vtor);
+        EXPECT_EQ(table_visitor::dispatched<derived2>(), table_visitor::fits<derived2>());
+    }
+    END
+
+    TEST(visitor, visit_past_table) {
+        // more types than the dispatch tables hold, some are visited by linear search
+        using types = numbered_types<std::make_index_sequence<visitor_base::dispatch_size + 8>>;
+        derived1 der1;
+        EXPECT_EQ(visitor_base::dispatch_size + 8, types::visit_all(der1));
+    }
+    END
 }
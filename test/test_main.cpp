@@ -57,12 +57,40 @@ test_bad_syntax();
 void
 test_caches();
 void
+test_cache_table();
+void
 test_cached_cache_factory();
 void
+test_config_image();
+void
 test_config_set();
 void
+test_config_snapshots();
+void
+test_config_watch();
+void
 test_confy_parser();
 void
+test_eytzinger_index();
+void
+test_image_cache();
+void
+test_inline_cache();
+void
+test_key_hash();
+void
+test_parse_number();
+void
+test_perfect_hash_index();
+void
+test_scanner();
+void
+test_sorted_index();
+void
+test_source_buffer();
+void
+test_swiss_index();
+void
 test_type_id();
 void
 test_uncached_cache_factory();
@@ -76,9 +104,23 @@ test_main() {
     test_bad_key();
     test_bad_syntax();
     test_caches();
+    test_cache_table();
     test_cached_cache_factory();
+    test_config_image();
     test_config_set();
+    test_config_snapshots();
+    test_config_watch();
     test_confy_parser();
+    test_eytzinger_index();
+    test_image_cache();
+    test_inline_cache();
+    test_key_hash();
+    test_parse_number();
+    test_perfect_hash_index();
+    test_scanner();
+    test_sorted_index();
+    test_source_buffer();
+    test_swiss_index();
     test_type_id();
     test_uncached_cache_factory();
     test_user_modes();